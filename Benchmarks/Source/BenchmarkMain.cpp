@@ -0,0 +1,247 @@
+/*
+  ==============================================================================
+
+    BenchmarkMain.cpp
+
+    Generates a synthetic WAV corpus and times the metadata reader over it,
+    so parser regressions show up before they reach a full ingest run.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SyntheticWavWriter.h"
+#include "../../Source/WavMetadataReader.h"
+#include "../../Source/MetadataCache.h"
+#include "../../Source/XmlTextScanner.h"
+
+namespace
+{
+    //==============================================================================
+    struct Timings
+    {
+        juce::Array<double> seconds;
+        juce::int64 totalBytes = 0;
+
+        double percentile(double fraction) const
+        {
+            if (seconds.isEmpty())
+                return 0.0;
+
+            auto sorted = seconds;
+            sorted.sort();
+            auto index = juce::jlimit(0, sorted.size() - 1, (int) std::ceil(fraction * sorted.size()) - 1);
+            return sorted[index];
+        }
+
+        double total() const
+        {
+            double sum = 0.0;
+
+            for (auto s : seconds)
+                sum += s;
+
+            return sum;
+        }
+    };
+
+    void printHeader()
+    {
+        std::cout << juce::String("pass").paddedRight(' ', 24)
+                  << juce::String("files/s").paddedLeft(' ', 12)
+                  << juce::String("MB/s").paddedLeft(' ', 12)
+                  << juce::String("p50 ms").paddedLeft(' ', 10)
+                  << juce::String("p99 ms").paddedLeft(' ', 10) << "\n";
+    }
+
+    void printRow(const juce::String& label, const Timings& timings)
+    {
+        auto total = juce::jmax(1.0e-9, timings.total());
+
+        std::cout << label.paddedRight(' ', 24)
+                  << juce::String(timings.seconds.size() / total, 1).paddedLeft(' ', 12)
+                  << juce::String((double) timings.totalBytes / (1024.0 * 1024.0) / total, 1).paddedLeft(' ', 12)
+                  << juce::String(timings.percentile(0.5) * 1000.0, 3).paddedLeft(' ', 10)
+                  << juce::String(timings.percentile(0.99) * 1000.0, 3).paddedLeft(' ', 10) << "\n";
+    }
+
+    /* Times one call per file. */
+    template <typename Function>
+    Timings timeEachFile(const juce::Array<juce::File>& files, Function&& function)
+    {
+        Timings timings;
+
+        for (const auto& file : files)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+            function(file);
+            auto end = juce::Time::getHighResolutionTicks();
+
+            timings.seconds.add(juce::Time::highResolutionTicksToSeconds(end - start));
+            timings.totalBytes += file.getSize();
+        }
+
+        return timings;
+    }
+
+    juce::String getOptionValue(const juce::ArgumentList& args, juce::StringRef option, const juce::String& defaultValue)
+    {
+        auto index = args.indexOfOption(option);
+
+        if (index >= 0 && index + 1 < args.size() && ! args[index + 1].isOption())
+            return args[index + 1].text;
+
+        return defaultValue;
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: ParseBenchmark [options]\n"
+                     "  --files N        number of files to generate (default 200)\n"
+                     "  --data-mb N      size of each data chunk in MB (default 64)\n"
+                     "  --ixml-kb N      size of each iXML payload in KB (default 8)\n"
+                     "  --chunks N       odd-sized padding chunks per file (default 4)\n"
+                     "  --passes N       warm passes per strategy (default 3)\n"
+                     "  --rf64           write RF64 files\n"
+                     "  --ixml-first     put iXML before the data chunk instead of after\n"
+                     "  --dir PATH       where to write the corpus (default: a temp folder)\n"
+                     "  --keep           don't delete the corpus afterwards (only the files\n"
+                     "                   the benchmark wrote are ever deleted)\n"
+                     "\n"
+                     "MB/s is logical file size over time, i.e. how much audio is being\n"
+                     "catalogued per second, not how many bytes were actually read.\n";
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    auto numFiles = getOptionValue(args, "--files", "200").getIntValue();
+    auto numPasses = juce::jmax(1, getOptionValue(args, "--passes", "3").getIntValue());
+
+    SyntheticWavWriter::Options options;
+    options.dataSize = getOptionValue(args, "--data-mb", "64").getLargeIntValue() * 1024 * 1024;
+    options.ixmlSize = getOptionValue(args, "--ixml-kb", "8").getIntValue() * 1024;
+    options.numPaddingChunks = getOptionValue(args, "--chunks", "4").getIntValue();
+    options.rf64 = args.containsOption("--rf64");
+    options.ixmlAfterData = ! args.containsOption("--ixml-first");
+
+    auto corpusDir = args.containsOption("--dir")
+                   ? juce::File::getCurrentWorkingDirectory().getChildFile(getOptionValue(args, "--dir", {}))
+                   : juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("iXMLViewerBenchmark");
+
+    // --dir may name a folder with other things in it, so only what's written
+    // here is deleted afterwards, and the folder only if this made it.
+    auto createdCorpusDir = ! corpusDir.exists();
+
+    if (! corpusDir.createDirectory())
+    {
+        std::cerr << "Error: could not create " << corpusDir.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    // --- Generate the corpus ---
+    juce::Random random(42);
+    juce::Array<juce::File> files;
+
+    for (int i = 0; i < numFiles; ++i)
+    {
+        auto file = corpusDir.getChildFile("take_" + juce::String(i).paddedLeft('0', 6) + ".wav");
+
+        if (! SyntheticWavWriter::write(file, options, random))
+        {
+            std::cerr << "Error: could not write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        files.add(file);
+    }
+
+    std::cout << "Corpus: " << numFiles << " files, "
+              << (options.dataSize >> 20) << " MB data, "
+              << (options.ixmlSize >> 10) << " KB iXML "
+              << (options.ixmlAfterData ? "after" : "before") << " data, "
+              << options.numPaddingChunks << " padding chunks"
+              << (options.rf64 ? ", RF64" : "") << "\n"
+              << "iXML text scan: " << (XmlTextScanner::isVectorised() ? "SIMD" : "scalar") << "\n\n";
+
+    printHeader();
+
+    // --- Parse passes ---
+    // The first pass after writing the corpus is as cold as we can make it
+    // portably; the OS may still have the headers cached from the writes.
+    const std::pair<const char*, WavMetadataReader::Strategy> strategies[] =
+    {
+        { "tail-first", WavMetadataReader::Strategy::tailFirst },
+        { "mapped",     WavMetadataReader::Strategy::mapped }
+    };
+
+    int failures = 0;
+
+    for (const auto& [name, strategy] : strategies)
+    {
+        auto parse = [&, strategy = strategy](const juce::File& file)
+            {
+                if (WavMetadataReader::read(file, strategy).status.failed())
+                    ++failures;
+            };
+
+        printRow(juce::String(name) + " cold", timeEachFile(files, parse));
+
+        Timings warm;
+
+        for (int pass = 0; pass < numPasses; ++pass)
+        {
+            auto timings = timeEachFile(files, parse);
+            warm.seconds.addArray(timings.seconds);
+            warm.totalBytes += timings.totalBytes;
+        }
+
+        printRow(juce::String(name) + " warm", warm);
+    }
+
+    // --- Cache hits ---
+    auto cacheFile = corpusDir.getChildFile("benchmark.cache");
+    MetadataCache cache(cacheFile);
+
+    for (const auto& file : files)
+    {
+        // Stamped first, as argument order isn't defined.
+        auto stamp = MetadataCache::Stamp::of(file);
+        cache.store(file, stamp, WavMetadataReader::read(file));
+    }
+
+    printRow("cache hit", timeEachFile(files, [&cache](const juce::File& file)
+        {
+            WavMetadata metadata;
+            cache.lookup(file, metadata);
+        }));
+
+    if (! args.containsOption("--keep"))
+    {
+        for (const auto& file : files)
+            file.deleteFile();
+
+        for (const auto& extension : { "cache", "index", "journal" })
+            cacheFile.withFileExtension(extension).deleteFile();
+
+        if (createdCorpusDir && corpusDir.getNumberOfChildFiles(juce::File::findFilesAndDirectories) == 0)
+            corpusDir.deleteFile();
+    }
+
+    if (failures > 0)
+    {
+        std::cerr << "\n" << failures << " parses failed." << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    SyntheticWavWriter.cpp
+
+  ==============================================================================
+*/
+
+#include "SyntheticWavWriter.h"
+
+namespace
+{
+    void writeChunk(juce::OutputStream& out, const char* id, const void* data, size_t size)
+    {
+        out.write(id, 4);
+        out.writeInt((int) size);
+        out.write(data, size);
+
+        // RIFF chunks are padded to be an even number of bytes.
+        if ((size & 1) != 0)
+            out.writeByte(0);
+    }
+
+    void writeFixedString(juce::MemoryOutputStream& out, const juce::String& text, size_t fieldSize)
+    {
+        auto numBytes = juce::jmin(text.getNumBytesAsUTF8(), fieldSize);
+        out.write(text.toRawUTF8(), numBytes);
+        out.writeRepeatedByte(0, fieldSize - numBytes);
+    }
+}
+
+//==============================================================================
+juce::String SyntheticWavWriter::createIxml(const Options& options, juce::Random& random)
+{
+    juce::String xml;
+    xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<BWFXML>\n"
+        << "  <IXML_VERSION>2.10</IXML_VERSION>\n"
+        << "  <PROJECT>Benchmark</PROJECT>\n"
+        << "  <SCENE>" << (random.nextInt(200) + 1) << "A</SCENE>\n"
+        << "  <TAKE>" << (random.nextInt(20) + 1) << "</TAKE>\n"
+        << "  <TAPE>" << juce::Time::getCurrentTime().formatted("%y%m%d") << "</TAPE>\n"
+        << "  <TRACK_LIST>\n"
+        << "    <TRACK_COUNT>" << options.numChannels << "</TRACK_COUNT>\n";
+
+    for (int i = 1; i <= options.numChannels; ++i)
+    {
+        xml << "    <TRACK>\n"
+            << "      <CHANNEL_INDEX>" << i << "</CHANNEL_INDEX>\n"
+            << "      <INTERLEAVE_INDEX>" << i << "</INTERLEAVE_INDEX>\n"
+            << "      <NAME>Track " << i << "</NAME>\n"
+            << "      <FUNCTION>MIC</FUNCTION>\n"
+            << "    </TRACK>\n";
+    }
+
+    xml << "  </TRACK_LIST>\n"
+        << "  <HISTORY>\n";
+
+    // Pad the document out to the requested size with history entries, which
+    // is what makes real-world iXML large.
+    for (int entry = 0; xml.getNumBytesAsUTF8() + 32 < (size_t) options.ixmlSize; ++entry)
+        xml << "    <ORIGINAL_FILENAME>take_" << entry << "_" << random.nextInt() << ".wav</ORIGINAL_FILENAME>\n";
+
+    xml << "  </HISTORY>\n"
+        << "</BWFXML>\n";
+
+    return xml;
+}
+
+bool SyntheticWavWriter::write(const juce::File& file, const Options& options, juce::Random& random)
+{
+    // FileOutputStream appends to existing files, so start from scratch.
+    if (! file.deleteFile())
+        return false;
+
+    juce::FileOutputStream out(file);
+
+    if (! out.openedOk())
+        return false;
+
+    // Plain RIFF sizes are 32-bit, so anything bigger needs RF64.
+    auto rf64 = options.rf64 || options.dataSize > (juce::int64) 0xfffffff0;
+
+    out.write(rf64 ? "RF64" : "RIFF", 4);
+    out.writeInt(-1);                       // Patched once the total size is known.
+    out.write("WAVE", 4);
+
+    juce::int64 ds64Offset = 0;
+
+    if (rf64)
+    {
+        // riffSize, dataSize and sampleCount, followed by an empty table.
+        ds64Offset = out.getPosition();
+        char ds64[28] = {};
+        writeChunk(out, "ds64", ds64, sizeof(ds64));
+    }
+
+    // fmt: PCM
+    {
+        auto blockAlign = options.numChannels * options.bitsPerSample / 8;
+
+        juce::MemoryOutputStream fmt;
+        fmt.writeShort(1);
+        fmt.writeShort((short) options.numChannels);
+        fmt.writeInt(options.sampleRate);
+        fmt.writeInt(options.sampleRate * blockAlign);
+        fmt.writeShort((short) blockAlign);
+        fmt.writeShort((short) options.bitsPerSample);
+        writeChunk(out, "fmt ", fmt.getData(), fmt.getDataSize());
+    }
+
+    if (options.includeBext)
+    {
+        // The full 602-byte BWF v1 layout.
+        juce::MemoryOutputStream bext;
+        writeFixedString(bext, "Synthetic benchmark take", 256);
+        writeFixedString(bext, "iXMLViewer", 32);
+        writeFixedString(bext, juce::String::toHexString(random.nextInt64()), 32);
+        writeFixedString(bext, "2026-01-01", 10);
+        writeFixedString(bext, "12:00:00", 8);
+        bext.writeInt64((juce::int64) random.nextInt(24 * 3600) * options.sampleRate);
+        bext.writeShort(1);
+        bext.writeRepeatedByte(0, 602 - bext.getDataSize());
+        writeChunk(out, "bext", bext.getData(), bext.getDataSize());
+    }
+
+    for (int i = 0; i < options.numPaddingChunks; ++i)
+    {
+        // Odd sizes, to exercise the pad byte handling.
+        auto size = (size_t) (random.nextInt(2048) * 2 + 1);
+        juce::HeapBlock<char> filler(size, true);
+        writeChunk(out, "JUNK", filler, size);
+    }
+
+    auto ixml = createIxml(options, random);
+
+    if (! options.ixmlAfterData)
+        writeChunk(out, "iXML", ixml.toRawUTF8(), ixml.getNumBytesAsUTF8());
+
+    // data: only the header is written; the payload is left as a hole.
+    out.write("data", 4);
+    out.writeInt(rf64 ? -1 : (int) (juce::uint32) options.dataSize);
+
+    if (options.dataSize > 0)
+    {
+        out.setPosition(out.getPosition() + options.dataSize - 1);
+        out.writeByte(0);
+    }
+
+    if ((options.dataSize & 1) != 0)
+        out.writeByte(0);
+
+    if (options.ixmlAfterData)
+        writeChunk(out, "iXML", ixml.toRawUTF8(), ixml.getNumBytesAsUTF8());
+
+    auto totalSize = out.getPosition();
+
+    if (rf64)
+    {
+        out.setPosition(ds64Offset + 8);
+        out.writeInt64(totalSize - 8);
+        out.writeInt64(options.dataSize);
+        out.writeInt64(options.dataSize / juce::jmax(1, options.numChannels * options.bitsPerSample / 8));
+    }
+    else
+    {
+        out.setPosition(4);
+        out.writeInt((int) (juce::uint32) (totalSize - 8));
+    }
+
+    out.flush();
+    return out.getStatus().wasOk();
+}
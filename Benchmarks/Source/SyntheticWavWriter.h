@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    SyntheticWavWriter.h
+
+    Writes BWF and RF64 files with a configurable layout for benchmarking the
+    parser. The audio is never written: the data chunk is left as a hole in
+    the file, so multi-gigabyte files are cheap to create (and sparse on
+    file systems that support it).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class SyntheticWavWriter
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        bool rf64 = false;
+        int numChannels = 8;
+        int sampleRate = 48000;
+        int bitsPerSample = 24;
+
+        juce::int64 dataSize = 1 << 20;     // Bytes of (unwritten) audio.
+        int ixmlSize = 4096;                // Approximate size of the iXML payload.
+        int numPaddingChunks = 2;           // Odd-sized filler chunks before the data.
+        bool ixmlAfterData = true;          // Where most field recorders put it.
+        bool includeBext = true;
+    };
+
+    //==============================================================================
+    /* Writes a file with the given layout, replacing any existing file. The
+       random generator varies the scene/take names and the padding sizes. */
+    static bool write(const juce::File& file, const Options& options, juce::Random& random);
+
+    /* Builds an iXML document of roughly the requested size. */
+    static juce::String createIxml(const Options& options, juce::Random& random);
+
+private:
+    //==============================================================================
+    SyntheticWavWriter() = delete;
+};
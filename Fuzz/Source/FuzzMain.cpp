@@ -0,0 +1,370 @@
+/*
+  ==============================================================================
+
+    FuzzMain.cpp
+
+    Feeds arbitrary bytes to the metadata reader and checks that however
+    corrupt they are, the reader returns in reasonable time, and without
+    memory out of proportion to the input.
+
+    Built with PARSE_FUZZER_LIBFUZZER=1, this is a libFuzzer target, and
+    libFuzzer supplies main(). With clang, from the repository root:
+
+        clang++ -std=c++17 -O1 -g -fsanitize=fuzzer,address -DPARSE_FUZZER_LIBFUZZER=1
+                -DJUCE_STANDALONE_APPLICATION=1 -IFuzz/JuceLibraryCode -I<JUCE>/modules
+                Fuzz/Source/FuzzMain.cpp Fuzz/JuceLibraryCode/include_juce_core.cpp
+                Source/ByteSource.cpp Source/RiffChunkScanner.cpp ... -o ParseFuzzer
+
+    (MSVC takes /fsanitize=address /fsanitize=fuzzer instead). AFL++ can
+    run the same target through afl-clang-fast++ and its libAFLDriver.
+    libFuzzer's own limits back up the checks made here:
+
+        ParseFuzzer -rss_limit_mb=1024 -malloc_limit_mb=256 -timeout=2 corpus/
+
+    Built without it, as the Projucer project is, main() replays a corpus
+    or a folder of real WAV files through the same reader the ingest
+    workers use. It reports time per input and the slowest inputs, and
+    fails if any input breaks a bound. "--make-seeds <dir>" writes a small
+    seed corpus.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include "../../Source/WavMetadataReader.h"
+#include "../../Source/RiffChunkScanner.h"
+
+#if ! PARSE_FUZZER_LIBFUZZER
+ #include "../../Benchmarks/Source/SyntheticWavWriter.h"
+#endif
+
+namespace
+{
+    //==============================================================================
+    /* Roughly how much memory a result holds on to, counting only what can
+       grow with the input. */
+    size_t getResultSize(const WavMetadata& metadata)
+    {
+        auto size = metadata.ixml.text.getNumBytesAsUTF8()
+                  + metadata.adm.text.getNumBytesAsUTF8()
+                  + metadata.xmp.text.getNumBytesAsUTF8()
+                  + (size_t) metadata.ixml.tracks.size() * sizeof(WavMetadata::IxmlTrack)
+                  + (size_t) metadata.chna.tracks.size() * sizeof(WavMetadata::ChnaTrack)
+                  + (size_t) metadata.chunks.size() * sizeof(WavMetadata::ChunkInfo);
+
+        for (const auto& field : metadata.info.fields)
+            size += sizeof(field) + field.value.getNumBytesAsUTF8();
+
+        return size;
+    }
+
+    struct Measurement
+    {
+        double seconds = 0.0;
+        size_t scratchBytes = 0;    // Everything the arena had to hold.
+        size_t resultBytes = 0;
+    };
+
+    /* Reads a source with an arena for all its scratch memory, as the batch
+       scanner does, and measures what it took. */
+    WavMetadata readMeasured(ByteSource& source, ParseArena& arena, Measurement& measurement)
+    {
+        auto start = juce::Time::getHighResolutionTicks();
+        auto metadata = WavMetadataReader::readFromSource(source, nullptr, &arena);
+        measurement.seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        measurement.scratchBytes = arena.getCapacity();
+        measurement.resultBytes = getResultSize(metadata);
+        return metadata;
+    }
+
+    /* Checks a result against what any input of this size could produce.
+       Returns a description of the first thing wrong, or an empty string. */
+    juce::String checkResult(const WavMetadata& metadata, const Measurement& measurement, size_t maxMemory)
+    {
+        if (measurement.scratchBytes + measurement.resultBytes > maxMemory)
+            return "used " + juce::File::descriptionOfSizeInBytes((juce::int64) (measurement.scratchBytes + measurement.resultBytes))
+                 + ", over the limit of " + juce::File::descriptionOfSizeInBytes((juce::int64) maxMemory);
+
+        if (metadata.chunks.size() > RiffChunkScanner::maxChunks)
+            return "indexed " + juce::String(metadata.chunks.size()) + " chunks";
+
+        if (metadata.cancelled)
+            return "reported itself cancelled without being asked to";
+
+        // Whatever was read has to survive a trip through the cache.
+        juce::MemoryOutputStream out;
+        metadata.writeTo(out);
+
+        WavMetadata restored;
+        juce::MemoryInputStream in(out.getData(), out.getDataSize(), false);
+
+        if (! restored.readFrom(in))
+            return "couldn't be read back from the cache";
+
+        if (restored.ixml.text != metadata.ixml.text || restored.chunks.size() != metadata.chunks.size())
+            return "came back from the cache different";
+
+        return {};
+    }
+}
+
+//==============================================================================
+#if PARSE_FUZZER_LIBFUZZER
+
+namespace
+{
+    // An input this size has no business needing more than this. The largest
+    // legitimate growth is the indented copy of an XML chunk and its index,
+    // each in a buffer that may have doubled, plus the arena kept from
+    // earlier inputs. What matters is that it's linear.
+    size_t getMemoryLimit(size_t inputSize) noexcept
+    {
+        return inputSize * 32 + 8 * 1024 * 1024;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    // Kept between inputs, as a worker keeps its arena between files.
+    static ParseArena arena;
+    static double slowest = 0.0;
+
+    MemorySource source(data, size);
+    Measurement measurement;
+    auto metadata = readMeasured(source, arena, measurement);
+
+    auto problem = checkResult(metadata, measurement, getMemoryLimit(size));
+
+    if (problem.isNotEmpty())
+    {
+        std::cerr << "Reading a " << size << " byte input " << problem << std::endl;
+        std::abort();
+    }
+
+    // libFuzzer's -timeout catches inputs that hang; this shows the trend.
+    if (measurement.seconds > slowest)
+    {
+        slowest = measurement.seconds;
+        std::cerr << "New slowest input: " << size << " bytes in "
+                  << juce::String(measurement.seconds * 1000.0, 3) << " ms" << std::endl;
+    }
+
+    arena.reset();
+    return 0;
+}
+
+#else
+
+namespace
+{
+    //==============================================================================
+    struct InputResult
+    {
+        juce::File file;
+        juce::int64 size = 0;
+        Measurement measurement;
+        juce::String problem;
+    };
+
+    juce::String getOptionValue(const juce::ArgumentList& args, juce::StringRef option, const juce::String& defaultValue)
+    {
+        auto index = args.indexOfOption(option);
+
+        if (index >= 0 && index + 1 < args.size() && ! args[index + 1].isOption())
+            return args[index + 1].text;
+
+        return defaultValue;
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: ParseFuzzer [options] <file or folder>...\n"
+                     "  --budget-ms N     time allowed per input (default 250)\n"
+                     "  --max-mb N        memory allowed per input (default 256)\n"
+                     "  --slowest N       how many of the slowest inputs to list (default 10)\n"
+                     "  --make-seeds DIR  write a small seed corpus to DIR and exit\n"
+                     "\n"
+                     "Every file in a folder is read, whatever its extension, as fuzzer\n"
+                     "corpora don't have any.\n";
+    }
+
+    /* A few small files covering the layouts the reader handles, for a fuzzer to start from. */
+    bool writeSeeds(const juce::File& directory)
+    {
+        if (! directory.createDirectory())
+            return false;
+
+        juce::Random random(42);
+        int index = 0;
+
+        for (auto rf64 : { false, true })
+        {
+            for (auto ixmlAfterData : { false, true })
+            {
+                for (auto includeBext : { false, true })
+                {
+                    SyntheticWavWriter::Options options;
+                    options.rf64 = rf64;
+                    options.ixmlAfterData = ixmlAfterData;
+                    options.includeBext = includeBext;
+                    options.numChannels = 2;
+                    options.dataSize = 64;
+                    options.ixmlSize = 512;
+                    options.numPaddingChunks = 1;
+
+                    auto file = directory.getChildFile("seed_" + juce::String(index++).paddedLeft('0', 2) + ".wav");
+
+                    if (! SyntheticWavWriter::write(file, options, random))
+                        return false;
+                }
+            }
+        }
+
+        return true;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    if (args.containsOption("--make-seeds"))
+    {
+        auto directory = juce::File::getCurrentWorkingDirectory().getChildFile(getOptionValue(args, "--make-seeds", {}));
+
+        if (! writeSeeds(directory))
+        {
+            std::cerr << "Error: could not write the seeds to " << directory.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    auto budgetSeconds = getOptionValue(args, "--budget-ms", "250").getDoubleValue() / 1000.0;
+    auto maxMemory = (size_t) getOptionValue(args, "--max-mb", "256").getLargeIntValue() * 1024 * 1024;
+    auto numSlowest = getOptionValue(args, "--slowest", "10").getIntValue();
+
+    juce::Array<juce::File> inputs;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        if (args[i].isOption())
+        {
+            // Skip the option's value too.
+            if (! args[i].text.contains("=") && ! args[i].isShortOption() && i + 1 < args.size() && ! args[i + 1].isOption())
+                ++i;
+
+            continue;
+        }
+
+        auto item = args[i].resolveAsFile();
+
+        if (item.isDirectory())
+        {
+            for (const auto& entry : juce::RangedDirectoryIterator(item, true, "*", juce::File::findFiles))
+                inputs.add(entry.getFile());
+        }
+        else if (item.existsAsFile())
+        {
+            inputs.add(item);
+        }
+    }
+
+    if (inputs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    // The way an ingest worker reads: windowed, with one arena reused
+    // from one file to the next.
+    ParseArena arena;
+    std::vector<InputResult> results;
+    juce::int64 totalBytes = 0;
+    int numProblems = 0;
+
+    for (const auto& file : inputs)
+    {
+        InputResult result;
+        result.file = file;
+        result.size = file.getSize();
+
+        {
+            WindowedFileSource source(file, WindowedFileSource::defaultWindowSize, &arena);
+            auto metadata = readMeasured(source, arena, result.measurement);
+            result.problem = checkResult(metadata, result.measurement, maxMemory);
+        }
+
+        if (result.problem.isEmpty() && result.measurement.seconds > budgetSeconds)
+            result.problem = "took " + juce::String(result.measurement.seconds * 1000.0, 1) + " ms";
+
+        if (result.problem.isNotEmpty())
+        {
+            ++numProblems;
+            std::cout << file.getFullPathName() << "\t" << result.problem << "\n";
+        }
+
+        totalBytes += result.size;
+        results.push_back(std::move(result));
+        arena.reset();
+    }
+
+    std::sort(results.begin(), results.end(), [](const InputResult& a, const InputResult& b)
+        {
+            return a.measurement.seconds > b.measurement.seconds;
+        });
+
+    double totalSeconds = 0.0;
+    size_t peakMemory = 0;
+
+    for (const auto& result : results)
+    {
+        totalSeconds += result.measurement.seconds;
+        peakMemory = juce::jmax(peakMemory, result.measurement.scratchBytes + result.measurement.resultBytes);
+    }
+
+    auto percentile = [&results](double fraction)
+        {
+            // Sorted slowest first.
+            auto index = juce::jlimit(0, (int) results.size() - 1, (int) std::floor((1.0 - fraction) * (double) results.size()));
+            return results[(size_t) index].measurement.seconds * 1000.0;
+        };
+
+    totalSeconds = juce::jmax(1.0e-9, totalSeconds);
+
+    std::cout << "\n" << results.size() << " inputs, "
+              << juce::String((double) results.size() / totalSeconds, 1) << " inputs/s, "
+              << juce::String((double) totalBytes / (1024.0 * 1024.0) / totalSeconds, 1) << " MB/s\n"
+              << "p50 " << juce::String(percentile(0.5), 3) << " ms, "
+              << "p99 " << juce::String(percentile(0.99), 3) << " ms, "
+              << "max " << juce::String(percentile(1.0), 3) << " ms, "
+              << "peak memory " << juce::File::descriptionOfSizeInBytes((juce::int64) peakMemory) << "\n";
+
+    if (numSlowest > 0)
+    {
+        std::cout << "\nSlowest:\n";
+
+        for (size_t i = 0; i < results.size() && i < (size_t) numSlowest; ++i)
+            std::cout << juce::String(results[i].measurement.seconds * 1000.0, 3).paddedLeft(' ', 10) << " ms  "
+                      << results[i].file.getFullPathName() << "\n";
+    }
+
+    if (numProblems > 0)
+    {
+        std::cerr << "\n" << numProblems << " inputs broke a bound." << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,331 @@
+/*
+  ==============================================================================
+
+    BatchEditor.cpp
+
+  ==============================================================================
+*/
+
+#include "BatchEditor.h"
+#include "WavMetadataReader.h"
+#include <map>
+
+//==============================================================================
+class BatchEditor::EditJob : public juce::ThreadPoolJob
+{
+public:
+    EditJob(BatchEditor& ownerToNotify, const juce::File& fileToEdit, int& volumeJobCount, const ResultCallback& callback)
+        : juce::ThreadPoolJob("Batch edit"),
+          owner(ownerToNotify),
+          file(fileToEdit),
+          numVolumeJobs(volumeJobCount),
+          onResult(callback)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        // Not interrupted by shouldExit(): once a file's edit has started it's
+        // quicker to finish it than to roll it back.
+        juce::String error;
+        auto outcome = owner.editFile(file, error);
+
+        {
+            const juce::ScopedLock sl(owner.callbackLock);
+            onResult(file, outcome, error);
+        }
+
+        {
+            const juce::ScopedLock sl(owner.volumeLock);
+            --numVolumeJobs;
+        }
+
+        owner.jobFinished.signal();
+        return jobHasFinished;
+    }
+
+private:
+    BatchEditor& owner;
+    juce::File file;
+    int& numVolumeJobs;         // Guarded by the owner's volumeLock.
+    const ResultCallback& onResult;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EditJob)
+};
+
+//==============================================================================
+BatchEditor::BatchEditor(const Options& optionsToUse, EditJournal& journalToUse)
+    : options(optionsToUse),
+      journal(journalToUse)
+{
+}
+
+const char* BatchEditor::getOutcomeName(Outcome outcome) noexcept
+{
+    switch (outcome)
+    {
+        case Outcome::changed:          return "changed";
+        case Outcome::unchanged:        return "unchanged";
+        case Outcome::notMatched:       return "not-matched";
+        case Outcome::alreadyDone:      return "already-done";
+        case Outcome::rolledBack:       return "rolled-back";
+        case Outcome::failed:           return "error";
+    }
+
+    return "";
+}
+
+bool BatchEditor::isStopping() const
+{
+    return options.shouldStop != nullptr && options.shouldStop();
+}
+
+//==============================================================================
+int BatchEditor::run(const ResultCallback& onResult)
+{
+    auto files = options.files;
+
+    if (files.isEmpty())
+        for (const auto& entry : juce::RangedDirectoryIterator(options.root, true, "*", juce::File::findFiles))
+            if (entry.getFile().hasFileExtension("wav"))
+                files.add(entry.getFile());
+
+    struct Volume
+    {
+        juce::Array<juce::File> files;
+        int next = 0;
+        int numJobs = 0;
+    };
+
+    std::map<juce::String, Volume> volumes;
+
+    for (const auto& file : files)
+        volumes[getVolumeKey(file)].files.add(file);
+
+    auto numJobs = juce::jmax(1, options.numJobs);
+    auto maxJobsPerVolume = juce::jmax(1, options.maxJobsPerVolume);
+    juce::ThreadPool pool(numJobs);
+
+    // Hand out files a volume at a time, round-robin, never running more
+    // than the limit on one volume however many threads are free.
+    for (;;)
+    {
+        bool anyLeft = false;
+
+        {
+            const juce::ScopedLock sl(volumeLock);
+
+            for (auto& [key, volume] : volumes)
+            {
+                while (volume.next < volume.files.size() && volume.numJobs < maxJobsPerVolume
+                        && pool.getNumJobs() < numJobs)
+                {
+                    ++volume.numJobs;
+                    pool.addJob(new EditJob(*this, volume.files.getReference(volume.next++), volume.numJobs, onResult), true);
+                }
+
+                anyLeft = anyLeft || volume.next < volume.files.size();
+            }
+        }
+
+        if (! anyLeft || isStopping())
+            break;
+
+        jobFinished.wait(100);
+    }
+
+    while (pool.getNumJobs() > 0)
+        jobFinished.wait(100);
+
+    int numStarted = 0;
+
+    for (const auto& [key, volume] : volumes)
+        numStarted += volume.next;
+
+    return numStarted;
+}
+
+BatchEditor::Outcome BatchEditor::editFile(const juce::File& file, juce::String& error)
+{
+    auto fail = [&error](const juce::Result& result)
+        {
+            error = result.getErrorMessage();
+            return Outcome::failed;
+        };
+
+    EditJournal::Entry entry;
+
+    if (journal.getEntry(file, entry))
+    {
+        if (entry.state == EditJournal::State::committed || entry.state == EditJournal::State::unchanged)
+            return Outcome::alreadyDone;
+
+        // Caught part-way by whatever stopped the last run, so start again
+        // from the bytes it had before.
+        if (entry.state == EditJournal::State::begun)
+        {
+            auto restored = EditJournal::restore(file, entry);
+
+            if (restored.failed())
+                return fail(restored);
+
+            // Until the journal says so, the next run would take the entry
+            // as still begun, so don't go on without that.
+            auto rolledBack = journal.recordRolledBack(file);
+
+            if (rolledBack.failed())
+                return fail(rolledBack);
+        }
+    }
+
+    auto metadata = WavMetadataReader::read(file);
+
+    if (metadata.status.failed())
+        return fail(metadata.status);
+
+    if (options.whereField.isNotEmpty() && getField(metadata, options.whereField) != options.whereValue)
+    {
+        auto recorded = journal.recordUnchanged(file);
+        return recorded.wasOk() ? Outcome::notMatched : fail(recorded);
+    }
+
+    auto edited = metadata;
+
+    for (int i = 0; i < options.changes.size(); ++i)
+        setField(edited, options.changes.getAllKeys()[i], options.changes.getAllValues()[i]);
+
+    WavMetadataWriter::Plan plan;
+    auto planned = WavMetadataWriter::plan(file, edited, plan);
+
+    if (planned.failed())
+        return fail(planned);
+
+    if (plan.isEmpty())
+    {
+        auto recorded = journal.recordUnchanged(file);
+        return recorded.wasOk() ? Outcome::unchanged : fail(recorded);
+    }
+
+    // Nothing is written to the file until its old bytes are safely in the journal.
+    auto begun = journal.recordBegin(file, plan);
+
+    if (begun.failed())
+        return fail(begun);
+
+    auto applied = WavMetadataWriter::apply(file, plan);
+
+    if (applied.failed())
+    {
+        if (journal.getEntry(file, entry) && EditJournal::restore(file, entry).wasOk())
+        {
+            auto rolledBack = journal.recordRolledBack(file);
+
+            if (rolledBack.failed())
+                return fail(rolledBack);
+        }
+
+        return fail(applied);
+    }
+
+    auto committed = journal.recordCommit(file);
+    return committed.wasOk() ? Outcome::changed : fail(committed);
+}
+
+//==============================================================================
+int BatchEditor::rollBack(EditJournal& journal, const ResultCallback& onResult)
+{
+    int numRolledBack = 0;
+
+    for (const auto& path : journal.getPaths())
+    {
+        juce::File file(path);
+        EditJournal::Entry entry;
+
+        if (! journal.getEntry(file, entry)
+             || entry.state == EditJournal::State::unchanged || entry.state == EditJournal::State::rolledBack)
+            continue;
+
+        // A committed file that has been changed again since would lose those
+        // changes too, so it's left alone.
+        if (entry.state == EditJournal::State::committed
+             && (file.getSize() != entry.committedSize
+                  || file.getLastModificationTime().toMilliseconds() != entry.committedModificationTime))
+        {
+            onResult(file, Outcome::failed, "The file has been changed since it was edited, so it was left alone.");
+            continue;
+        }
+
+        auto restored = EditJournal::restore(file, entry);
+
+        if (restored.wasOk())
+            restored = journal.recordRolledBack(file);
+
+        if (restored.failed())
+        {
+            onResult(file, Outcome::failed, restored.getErrorMessage());
+            continue;
+        }
+
+        onResult(file, Outcome::rolledBack, {});
+        ++numRolledBack;
+    }
+
+    return numRolledBack;
+}
+
+//==============================================================================
+juce::StringArray BatchEditor::getEditableFields()
+{
+    return { "PROJECT", "SCENE", "TAKE", "TAPE", "DESCRIPTION", "ORIGINATOR", "ORIGINATOR_REFERENCE" };
+}
+
+juce::String BatchEditor::getField(const WavMetadata& metadata, const juce::String& fieldName)
+{
+    auto name = fieldName.toUpperCase();
+
+    if (name == "PROJECT")                  return metadata.ixml.project;
+    if (name == "SCENE")                    return metadata.ixml.scene;
+    if (name == "TAKE")                     return metadata.ixml.take;
+    if (name == "TAPE")                     return metadata.ixml.tape;
+    if (name == "DESCRIPTION")              return metadata.bext.description;
+    if (name == "ORIGINATOR")               return metadata.bext.originator;
+    if (name == "ORIGINATOR_REFERENCE")     return metadata.bext.originatorReference;
+
+    return {};
+}
+
+bool BatchEditor::setField(WavMetadata& metadata, const juce::String& fieldName, const juce::String& value)
+{
+    auto name = fieldName.toUpperCase();
+
+    if (name == "PROJECT")                  metadata.ixml.project = value;
+    else if (name == "SCENE")               metadata.ixml.scene = value;
+    else if (name == "TAKE")                metadata.ixml.take = value;
+    else if (name == "TAPE")                metadata.ixml.tape = value;
+    else if (name == "DESCRIPTION")         metadata.bext.description = value;
+    else if (name == "ORIGINATOR")          metadata.bext.originator = value;
+    else if (name == "ORIGINATOR_REFERENCE") metadata.bext.originatorReference = value;
+    else                                    return false;
+
+    return true;
+}
+
+juce::String BatchEditor::getVolumeKey(const juce::File& file)
+{
+    auto path = file.getFullPathName();
+
+    // \\server\share\...
+    if (path.startsWith("\\\\"))
+    {
+        auto parts = juce::StringArray::fromTokens(path.substring(2), "\\", {});
+        return "\\\\" + parts[0] + "\\" + parts[1];
+    }
+
+    // C:\...
+    if (path.length() >= 2 && path[1] == ':')
+        return path.substring(0, 2).toUpperCase();
+
+    auto parts = juce::StringArray::fromTokens(path, "/", {});
+    parts.removeEmptyStrings();
+    return "/" + parts[0] + "/" + parts[1];
+}
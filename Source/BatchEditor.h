@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    BatchEditor.h
+
+    Applies the same metadata change to many files at once, e.g. setting the
+    TAPE or PROJECT of a whole day's takes. Files are edited on a pool of
+    worker threads, with only a few at a time on any one volume so a file
+    server isn't swamped. Every change goes through an EditJournal first, so
+    a run that's interrupted can be resumed, skipping what it already did,
+    or rolled back. Used by the command-line "--edit" mode. Only depends on
+    juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "EditJournal.h"
+
+//==============================================================================
+class BatchEditor
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        // The files under root are edited, unless files isn't empty.
+        juce::File root;
+        juce::Array<juce::File> files;
+
+        // Field name -> new value; see getEditableFields().
+        juce::StringPairArray changes;
+
+        // If set, only files whose field currently has this value are edited.
+        juce::String whereField, whereValue;
+
+        int numJobs = juce::SystemStats::getNumCpus();
+        int maxJobsPerVolume = 2;
+
+        // If set, polled between files; returning true stops the run once the
+        // files being edited are finished.
+        std::function<bool()> shouldStop;
+    };
+
+    enum class Outcome
+    {
+        changed,
+        unchanged,      // Already had the new values.
+        notMatched,     // Didn't match the "where" condition.
+        alreadyDone,    // Done by the run being resumed.
+        rolledBack,
+        failed
+    };
+
+    static const char* getOutcomeName(Outcome outcome) noexcept;
+
+    /* Called once per file. Calls are serialised, but come from the worker
+       threads in no particular order. */
+    using ResultCallback = std::function<void(const juce::File&, Outcome, const juce::String& error)>;
+
+    //==============================================================================
+    /* The journal must be open for writing, and outlive the editor. */
+    BatchEditor(const Options& options, EditJournal& journal);
+
+    /* Edits every file, blocking until they're all done or the run is
+       stopped. Files the journal has as done are skipped, and any it has as
+       begun are put back before being edited again. Returns the number of
+       files looked at. */
+    int run(const ResultCallback& onResult);
+
+    /* Puts back every file a journal's run changed, unless it has been
+       changed again since. Returns the number of files rolled back. */
+    static int rollBack(EditJournal& journal, const ResultCallback& onResult);
+
+    //==============================================================================
+    /* The fields that can be changed: PROJECT, SCENE, TAKE, TAPE, DESCRIPTION,
+       ORIGINATOR and ORIGINATOR_REFERENCE. */
+    static juce::StringArray getEditableFields();
+
+    /* Gets or sets one of the editable fields by name (not case-sensitive).
+       setField() returns false for a name that isn't one of them. */
+    static juce::String getField(const WavMetadata& metadata, const juce::String& fieldName);
+    static bool setField(WavMetadata& metadata, const juce::String& fieldName, const juce::String& value);
+
+    /* Files with the same key are taken to be on the same volume: the drive
+       or network share on Windows, and the first two levels of the path
+       elsewhere (e.g. /Volumes/Media or /mnt/nas). */
+    static juce::String getVolumeKey(const juce::File& file);
+
+private:
+    //==============================================================================
+    class EditJob;
+
+    Outcome editFile(const juce::File& file, juce::String& error);
+    bool isStopping() const;
+
+    Options options;
+    EditJournal& journal;
+
+    juce::CriticalSection callbackLock, volumeLock;
+    juce::WaitableEvent jobFinished;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchEditor)
+};
@@ -0,0 +1,308 @@
+/*
+  ==============================================================================
+
+    BatchScanner.cpp
+
+  ==============================================================================
+*/
+
+#include "BatchScanner.h"
+#include "WavMetadataReader.h"
+#include "BatchEditor.h"
+
+//==============================================================================
+/* One file's cache lookup and header read, done ahead of the job that parses
+   it. Holds the file's arena until the last of the two lets go of it. */
+struct BatchScanner::HeaderRead
+{
+    HeaderRead(BatchScanner& ownerToUse, const juce::File& fileToRead)
+        : owner(ownerToUse),
+          file(fileToRead),
+          arena(ownerToUse.acquireArena())
+    {
+    }
+
+    ~HeaderRead()
+    {
+        // The source's windows live in the arena.
+        source.reset();
+        owner.releaseArena(arena);
+    }
+
+    BatchScanner& owner;
+    juce::File file;
+    ParseArena* arena;
+    juce::WaitableEvent finished { true };
+
+    bool isCached = false;
+    WavMetadata cachedMetadata;
+    MetadataCache::Stamp stamp;     // Taken by the lookup, before the file is read.
+    std::unique_ptr<WindowedFileSource> source;
+    ParseTimings timings;
+
+    JUCE_DECLARE_NON_COPYABLE(HeaderRead)
+};
+
+//==============================================================================
+class BatchScanner::ScanJob : public juce::ThreadPoolJob
+{
+public:
+    ScanJob(BatchScanner& ownerToNotify, const juce::File& fileToScan,
+            std::shared_ptr<HeaderRead> headerReadToUse, const ResultCallback& callback)
+        : juce::ThreadPoolJob("Batch scan"),
+          owner(ownerToNotify),
+          file(fileToScan),
+          headerRead(std::move(headerReadToUse)),
+          onResult(callback)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        if (headerRead == nullptr)
+        {
+            // Nobody read ahead for us, so do it here.
+            headerRead = std::make_shared<HeaderRead>(owner, file);
+            owner.readHeaders(*headerRead);
+        }
+        else
+        {
+            while (! headerRead->finished.wait(50))
+            {
+                if (shouldExit())
+                {
+                    owner.jobFinished.signal();
+                    return jobHasFinished;
+                }
+            }
+        }
+
+        auto metadata = parse();
+
+        if (! metadata.cancelled)
+        {
+            if (auto* metrics = owner.options.metrics)
+                metrics->addFile(metadata, headerRead->source != nullptr ? headerRead->source->getNumBytesRead() : 0,
+                                 headerRead->isCached, BatchEditor::getVolumeKey(file));
+
+            const juce::ScopedLock sl(owner.callbackLock);
+            onResult(file, metadata);
+        }
+
+        owner.jobFinished.signal();
+        return jobHasFinished;
+    }
+
+private:
+    WavMetadata parse()
+    {
+        if (headerRead->isCached)
+        {
+            auto metadata = headerRead->cachedMetadata;
+            metadata.timings.add(headerRead->timings);
+            return metadata;
+        }
+
+        // The read was abandoned because the scan is stopping.
+        if (headerRead->source == nullptr)
+        {
+            WavMetadata metadata;
+            metadata.cancelled = true;
+            return metadata;
+        }
+
+        auto metadata = WavMetadataReader::readFromSource(*headerRead->source, [this]
+            {
+                return shouldExit() || owner.isStopping();
+            }, headerRead->arena);
+
+        metadata.timings.add(headerRead->timings);
+
+        if (owner.options.cache != nullptr && ! metadata.cancelled)
+            owner.options.cache->store(file, headerRead->stamp, metadata);
+
+        return metadata;
+    }
+
+    BatchScanner& owner;
+    juce::File file;
+    std::shared_ptr<HeaderRead> headerRead;
+    const ResultCallback& onResult;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScanJob)
+};
+
+//==============================================================================
+BatchScanner::BatchScanner(const Options& optionsToUse)
+    : options(optionsToUse)
+{
+}
+
+int BatchScanner::run(const ResultCallback& onResult)
+{
+    auto numJobs = juce::jmax(1, options.numJobs);
+    auto readAhead = juce::jmax(0, options.readAhead);
+
+    // Declared first so that it goes last: the parsing jobs wait on its reads.
+    juce::ThreadPool readPool(juce::jmax(1, readAhead));
+    juce::ThreadPool pool(numJobs);
+
+    // Keep only a few files queued per worker rather than the whole tree, so
+    // memory use doesn't grow with the size of the library being scanned.
+    // Every queued file beyond the ones being parsed can have its headers
+    // read in, so there's room for the whole read-ahead too.
+    auto maxQueuedJobs = juce::jmax(numJobs * 4, numJobs + readAhead);
+    int numFiles = 0;
+
+    auto updateQueueDepth = [&]
+        {
+            if (auto* metrics = options.metrics)
+                metrics->setQueueDepth(pool.getNumJobs());
+        };
+
+    auto addFile = [&](const juce::File& file)
+        {
+            while (pool.getNumJobs() >= maxQueuedJobs && ! isStopping())
+            {
+                jobFinished.wait(100);
+                updateQueueDepth();
+            }
+
+            if (isStopping())
+                return false;
+
+            std::shared_ptr<HeaderRead> headerRead;
+
+            if (readAhead > 0)
+            {
+                headerRead = std::make_shared<HeaderRead>(*this, file);
+
+                readPool.addJob([this, headerRead]
+                    {
+                        readHeaders(*headerRead);
+                    });
+            }
+
+            pool.addJob(new ScanJob(*this, file, std::move(headerRead), onResult), true);
+            updateQueueDepth();
+            ++numFiles;
+            return true;
+        };
+
+    if (! options.files.isEmpty())
+    {
+        for (const auto& file : options.files)
+            if (! addFile(file))
+                break;
+    }
+    else
+    {
+        for (const auto& entry : juce::RangedDirectoryIterator(options.root, true, "*", juce::File::findFiles))
+            if (entry.getFile().hasFileExtension("wav") && ! addFile(entry.getFile()))
+                break;
+    }
+
+    // Running jobs see the stop through shouldExit() and report nothing.
+    if (isStopping())
+    {
+        pool.removeAllJobs(true, 0);
+        readPool.removeAllJobs(true, 0);
+    }
+
+    // Let the queue drain before the pool (and the callback reference) go away.
+    while (pool.getNumJobs() > 0)
+    {
+        jobFinished.wait(100);
+        updateQueueDepth();
+    }
+
+    updateQueueDepth();
+    return numFiles;
+}
+
+/* Answers a file from the cache if it can, and otherwise reads its header
+   and tail windows so the parse that follows needn't wait on the storage. */
+void BatchScanner::readHeaders(HeaderRead& read)
+{
+    if (! isStopping())
+    {
+        if (auto* cache = options.cache)
+        {
+            const ParseTimings::ScopedTimer timer(&read.timings, ParseTimings::cacheLookup);
+            read.isCached = cache->lookup(read.file, read.cachedMetadata, &read.stamp);
+        }
+
+        if (! read.isCached)
+        {
+            const ParseTimings::ScopedTimer timer(&read.timings, ParseTimings::io);
+            // The read-ahead jobs are the concurrency, so each reads its windows itself.
+            read.source = std::make_unique<WindowedFileSource>(read.file, WindowedFileSource::defaultWindowSize, read.arena,
+                                                               WindowedFileSource::Reads::sequential);
+        }
+    }
+
+    read.finished.signal();
+}
+
+bool BatchScanner::isStopping() const
+{
+    return options.shouldStop != nullptr && options.shouldStop();
+}
+
+ParseArena* BatchScanner::acquireArena()
+{
+    const juce::ScopedLock sl(arenaLock);
+
+    if (! freeArenas.isEmpty())
+        return freeArenas.removeAndReturn(freeArenas.size() - 1);
+
+    return arenas.add(new ParseArena());
+}
+
+void BatchScanner::releaseArena(ParseArena* arena)
+{
+    // Reset outside the lock; it's ours until it's back on the list.
+    arena->reset();
+
+    const juce::ScopedLock sl(arenaLock);
+    freeArenas.add(arena);
+}
+
+//==============================================================================
+juce::String BatchScanner::formatRecord(const juce::File& file, const WavMetadata& metadata)
+{
+    return formatRecord(file.getFullPathName(), metadata);
+}
+
+juce::String BatchScanner::formatRecord(const juce::String& location, const WavMetadata& metadata)
+{
+    // Fields are tab-separated, so make sure no value can break the line up.
+    auto clean = [](const juce::String& text)
+        {
+            return text.replaceCharacters("\t\r\n", "   ");
+        };
+
+    juce::StringArray fields;
+    fields.add(clean(location));
+
+    if (metadata.status.failed())
+    {
+        fields.add("error");
+        fields.add(clean(metadata.status.getErrorMessage()));
+        return fields.joinIntoString("\t");
+    }
+
+    const auto& format = metadata.format;
+    const auto& bext = metadata.bext;
+
+    fields.add("ok");
+    fields.add(format.found ? juce::String(format.sampleRate) : juce::String());
+    fields.add(format.found ? juce::String(format.numChannels) : juce::String());
+    fields.add(format.found ? juce::String(format.bitsPerSample) : juce::String());
+    fields.add(bext.found ? clean(bext.originator) : juce::String());
+    fields.add(bext.found ? clean(bext.description) : juce::String());
+    fields.add(bext.found ? juce::String(bext.timeReference) : juce::String());
+    fields.add(metadata.ixml.found ? "ixml" : "no-ixml");
+
+    return fields.joinIntoString("\t");
+}
@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    BatchScanner.h
+
+    Walks a directory tree (or a given list of files) and parses every WAV
+    file it finds on a pool of worker threads. Used by the command-line
+    "--scan" mode and by exports. Only depends on juce_core.
+
+    Reading a file's headers is mostly waiting on storage, and parsing them
+    is mostly CPU, so the two are done on separate pools: a few files ahead
+    of the parsers have their cache entries looked up and their headers read
+    in, which keeps many requests in flight on a network volume without
+    running more parsers than there are cores.
+
+    Each file in flight gets a ParseArena for its read windows and parsing
+    scratch, handed back and reset once its result has been reported, so the
+    workers aren't all contending for the heap.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WavMetadata.h"
+#include "MetadataCache.h"
+#include "ParseArena.h"
+#include "ScanMetrics.h"
+
+//==============================================================================
+class BatchScanner
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        juce::File root;
+
+        // If not empty, these files are scanned instead of the tree under root.
+        juce::Array<juce::File> files;
+
+        int numJobs = juce::SystemStats::getNumCpus();
+
+        // How many header reads can be in flight ahead of the parsers. Zero
+        // makes each parsing thread read its own files instead.
+        int readAhead = 16;
+
+        // If set, files whose size and modification time haven't changed are
+        // answered from here, and everything parsed is added to it.
+        MetadataCache* cache = nullptr;
+
+        // If set, every file reported is counted here, and the queue depth kept up to date.
+        ScanMetrics* metrics = nullptr;
+
+        // If set, polled between files; returning true abandons the rest of the scan.
+        std::function<bool()> shouldStop;
+    };
+
+    /* Called once per file as soon as it has been parsed. Calls are serialised,
+       but they come from the worker threads and in no particular order. */
+    using ResultCallback = std::function<void(const juce::File&, const WavMetadata&)>;
+
+    //==============================================================================
+    explicit BatchScanner(const Options& options);
+
+    /* Scans the whole tree, blocking until every file has been reported or
+       the scan is stopped. Returns the number of files that were parsed. */
+    int run(const ResultCallback& onResult);
+
+    /* Formats one tab-separated line describing a parsed file. */
+    static juce::String formatRecord(const juce::File& file, const WavMetadata& metadata);
+
+    /* As above, for a file named some other way, e.g. by URL. */
+    static juce::String formatRecord(const juce::String& location, const WavMetadata& metadata);
+
+private:
+    //==============================================================================
+    struct HeaderRead;
+    class ScanJob;
+
+    void readHeaders(HeaderRead& read);
+    bool isStopping() const;
+
+    ParseArena* acquireArena();
+    void releaseArena(ParseArena* arena);
+
+    Options options;
+    juce::CriticalSection callbackLock;
+    juce::WaitableEvent jobFinished;
+
+    juce::CriticalSection arenaLock;
+    juce::OwnedArray<ParseArena> arenas;
+    juce::Array<ParseArena*> freeArenas;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchScanner)
+};
@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    BextChunk.h
+
+    The fixed 602-byte part of a BWF "bext" chunk (EBU Tech 3285), read in
+    one copy into a packed struct and decoded from there without touching
+    the heap. Text fields come back as views into the struct. Only depends
+    on juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <string_view>
+
+//==============================================================================
+class BextChunk
+{
+public:
+    //==============================================================================
+    /* The chunk exactly as it's stored in the file. Integers are little-endian. */
+   #pragma pack(push, 1)
+    struct Layout
+    {
+        char description[256];
+        char originator[32];
+        char originatorReference[32];
+        char originationDate[10];           // yyyy-mm-dd
+        char originationTime[8];            // hh-mm-ss
+        juce::uint8 timeReference[8];       // Samples since midnight.
+        juce::uint8 version[2];
+        juce::uint8 umid[64];               // Version 1 and later.
+        juce::uint8 loudnessValue[2];       // Version 2: all loudness values are in hundredths.
+        juce::uint8 loudnessRange[2];
+        juce::uint8 maxTruePeakLevel[2];
+        juce::uint8 maxMomentaryLoudness[2];
+        juce::uint8 maxShortTermLoudness[2];
+        char reserved[180];
+    };
+   #pragma pack(pop)
+
+    static_assert(sizeof(Layout) == 602, "The bext layout must match the file format byte for byte");
+
+    /* Everything before the version field, which every bext chunk has. */
+    static constexpr size_t minimumSize = offsetof(Layout, version);
+
+    //==============================================================================
+    /* Copies the fixed part of the chunk. Anything a short chunk doesn't have is
+       left zeroed, which every field already treats as "not set". */
+    BextChunk(const char* data, juce::uint64 size) noexcept
+    {
+        std::memset(&layout, 0, sizeof(layout));
+        isValid = data != nullptr && size >= minimumSize;
+
+        if (isValid)
+            std::memcpy(&layout, data, (size_t) juce::jmin(size, (juce::uint64) sizeof(layout)));
+    }
+
+    bool isValidChunk() const noexcept                          { return isValid; }
+
+    //==============================================================================
+    std::string_view getDescription() const noexcept             { return getText(layout.description); }
+    std::string_view getOriginator() const noexcept              { return getText(layout.originator); }
+    std::string_view getOriginatorReference() const noexcept     { return getText(layout.originatorReference); }
+    std::string_view getOriginationDate() const noexcept         { return getText(layout.originationDate); }
+    std::string_view getOriginationTime() const noexcept         { return getText(layout.originationTime); }
+
+    juce::int64 getTimeReference() const noexcept
+    {
+        return (juce::int64) juce::ByteOrder::littleEndianInt64(layout.timeReference);
+    }
+
+    int getVersion() const noexcept
+    {
+        return (int) juce::ByteOrder::littleEndianShort(layout.version);
+    }
+
+    //==============================================================================
+    /* The SMPTE UMID. Basic UMIDs only use the first 32 bytes; an all-zero UMID
+       means none was written. */
+    const juce::uint8* getUmid() const noexcept                  { return layout.umid; }
+
+    /* 64 for an extended UMID, 32 for a basic one, or 0 if there isn't one. */
+    int getUmidSize() const noexcept
+    {
+        if (getVersion() < 1)
+            return 0;
+
+        auto isZero = [this](int start, int end)
+            {
+                for (int i = start; i < end; ++i)
+                    if (layout.umid[i] != 0)
+                        return false;
+
+                return true;
+            };
+
+        return isZero(32, 64) ? (isZero(0, 32) ? 0 : 32) : 64;
+    }
+
+    //==============================================================================
+    /* The loudness fields, in LUFS, LU or dBTP. They only exist from version 2,
+       and a field that wasn't measured holds 0x7fff; either way we return NaN. */
+    float getLoudnessValue() const noexcept                      { return getLoudness(layout.loudnessValue); }
+    float getLoudnessRange() const noexcept                      { return getLoudness(layout.loudnessRange); }
+    float getMaxTruePeakLevel() const noexcept                   { return getLoudness(layout.maxTruePeakLevel); }
+    float getMaxMomentaryLoudness() const noexcept               { return getLoudness(layout.maxMomentaryLoudness); }
+    float getMaxShortTermLoudness() const noexcept               { return getLoudness(layout.maxShortTermLoudness); }
+
+private:
+    //==============================================================================
+    /* A fixed-size text field, up to its first null and without trailing spaces. */
+    template <size_t size>
+    static std::string_view getText(const char (&field)[size]) noexcept
+    {
+        auto* nullChar = static_cast<const char*>(std::memchr(field, 0, size));
+        auto length = nullChar != nullptr ? (size_t) (nullChar - field) : size;
+
+        while (length > 0 && (field[length - 1] == ' ' || field[length - 1] == '\t'
+                               || field[length - 1] == '\r' || field[length - 1] == '\n'))
+            --length;
+
+        size_t start = 0;
+
+        while (start < length && field[start] == ' ')
+            ++start;
+
+        return { field + start, length - start };
+    }
+
+    float getLoudness(const juce::uint8 (&field)[2]) const noexcept
+    {
+        auto value = (juce::int16) juce::ByteOrder::littleEndianShort(field);
+
+        if (getVersion() < 2 || value == 0x7fff)
+            return std::numeric_limits<float>::quiet_NaN();
+
+        return (float) value / 100.0f;
+    }
+
+    Layout layout;
+    bool isValid = false;
+};
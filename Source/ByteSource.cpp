@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+    ByteSource.cpp
+
+  ==============================================================================
+*/
+
+#include "ByteSource.h"
+
+namespace
+{
+    // Tail windows start on a multiple of this.
+    constexpr size_t alignment = 4096;
+
+    /* Threads for the reads that overlap another one, when one file is being
+       opened at a time. Busy threads are never queued behind: that would add
+       a round-trip rather than hide one, so the read is made in turn instead. */
+    juce::ThreadPool& getReadAheadPool()
+    {
+        static juce::ThreadPool pool(4);
+        return pool;
+    }
+}
+
+//==============================================================================
+MemorySource::MemorySource(const void* sourceData, size_t numBytes) noexcept
+    : data(static_cast<const char*>(sourceData)),
+      size(numBytes)
+{
+}
+
+bool MemorySource::openedOk() const
+{
+    return data != nullptr;
+}
+
+juce::uint64 MemorySource::getTotalLength() const
+{
+    return (juce::uint64) size;
+}
+
+const char* MemorySource::getBytes(juce::uint64 offset, size_t numBytes)
+{
+    if (! openedOk() || offset > size || numBytes > size - (size_t) offset)
+        return nullptr;
+
+    return data + offset;
+}
+
+//==============================================================================
+MappedFileSource::MappedFileSource(const juce::File& file)
+    : mappedFile(file, juce::MemoryMappedFile::readOnly)
+{
+}
+
+bool MappedFileSource::openedOk() const
+{
+    // A failed (or zero-length) mapping leaves getData() null.
+    return mappedFile.getData() != nullptr;
+}
+
+juce::uint64 MappedFileSource::getTotalLength() const
+{
+    return (juce::uint64) mappedFile.getSize();
+}
+
+const char* MappedFileSource::getBytes(juce::uint64 offset, size_t numBytes)
+{
+    if (! openedOk() || offset > getTotalLength() || numBytes > getTotalLength() - offset)
+        return nullptr;
+
+    return static_cast<const char*>(mappedFile.getData()) + offset;
+}
+
+//==============================================================================
+const char* WindowedFileSource::Window::find(juce::uint64 offset, size_t numBytes) const noexcept
+{
+    if (data == nullptr || offset < start || offset - start > size || numBytes > size - (size_t) (offset - start))
+        return nullptr;
+
+    return data + (offset - start);
+}
+
+WindowedFileSource::WindowedFileSource(const juce::File& file, size_t windowSize, ParseArena* arenaToUse, Reads reads)
+    : arena(arenaToUse),
+      stream(file)
+{
+    if (! stream.openedOk())
+        return;
+
+    totalLength = (juce::uint64) stream.getTotalLength();
+
+    // Small files fit in the head window entirely.
+    auto headSize = (size_t) juce::jmin(totalLength, (juce::uint64) windowSize);
+
+    allocateWindow(head, 0, headSize);
+
+    if (totalLength <= headSize)
+    {
+        readWindow(stream, head);
+        return;
+    }
+
+    // Start the tail on a block boundary, which is what storage (and the OS
+    // cache) deal in anyway.
+    auto tailStart = juce::jmax((juce::uint64) headSize, (totalLength - windowSize) & ~(juce::uint64) (alignment - 1));
+    allocateWindow(tail, tailStart, (size_t) (totalLength - tailStart));
+
+    auto& pool = getReadAheadPool();
+
+    if (reads == Reads::sequential || pool.getNumJobs() >= pool.getNumThreads())
+    {
+        readWindow(stream, head);
+        readWindow(stream, tail);
+        return;
+    }
+
+    // Read the tail on another thread while this one reads the head, so the
+    // two requests are in flight together. We wait for it before returning,
+    // so it's safe for the job to refer to our members.
+    juce::WaitableEvent tailFinished;
+
+    pool.addJob([&]
+        {
+            juce::FileInputStream tailStream(file);
+
+            if (tailStream.openedOk())
+                readWindow(tailStream, tail);
+
+            tailFinished.signal();
+        });
+
+    readWindow(stream, head);
+    tailFinished.wait();
+}
+
+bool WindowedFileSource::openedOk() const
+{
+    return stream.openedOk() && totalLength > 0;
+}
+
+juce::uint64 WindowedFileSource::getTotalLength() const
+{
+    return totalLength;
+}
+
+const char* WindowedFileSource::getBytes(juce::uint64 offset, size_t numBytes)
+{
+    if (! openedOk() || offset > totalLength || numBytes > totalLength - offset)
+        return nullptr;
+
+    if (auto* inHead = head.find(offset, numBytes))
+        return inHead;
+
+    if (auto* inTail = tail.find(offset, numBytes))
+        return inTail;
+
+    for (auto* extra : extraReads)
+        if (auto* inExtra = extra->find(offset, numBytes))
+            return inExtra;
+
+    // Outside both windows: read the aligned blocks covering this range, as
+    // the next thing asked for is usually just after it. Earlier views must
+    // stay valid, so each read gets a block of its own.
+    auto start = offset & ~(juce::uint64) (blockSize - 1);
+    auto end = juce::jmin(totalLength, (offset + numBytes + blockSize - 1) & ~(juce::uint64) (blockSize - 1));
+
+    auto* extra = extraReads.add(new Window());
+    allocateWindow(*extra, start, (size_t) (end - start));
+
+    if (! readWindow(stream, *extra))
+        return nullptr;
+
+    return extra->find(offset, numBytes);
+}
+
+void WindowedFileSource::allocateWindow(Window& window, juce::uint64 start, size_t numBytes)
+{
+    window.start = start;
+    window.size = numBytes;
+
+    if (arena != nullptr)
+    {
+        window.data = static_cast<char*>(arena->allocate(numBytes));
+    }
+    else
+    {
+        window.ownedData.malloc(numBytes);
+        window.data = window.ownedData.get();
+    }
+}
+
+bool WindowedFileSource::readWindow(juce::InputStream& source, Window& window)
+{
+    if (window.size == 0)
+        return true;
+
+    const ParseTimings::ScopedTimer timer(timings, ParseTimings::io);
+
+    if (! source.setPosition((juce::int64) window.start)
+         || source.read(window.data, (int) window.size) != (int) window.size)
+    {
+        window.data = nullptr;
+        window.size = 0;
+        return false;
+    }
+
+    numBytesRead.fetch_add(window.size, std::memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    ByteSource.h
+
+    Where the chunk scanner gets its bytes from. A source hands out read-only
+    views of byte ranges, so a memory-mapped file can serve them in place
+    while a stream-backed source only reads the ranges that are asked for.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParseTimings.h"
+#include "ParseArena.h"
+
+//==============================================================================
+class ByteSource
+{
+public:
+    //==============================================================================
+    virtual ~ByteSource() = default;
+
+    /* False if the underlying file couldn't be opened. */
+    virtual bool openedOk() const = 0;
+
+    /* The total number of bytes in the source. */
+    virtual juce::uint64 getTotalLength() const = 0;
+
+    /* Returns a view of numBytes bytes starting at offset, or nullptr if the
+       range lies outside the source or can't be read. The view stays valid for
+       as long as the source does. */
+    virtual const char* getBytes(juce::uint64 offset, size_t numBytes) = 0;
+
+    /* Says which ranges are about to be asked for, so a source that pays for
+       each request can fetch them together. The default does nothing. */
+    virtual void prefetch(const juce::Array<juce::Range<juce::uint64>>& ranges)  { juce::ignoreUnused(ranges); }
+
+    /* Where to count the time spent reading, or nullptr to stop counting. */
+    void setTimings(ParseTimings* timingsToUpdate) noexcept     { timings = timingsToUpdate; }
+
+    /* How many bytes the source has had to read so far. Sources that serve
+       ranges in place, like a memory mapping, don't count anything. */
+    juce::uint64 getNumBytesRead() const noexcept               { return numBytesRead.load(std::memory_order_relaxed); }
+
+protected:
+    ParseTimings* timings = nullptr;
+
+    // Added to from whichever thread did the read.
+    std::atomic<juce::uint64> numBytesRead { 0 };
+};
+
+//==============================================================================
+/* Serves ranges out of bytes already in memory, e.g. for fuzzing the parser.
+   The memory isn't copied, and must outlive the source. */
+class MemorySource : public ByteSource
+{
+public:
+    MemorySource(const void* data, size_t numBytes) noexcept;
+
+    bool openedOk() const override;
+    juce::uint64 getTotalLength() const override;
+    const char* getBytes(juce::uint64 offset, size_t numBytes) override;
+
+private:
+    const char* data;
+    size_t size;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MemorySource)
+};
+
+//==============================================================================
+/* Serves every range straight out of a memory mapping of the whole file. */
+class MappedFileSource : public ByteSource
+{
+public:
+    explicit MappedFileSource(const juce::File& file);
+
+    bool openedOk() const override;
+    juce::uint64 getTotalLength() const override;
+    const char* getBytes(juce::uint64 offset, size_t numBytes) override;
+
+private:
+    juce::MemoryMappedFile mappedFile;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MappedFileSource)
+};
+
+//==============================================================================
+/*
+    Reads the first and last few kilobytes of a file up front. The headers and
+    metadata of a typical WAV sit in those two windows, even when the metadata
+    was appended after a multi-gigabyte data chunk, so most lookups need no
+    further I/O. The two windows are read at the same time, on separate file
+    handles, so on a network volume opening a file costs one round-trip
+    rather than two.
+
+    Any range outside the windows is read on demand, rounded out to an aligned
+    block, so a chunk walk that has to leave the windows picks up the next
+    few headers with the same request rather than one request per header.
+
+    Given an arena, the source takes its buffers from there rather than from
+    the heap, and they belong to the arena: it mustn't be reset while the
+    source is in use.
+
+    Overlapping the reads is for opening one file at a time. Something that
+    already opens many at once, like BatchScanner's read-ahead, should ask
+    for sequential reads: its own jobs keep enough requests in flight, and
+    funnelling every tail read through the shared overlap threads would cap
+    them at however many of those there are.
+*/
+class WindowedFileSource : public ByteSource
+{
+public:
+    static constexpr size_t defaultWindowSize = 64 * 1024;
+
+    // Reads outside the windows are whole blocks of this size, aligned to it.
+    static constexpr size_t blockSize = 256 * 1024;
+
+    enum class Reads
+    {
+        overlapped,     // The tail is read on another thread while this one reads the head.
+        sequential      // Both are read on the calling thread.
+    };
+
+    explicit WindowedFileSource(const juce::File& file, size_t windowSize = defaultWindowSize,
+                                ParseArena* arena = nullptr, Reads reads = Reads::overlapped);
+
+    bool openedOk() const override;
+    juce::uint64 getTotalLength() const override;
+    const char* getBytes(juce::uint64 offset, size_t numBytes) override;
+
+    /* How many reads had to be made outside the two windows. */
+    int getNumExtraReads() const noexcept   { return extraReads.size(); }
+
+private:
+    struct Window
+    {
+        juce::uint64 start = 0;
+        char* data = nullptr;
+        size_t size = 0;
+        juce::HeapBlock<char> ownedData;    // Unused when the data is in an arena.
+
+        const char* find(juce::uint64 offset, size_t numBytes) const noexcept;
+    };
+
+    // Windows are allocated before any reads start, as an arena can only be
+    // used from one thread at a time.
+    void allocateWindow(Window& window, juce::uint64 start, size_t numBytes);
+    bool readWindow(juce::InputStream& source, Window& window);
+
+    ParseArena* arena;
+    juce::FileInputStream stream;
+    juce::uint64 totalLength = 0;
+    Window head, tail;
+    juce::OwnedArray<Window> extraReads;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WindowedFileSource)
+};
@@ -0,0 +1,381 @@
+/*
+  ==============================================================================
+
+    EditJournal.cpp
+
+  ==============================================================================
+*/
+
+#include "EditJournal.h"
+#include "MetadataCache.h"
+
+namespace
+{
+    constexpr int journalMagic = 0x4a455869;   // "iXEJ"
+    constexpr int journalVersion = 1;
+
+    /* FNV-1a, so a record torn by a crash isn't mistaken for a whole one. */
+    juce::uint32 getChecksum(const void* data, size_t numBytes) noexcept
+    {
+        auto hash = (juce::uint32) 2166136261u;
+        auto* bytes = static_cast<const juce::uint8*>(data);
+
+        for (size_t i = 0; i < numBytes; ++i)
+            hash = (hash ^ bytes[i]) * 16777619u;
+
+        return hash;
+    }
+}
+
+//==============================================================================
+EditJournal::EditJournal(const juce::File& fileToUse)
+    : journalFile(fileToUse)
+{
+}
+
+juce::File EditJournal::getDefaultFile()
+{
+    return MetadataCache::getDefaultIndexFile().getSiblingFile("edits.journal");
+}
+
+//==============================================================================
+juce::Result EditJournal::load()
+{
+    juce::FileInputStream in(journalFile);
+
+    if (! in.openedOk())
+        return juce::Result::fail("Could not open the journal " + journalFile.getFullPathName() + ".");
+
+    if (in.readInt() != journalMagic || in.readInt() != journalVersion)
+        return juce::Result::fail(journalFile.getFullPathName() + " isn't an edit journal.");
+
+    const juce::ScopedLock sl(lock);
+    entries.clear();
+
+    for (;;)
+    {
+        auto size = in.readInt();
+
+        if (size <= 0 || in.getNumBytesRemaining() < (juce::int64) size + 4)
+            break;
+
+        juce::MemoryBlock record;
+        in.readIntoMemoryBlock(record, size);
+
+        if ((juce::uint32) in.readInt() != getChecksum(record.getData(), record.getSize()))
+            break;
+
+        juce::MemoryInputStream recordStream(record, false);
+        applyRecord(recordStream);
+    }
+
+    return juce::Result::ok();
+}
+
+void EditJournal::applyRecord(juce::InputStream& in)
+{
+    auto type = in.readInt();
+
+    if (type == runRecord)
+    {
+        runInfo = {};
+        runInfo.root = juce::File(in.readString());
+
+        for (auto numChanges = in.readInt(); --numChanges >= 0;)
+        {
+            auto field = in.readString();
+            runInfo.changes.set(field, in.readString());
+        }
+
+        runInfo.whereField = in.readString();
+        runInfo.whereValue = in.readString();
+        return;
+    }
+
+    auto& entry = entries[in.readString()];
+
+    switch (type)
+    {
+        case beginRecord:
+            entry = {};
+            entry.originalLength = (juce::uint64) in.readInt64();
+
+            for (auto numExtents = in.readInt(); --numExtents >= 0;)
+            {
+                Extent extent;
+                extent.offset = (juce::uint64) in.readInt64();
+                auto numBytes = in.readInt();
+
+                if (numBytes < 0 || in.readIntoMemoryBlock(extent.data, numBytes) != (size_t) numBytes)
+                    break;
+
+                entry.originalBytes.add(std::move(extent));
+            }
+
+            break;
+
+        case commitRecord:
+            entry.state = State::committed;
+            entry.committedSize = in.readInt64();
+            entry.committedModificationTime = in.readInt64();
+            break;
+
+        case unchangedRecord:
+            entry.state = State::unchanged;
+            break;
+
+        case rolledBackRecord:
+            entry.state = State::rolledBack;
+            break;
+
+        default:
+            break;
+    }
+}
+
+juce::Result EditJournal::create(const RunInfo& info)
+{
+    const juce::ScopedLock sl(lock);
+
+    out = nullptr;
+    entries.clear();
+    runInfo = info;
+
+    if (! journalFile.getParentDirectory().createDirectory() || ! journalFile.deleteFile())
+        return juce::Result::fail("Could not create the journal " + journalFile.getFullPathName() + ".");
+
+    out = std::make_unique<juce::FileOutputStream>(journalFile);
+
+    if (! out->openedOk())
+        return juce::Result::fail("Could not create the journal " + journalFile.getFullPathName() + ".");
+
+    out->writeInt(journalMagic);
+    out->writeInt(journalVersion);
+
+    juce::MemoryOutputStream record;
+    record.writeInt(runRecord);
+    record.writeString(info.root.getFullPathName());
+    record.writeInt(info.changes.size());
+
+    for (int i = 0; i < info.changes.size(); ++i)
+    {
+        record.writeString(info.changes.getAllKeys()[i]);
+        record.writeString(info.changes.getAllValues()[i]);
+    }
+
+    record.writeString(info.whereField);
+    record.writeString(info.whereValue);
+
+    return appendRecord(record.getMemoryBlock());
+}
+
+juce::Result EditJournal::reopen()
+{
+    const juce::ScopedLock sl(lock);
+
+    // Anything after the last whole record is cut off first, or records added
+    // now would be lost behind it the next time the journal is read.
+    juce::int64 validLength = 0;
+
+    {
+        juce::FileInputStream in(journalFile);
+
+        if (! in.openedOk())
+            return juce::Result::fail("Could not open the journal " + journalFile.getFullPathName() + ".");
+
+        in.setPosition(8);
+
+        for (;;)
+        {
+            validLength = in.getPosition();
+            auto size = in.readInt();
+
+            if (size <= 0 || in.getNumBytesRemaining() < (juce::int64) size + 4)
+                break;
+
+            juce::MemoryBlock record;
+            in.readIntoMemoryBlock(record, size);
+
+            if ((juce::uint32) in.readInt() != getChecksum(record.getData(), record.getSize()))
+                break;
+        }
+    }
+
+    out = std::make_unique<juce::FileOutputStream>(journalFile);
+
+    if (! out->openedOk() || ! out->setPosition(validLength) || out->truncate().failed())
+        return juce::Result::fail("Could not write to the journal " + journalFile.getFullPathName() + ".");
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+bool EditJournal::getEntry(const juce::File& file, Entry& result) const
+{
+    const juce::ScopedLock sl(lock);
+    auto found = entries.find(file.getFullPathName());
+
+    if (found == entries.end())
+        return false;
+
+    result = found->second;
+    return true;
+}
+
+juce::StringArray EditJournal::getPaths() const
+{
+    const juce::ScopedLock sl(lock);
+    juce::StringArray paths;
+
+    for (const auto& [path, entry] : entries)
+        paths.add(path);
+
+    return paths;
+}
+
+bool EditJournal::hasUnfinishedEdits() const
+{
+    const juce::ScopedLock sl(lock);
+
+    return std::any_of(entries.begin(), entries.end(),
+                       [](const auto& pathAndEntry) { return pathAndEntry.second.state == State::begun; });
+}
+
+//==============================================================================
+juce::Result EditJournal::recordBegin(const juce::File& file, const WavMetadataWriter::Plan& plan)
+{
+    Entry entry;
+    entry.originalLength = plan.originalLength;
+
+    {
+        juce::FileInputStream in(file);
+
+        if (! in.openedOk())
+            return juce::Result::fail("Could not read " + file.getFullPathName() + ".");
+
+        // Only what's there now needs keeping; anything past the old end of
+        // the file goes again when it's cut back to its old length.
+        for (const auto& write : plan.writes)
+        {
+            if (write.offset >= plan.originalLength)
+                continue;
+
+            Extent extent;
+            extent.offset = write.offset;
+
+            auto numBytes = (size_t) juce::jmin((juce::uint64) write.data.getSize(), plan.originalLength - write.offset);
+
+            if (! in.setPosition((juce::int64) write.offset)
+                 || in.readIntoMemoryBlock(extent.data, (juce::ssize_t) numBytes) != numBytes)
+                return juce::Result::fail("Could not read " + file.getFullPathName() + ".");
+
+            entry.originalBytes.add(std::move(extent));
+        }
+    }
+
+    juce::MemoryOutputStream record;
+    record.writeInt(beginRecord);
+    record.writeString(file.getFullPathName());
+    record.writeInt64((juce::int64) entry.originalLength);
+    record.writeInt(entry.originalBytes.size());
+
+    for (const auto& extent : entry.originalBytes)
+    {
+        record.writeInt64((juce::int64) extent.offset);
+        record.writeInt((int) extent.data.getSize());
+        record << extent.data;
+    }
+
+    const juce::ScopedLock sl(lock);
+    entries[file.getFullPathName()] = std::move(entry);
+    return appendRecord(record.getMemoryBlock());
+}
+
+juce::Result EditJournal::recordCommit(const juce::File& file)
+{
+    auto size = file.getSize();
+    auto modificationTime = file.getLastModificationTime().toMilliseconds();
+
+    juce::MemoryOutputStream record;
+    record.writeInt(commitRecord);
+    record.writeString(file.getFullPathName());
+    record.writeInt64(size);
+    record.writeInt64(modificationTime);
+
+    const juce::ScopedLock sl(lock);
+    auto& entry = entries[file.getFullPathName()];
+    entry.state = State::committed;
+    entry.committedSize = size;
+    entry.committedModificationTime = modificationTime;
+    return appendRecord(record.getMemoryBlock());
+}
+
+juce::Result EditJournal::recordUnchanged(const juce::File& file)
+{
+    return recordState(file, unchangedRecord);
+}
+
+juce::Result EditJournal::recordRolledBack(const juce::File& file)
+{
+    return recordState(file, rolledBackRecord);
+}
+
+juce::Result EditJournal::recordState(const juce::File& file, RecordType type)
+{
+    juce::MemoryOutputStream record;
+    record.writeInt(type);
+    record.writeString(file.getFullPathName());
+
+    const juce::ScopedLock sl(lock);
+    entries[file.getFullPathName()].state = type == unchangedRecord ? State::unchanged : State::rolledBack;
+    return appendRecord(record.getMemoryBlock());
+}
+
+/* Writes one record and flushes it to disk. Called with the lock held. */
+juce::Result EditJournal::appendRecord(const juce::MemoryBlock& record)
+{
+    if (out == nullptr)
+        return juce::Result::fail("The journal isn't open for writing.");
+
+    out->writeInt((int) record.getSize());
+    out->write(record.getData(), record.getSize());
+    out->writeInt((int) getChecksum(record.getData(), record.getSize()));
+    out->flush();
+
+    if (out->getStatus().failed())
+        return juce::Result::fail("Could not write to the journal: " + out->getStatus().getErrorMessage());
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+juce::Result EditJournal::restore(const juce::File& file, const Entry& entry)
+{
+    juce::FileOutputStream out(file);
+
+    if (! out.openedOk())
+        return juce::Result::fail("Could not open " + file.getFullPathName() + " for writing.");
+
+    // Every extent holds the bytes from before the edit, so the order doesn't
+    // matter even where they overlap.
+    for (const auto& extent : entry.originalBytes)
+    {
+        if (! out.setPosition((juce::int64) extent.offset) || ! out.write(extent.data.getData(), extent.data.getSize()))
+            return juce::Result::fail("Could not write to " + file.getFullPathName() + ".");
+    }
+
+    if ((juce::uint64) file.getSize() > entry.originalLength)
+    {
+        out.flush();
+
+        if (! out.setPosition((juce::int64) entry.originalLength) || out.truncate().failed())
+            return juce::Result::fail("Could not change the length of " + file.getFullPathName() + ".");
+    }
+
+    out.flush();
+
+    if (out.getStatus().failed())
+        return juce::Result::fail("Could not write to " + file.getFullPathName() + ": " + out.getStatus().getErrorMessage());
+
+    return juce::Result::ok();
+}
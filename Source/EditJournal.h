@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    EditJournal.h
+
+    A write-ahead journal for batch edits. Before a file is changed, the
+    bytes about to be overwritten and the file's old length are appended to
+    the journal and flushed; once the change is made, a commit record
+    follows. Reading the journal back after a crash tells which files were
+    finished, which were never touched and which were caught part-way, and
+    gives what's needed to put the last kind back as they were, without
+    looking at any of the files. Only depends on juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WavMetadataWriter.h"
+#include <map>
+
+//==============================================================================
+class EditJournal
+{
+public:
+    //==============================================================================
+    /* What a run was asked to do, recorded at the start of the journal so it
+       can be resumed without being asked again. */
+    struct RunInfo
+    {
+        juce::File root;
+        juce::StringPairArray changes;      // Field name -> new value.
+        juce::String whereField, whereValue;
+    };
+
+    /* The old contents of a byte range that an edit overwrites. */
+    struct Extent
+    {
+        juce::uint64 offset = 0;
+        juce::MemoryBlock data;
+    };
+
+    enum class State
+    {
+        begun,          // About to be changed, and may have been partly.
+        committed,      // Changed completely.
+        unchanged,      // Looked at and needed no change.
+        rolledBack      // Put back as it was.
+    };
+
+    struct Entry
+    {
+        State state = State::begun;
+        juce::uint64 originalLength = 0;
+        juce::Array<Extent> originalBytes;
+
+        // The file's size and modification time once committed, so a rollback
+        // can tell if the file has been changed by someone else since.
+        juce::int64 committedSize = 0;
+        juce::int64 committedModificationTime = 0;
+    };
+
+    //==============================================================================
+    explicit EditJournal(const juce::File& journalFile);
+
+    /* The journal in the user's application data directory. */
+    static juce::File getDefaultFile();
+
+    /* Reads an existing journal. A record torn by a crash halfway through
+       writing it is ignored, along with anything after it. */
+    juce::Result load();
+
+    /* Starts a new, empty journal for a run, replacing any old one. */
+    juce::Result create(const RunInfo& info);
+
+    /* Opens a loaded journal for more records, e.g. to resume its run. */
+    juce::Result reopen();
+
+    const RunInfo& getRunInfo() const noexcept      { return runInfo; }
+
+    /* Copies the latest record for a file, returning false if there's none. Thread-safe. */
+    bool getEntry(const juce::File& file, Entry& result) const;
+
+    /* Every file with a record, in no particular order. Not thread-safe. */
+    juce::StringArray getPaths() const;
+
+    /* True if a run was interrupted: some file was begun and never committed or rolled back. */
+    bool hasUnfinishedEdits() const;
+
+    //==============================================================================
+    /* Records the bytes a plan is going to overwrite, read from the file.
+       Must be called, and succeed, before the plan is applied. Thread-safe. */
+    juce::Result recordBegin(const juce::File& file, const WavMetadataWriter::Plan& plan);
+
+    /* Each of these records what happened to a file. Thread-safe. */
+    juce::Result recordCommit(const juce::File& file);
+    juce::Result recordUnchanged(const juce::File& file);
+    juce::Result recordRolledBack(const juce::File& file);
+
+    /* Puts a file back the way it was before the entry's edit. */
+    static juce::Result restore(const juce::File& file, const Entry& entry);
+
+private:
+    //==============================================================================
+    enum RecordType
+    {
+        runRecord = 1,
+        beginRecord,
+        commitRecord,
+        unchangedRecord,
+        rolledBackRecord
+    };
+
+    juce::Result appendRecord(const juce::MemoryBlock& record);
+    void applyRecord(juce::InputStream& in);
+    juce::Result recordState(const juce::File& file, RecordType type);
+
+    juce::File journalFile;
+    RunInfo runInfo;
+
+    mutable juce::CriticalSection lock;
+    std::map<juce::String, Entry> entries;
+    std::unique_ptr<juce::FileOutputStream> out;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EditJournal)
+};
@@ -0,0 +1,488 @@
+/*
+  ==============================================================================
+
+    FolderWatcher.cpp
+
+  ==============================================================================
+*/
+
+#include "FolderWatcher.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #include <windows.h>
+#endif
+
+namespace
+{
+    enum class WatchResult
+    {
+        changed,        // Some paths were touched.
+        overflowed,     // Too much happened at once to say what, so the tree needs listing again.
+        timedOut,
+        stopped,
+        failed          // The watch is no longer working.
+    };
+}
+
+//==============================================================================
+#if JUCE_WINDOWS
+/*
+    An overlapped ReadDirectoryChangesW over the whole tree. Waiting on it
+    blocks in the kernel until something changes, the timeout runs out or
+    stop() is called, so an idle watch costs nothing at all.
+*/
+class FolderWatcher::NativeWatch
+{
+public:
+    explicit NativeWatch(const juce::File& rootToWatch)
+        : root(rootToWatch),
+          buffer(bufferSize / sizeof(DWORD), true)
+    {
+        directory = CreateFileW(root.getFullPathName().toWideCharPointer(), FILE_LIST_DIRECTORY,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+
+        changeEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+        isWatching = directory != INVALID_HANDLE_VALUE && changeEvent != nullptr && stopEvent != nullptr
+                      && startRead();
+    }
+
+    ~NativeWatch()
+    {
+        if (isWatching)
+        {
+            // The read has to be finished with before its buffer goes away.
+            DWORD numBytes = 0;
+            CancelIoEx(directory, &overlapped);
+            GetOverlappedResult(directory, &overlapped, &numBytes, TRUE);
+        }
+
+        if (directory != INVALID_HANDLE_VALUE)  CloseHandle(directory);
+        if (changeEvent != nullptr)             CloseHandle(changeEvent);
+        if (stopEvent != nullptr)               CloseHandle(stopEvent);
+    }
+
+    bool isOpen() const noexcept    { return isWatching; }
+
+    /* Waits for a change, adding the paths that were touched. A negative
+       timeout waits until something happens. */
+    WatchResult wait(int timeoutMilliseconds, juce::Array<juce::File>& touched)
+    {
+        HANDLE handles[] = { changeEvent, stopEvent };
+        auto waitResult = WaitForMultipleObjects(2, handles, FALSE, timeoutMilliseconds < 0 ? INFINITE : (DWORD) timeoutMilliseconds);
+
+        if (waitResult == WAIT_TIMEOUT)
+            return WatchResult::timedOut;
+
+        if (waitResult != WAIT_OBJECT_0)
+            return WatchResult::stopped;
+
+        DWORD numBytes = 0;
+        auto result = WatchResult::changed;
+
+        if (! GetOverlappedResult(directory, &overlapped, &numBytes, FALSE))
+        {
+            if (GetLastError() != ERROR_NOTIFY_ENUM_DIR)
+            {
+                isWatching = false;
+                return WatchResult::failed;
+            }
+
+            result = WatchResult::overflowed;
+        }
+        else if (numBytes == 0)
+        {
+            // The buffer filled up before we got to it.
+            result = WatchResult::overflowed;
+        }
+        else
+        {
+            readNotifications(numBytes, touched);
+        }
+
+        // The buffer has been read, so it can take the next batch.
+        if (! startRead())
+        {
+            isWatching = false;
+            return WatchResult::failed;
+        }
+
+        return result;
+    }
+
+    void signalStop()
+    {
+        if (stopEvent != nullptr)
+            SetEvent(stopEvent);
+    }
+
+private:
+    // Network shares can't return more than 64 KB at a time.
+    static constexpr DWORD bufferSize = 64 * 1024;
+
+    bool startRead()
+    {
+        std::memset(&overlapped, 0, sizeof(overlapped));
+        overlapped.hEvent = changeEvent;
+        ResetEvent(changeEvent);
+
+        return ReadDirectoryChangesW(directory, buffer.getData(), bufferSize, TRUE,
+                                     FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME
+                                      | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE,
+                                     nullptr, &overlapped, nullptr) != 0;
+    }
+
+    void readNotifications(DWORD numBytes, juce::Array<juce::File>& touched) const
+    {
+        auto* data = reinterpret_cast<const char*>(buffer.getData());
+
+        for (DWORD offset = 0; offset + sizeof(FILE_NOTIFY_INFORMATION) <= numBytes;)
+        {
+            auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(data + offset);
+
+            // Names are relative to the root, and not null-terminated. Both
+            // halves of a rename come through, so the old name is seen to
+            // have gone and the new one to have arrived.
+            juce::String name(juce::CharPointer_UTF16(reinterpret_cast<const juce::CharPointer_UTF16::CharType*>(info->FileName)),
+                              (size_t) (info->FileNameLength / sizeof(WCHAR)));
+
+            if (name.isNotEmpty())
+                touched.addIfNotAlreadyThere(root.getChildFile(name));
+
+            if (info->NextEntryOffset == 0)
+                break;
+
+            offset += info->NextEntryOffset;
+        }
+    }
+
+    juce::File root;
+    HANDLE directory = INVALID_HANDLE_VALUE;
+    HANDLE changeEvent = nullptr, stopEvent = nullptr;
+    OVERLAPPED overlapped {};
+    juce::HeapBlock<DWORD> buffer;      // DWORD-aligned, as ReadDirectoryChangesW needs.
+    bool isWatching = false;
+
+    JUCE_DECLARE_NON_COPYABLE(NativeWatch)
+};
+#else
+/* No notifications on other platforms yet, so the tree is always listed. */
+class FolderWatcher::NativeWatch
+{
+public:
+    explicit NativeWatch(const juce::File&) {}
+
+    bool isOpen() const noexcept                                { return false; }
+    WatchResult wait(int, juce::Array<juce::File>&)             { return WatchResult::failed; }
+    void signalStop()                                           {}
+
+    JUCE_DECLARE_NON_COPYABLE(NativeWatch)
+};
+#endif
+
+//==============================================================================
+FolderWatcher::FolderWatcher(const Options& optionsToUse, Callback onChanges)
+    : juce::Thread("Folder watcher"),
+      options(optionsToUse),
+      callback(std::move(onChanges))
+{
+}
+
+FolderWatcher::~FolderWatcher()
+{
+    stop();
+}
+
+void FolderWatcher::start()
+{
+    if (isThreadRunning())
+        return;
+
+    // The watch is opened before the tree is listed, so nothing that arrives
+    // while the listing is being made can be missed.
+    nativeWatch.reset();
+
+    if (! options.forcePolling)
+        nativeWatch = std::make_unique<NativeWatch>(options.root);
+
+    usingNotifications = nativeWatch != nullptr && nativeWatch->isOpen();
+
+    known = listTree();
+    pending.clear();
+
+    startThread();
+}
+
+void FolderWatcher::stop()
+{
+    signalThreadShouldExit();
+
+    if (nativeWatch != nullptr)
+        nativeWatch->signalStop();
+
+    notify();
+    stopThread(5000);
+}
+
+//==============================================================================
+void FolderWatcher::run()
+{
+    auto nextPoll = juce::Time::getMillisecondCounter() + (juce::uint32) options.pollIntervalMilliseconds;
+
+    while (! threadShouldExit())
+    {
+        Changes changes;
+        auto timeout = getWaitTime(nextPoll);
+
+        if (usingNotifications)
+        {
+            juce::Array<juce::File> touched;
+
+            switch (nativeWatch->wait(timeout, touched))
+            {
+                case WatchResult::changed:
+                    for (const auto& file : touched)
+                        noteChanged(file, changes);
+                    break;
+
+                case WatchResult::overflowed:
+                    rescan(changes);
+                    break;
+
+                case WatchResult::failed:
+                    // Fall back to listing the tree from now on, starting with
+                    // a listing in case the failure hid something.
+                    usingNotifications = false;
+                    rescan(changes);
+                    nextPoll = juce::Time::getMillisecondCounter() + (juce::uint32) options.pollIntervalMilliseconds;
+                    break;
+
+                case WatchResult::timedOut:
+                case WatchResult::stopped:
+                    break;
+            }
+        }
+        else
+        {
+            wait(timeout);
+
+            auto now = juce::Time::getMillisecondCounter();
+
+            if (! threadShouldExit() && (juce::int32) (now - nextPoll) >= 0)
+            {
+                rescan(changes);
+                nextPoll = now + (juce::uint32) options.pollIntervalMilliseconds;
+            }
+        }
+
+        if (threadShouldExit())
+            break;
+
+        checkPending(changes);
+
+        if (callback != nullptr && (! changes.changed.isEmpty() || ! changes.removed.isEmpty()))
+            callback(changes);
+    }
+}
+
+int FolderWatcher::getWaitTime(juce::uint32 nextPoll) const
+{
+    auto now = juce::Time::getMillisecondCounter();
+    int timeout = -1;
+
+    auto waitUntil = [&](juce::uint32 time)
+        {
+            auto remaining = juce::jmax(0, (int) (juce::int32) (time - now));
+            timeout = timeout < 0 ? remaining : juce::jmin(timeout, remaining);
+        };
+
+    for (const auto& [path, entry] : pending)
+        waitUntil(entry.lastChange + (juce::uint32) options.settleMilliseconds);
+
+    if (! usingNotifications)
+        waitUntil(nextPoll);
+
+    // Nothing pending and notifications working means there's no reason to
+    // wake up at all until something happens.
+    return timeout;
+}
+
+//==============================================================================
+bool FolderWatcher::isWatchedFile(const juce::File& file) const
+{
+    return file.hasFileExtension("wav");
+}
+
+std::map<juce::String, FolderWatcher::Stamp> FolderWatcher::listTree() const
+{
+    std::map<juce::String, Stamp> files;
+
+    // The directory entries carry the size and time, so no file is opened or stat'ed.
+    for (const auto& entry : juce::RangedDirectoryIterator(options.root, true, "*", juce::File::findFiles))
+        if (isWatchedFile(entry.getFile()))
+            files[entry.getFile().getFullPathName()] = { entry.getFileSize(), entry.getModificationTime().toMilliseconds() };
+
+    return files;
+}
+
+FolderWatcher::Stamp FolderWatcher::getStamp(const juce::File& file)
+{
+    return { file.getSize(), file.getLastModificationTime().toMilliseconds() };
+}
+
+//==============================================================================
+void FolderWatcher::noteChanged(const juce::File& file, Changes& changes)
+{
+    if (file.isDirectory())
+    {
+        // A folder that's been moved or copied in only gets the one
+        // notification, so whatever's inside it has to be looked for.
+        for (const auto& entry : juce::RangedDirectoryIterator(file, true, "*", juce::File::findFiles))
+            if (isWatchedFile(entry.getFile()))
+                noteChanged(entry.getFile(), changes);
+
+        return;
+    }
+
+    if (! file.existsAsFile())
+    {
+        noteRemoved(file.getFullPathName(), changes);
+        return;
+    }
+
+    if (! isWatchedFile(file))
+        return;
+
+    // Every notification restarts the clock, so a file is only reported
+    // once whatever was writing it has gone quiet.
+    auto& entry = pending[file.getFullPathName()];
+    entry.stamp = getStamp(file);
+    entry.lastChange = juce::Time::getMillisecondCounter();
+}
+
+void FolderWatcher::noteRemoved(const juce::String& path, Changes& changes)
+{
+    pending.erase(path);
+
+    auto found = known.find(path);
+
+    if (found != known.end())
+    {
+        changes.removed.add(juce::File(path));
+        known.erase(found);
+        return;
+    }
+
+    // It may have been a folder, in which case everything in it has gone too.
+    auto prefix = path + juce::File::getSeparatorString();
+
+    for (auto it = pending.lower_bound(prefix); it != pending.end() && it->first.startsWith(prefix);)
+        it = pending.erase(it);
+
+    for (auto it = known.lower_bound(prefix); it != known.end() && it->first.startsWith(prefix);)
+    {
+        changes.removed.add(juce::File(it->first));
+        it = known.erase(it);
+    }
+}
+
+void FolderWatcher::rescan(Changes& changes)
+{
+    auto current = listTree();
+    auto now = juce::Time::getMillisecondCounter();
+
+    for (auto it = known.begin(); it != known.end();)
+    {
+        if (current.find(it->first) == current.end())
+        {
+            changes.removed.add(juce::File(it->first));
+            it = known.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    for (auto it = pending.begin(); it != pending.end();)
+    {
+        if (current.find(it->first) == current.end())
+            it = pending.erase(it);
+        else
+            ++it;
+    }
+
+    for (const auto& [path, stamp] : current)
+    {
+        auto isKnown = known.find(path);
+
+        if (isKnown != known.end() && isKnown->second == stamp)
+            continue;
+
+        // Only restart the clock if the file is still changing, or a listing
+        // that comes round sooner than the settle time would hold it back forever.
+        auto found = pending.find(path);
+
+        if (found == pending.end() || found->second.stamp != stamp)
+            pending[path] = { stamp, now };
+    }
+}
+
+void FolderWatcher::checkPending(Changes& changes)
+{
+    auto now = juce::Time::getMillisecondCounter();
+    juce::StringArray gone;
+
+    for (auto it = pending.begin(); it != pending.end();)
+    {
+        auto& entry = it->second;
+
+        if ((juce::int32) (now - entry.lastChange) < options.settleMilliseconds)
+        {
+            ++it;
+            continue;
+        }
+
+        juce::File file(it->first);
+
+        if (! file.existsAsFile())
+        {
+            gone.add(it->first);
+            ++it;
+            continue;
+        }
+
+        auto stamp = getStamp(file);
+
+        if (stamp != entry.stamp)
+        {
+            // Still being written, even though nothing said so.
+            entry.stamp = stamp;
+            entry.lastChange = now;
+            ++it;
+            continue;
+        }
+
+        // A file that was touched but is exactly as it was last reported isn't news.
+        auto found = known.find(it->first);
+
+        if (found == known.end() || found->second != stamp)
+        {
+            known[it->first] = stamp;
+            changes.changed.add(file);
+        }
+
+        it = pending.erase(it);
+    }
+
+    for (const auto& path : gone)
+        noteRemoved(path, changes);
+}
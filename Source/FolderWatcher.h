@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    FolderWatcher.h
+
+    Watches a folder tree for WAV files arriving, changing or going away, and
+    reports each one once it has stopped changing, so a file that's still
+    being copied or recorded isn't parsed half-written.
+
+    On Windows the watch uses directory change notifications, so nothing at
+    all happens between arrivals. Elsewhere, or on volumes that don't support
+    notifications (some network shares), the tree is listed again every so
+    often instead, which only costs a directory walk. Only depends on juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+
+//==============================================================================
+class FolderWatcher : private juce::Thread
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        juce::File root;
+
+        // A file is reported once its size and modification time have stayed
+        // the same for this long.
+        int settleMilliseconds = 2000;
+
+        // How often the tree is listed when there are no notifications.
+        int pollIntervalMilliseconds = 10000;
+
+        // Lists the tree even where notifications are available.
+        bool forcePolling = false;
+    };
+
+    struct Changes
+    {
+        juce::Array<juce::File> changed;    // New, or different since they were last reported.
+        juce::Array<juce::File> removed;
+    };
+
+    /* Called on the watcher's own thread whenever there's something to report. */
+    using Callback = std::function<void(const Changes&)>;
+
+    //==============================================================================
+    FolderWatcher(const Options& options, Callback onChanges);
+    ~FolderWatcher() override;
+
+    /* Starts watching. Files already in the tree are taken as they are, and
+       only reported if they change from then on. */
+    void start();
+
+    /* Stops watching and waits for the thread to finish. */
+    void stop();
+
+    /* False if the watch fell back to listing the tree. */
+    bool isUsingNotifications() const noexcept      { return usingNotifications; }
+
+private:
+    //==============================================================================
+    struct Stamp
+    {
+        juce::int64 size = 0;
+        juce::int64 modificationTime = 0;
+
+        bool operator==(const Stamp& other) const noexcept  { return size == other.size && modificationTime == other.modificationTime; }
+        bool operator!=(const Stamp& other) const noexcept  { return ! operator==(other); }
+    };
+
+    struct Pending
+    {
+        Stamp stamp;
+        juce::uint32 lastChange = 0;    // Millisecond counter.
+    };
+
+    class NativeWatch;
+
+    void run() override;
+
+    bool isWatchedFile(const juce::File& file) const;
+    std::map<juce::String, Stamp> listTree() const;
+    static Stamp getStamp(const juce::File& file);
+
+    void noteChanged(const juce::File& file, Changes& changes);
+    void noteRemoved(const juce::String& path, Changes& changes);
+    void rescan(Changes& changes);
+    void checkPending(Changes& changes);
+    int getWaitTime(juce::uint32 nextPoll) const;
+
+    Options options;
+    Callback callback;
+    std::unique_ptr<NativeWatch> nativeWatch;
+    std::atomic<bool> usingNotifications { false };
+
+    // Both only touched by the watcher thread, once it's started.
+    std::map<juce::String, Stamp> known;        // As last reported.
+    std::map<juce::String, Pending> pending;    // Changed, but not settled yet.
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FolderWatcher)
+};
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    FourCC.h
+
+    RIFF chunk ids as 32-bit tags. A tag holds the four id bytes in file
+    order read as a little-endian int, so a header's id turns into its tag
+    with a single load, and the tags of the ids we know about are compile-
+    time constants. Comparing chunk ids is then one integer compare, with no
+    strings or memcmp involved. Only depends on juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+namespace FourCC
+{
+    /* The tag of a four-character id literal, e.g. make("fmt "). */
+    constexpr juce::uint32 make(const char (&id)[5]) noexcept
+    {
+        return (juce::uint32) (unsigned char) id[0]
+             | ((juce::uint32) (unsigned char) id[1] << 8)
+             | ((juce::uint32) (unsigned char) id[2] << 16)
+             | ((juce::uint32) (unsigned char) id[3] << 24);
+    }
+
+    /* The tag of four id bytes as they appear in a file. */
+    inline juce::uint32 read(const void* id) noexcept
+    {
+        return juce::ByteOrder::littleEndianInt(id);
+    }
+
+    /* Writes a tag's four id bytes out in file order. */
+    inline void write(juce::uint32 tag, void* destination) noexcept
+    {
+        auto littleEndian = juce::ByteOrder::swapIfBigEndian(tag);
+        std::memcpy(destination, &littleEndian, 4);
+    }
+
+    /* Four id bytes from a file, for display. They can be anything, so bytes
+       outside printable ASCII are written as \xNN rather than handed to
+       juce::String as they are, which would assert on them or stop at a null. */
+    inline juce::String idToString(const void* id)
+    {
+        juce::String text;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            auto byte = static_cast<const juce::uint8*>(id)[i];
+
+            if (byte >= 0x20 && byte < 0x7f && byte != '\\')
+                text << (char) byte;
+            else
+                text << "\\x" << juce::String::toHexString((int) byte).paddedLeft('0', 2);
+        }
+
+        return text;
+    }
+
+    inline juce::String toString(juce::uint32 tag)
+    {
+        char id[4];
+        write(tag, id);
+        return idToString(id);
+    }
+
+    //==============================================================================
+    constexpr auto riff = make("RIFF");
+    constexpr auto rf64 = make("RF64");
+    constexpr auto bw64 = make("BW64");
+    constexpr auto wave = make("WAVE");
+
+    constexpr auto ds64 = make("ds64");
+    constexpr auto fmt  = make("fmt ");
+    constexpr auto data = make("data");
+    constexpr auto bext = make("bext");
+    constexpr auto iXML = make("iXML");
+    constexpr auto axml = make("axml");
+    constexpr auto chna = make("chna");
+    constexpr auto xmp  = make("_PMX");
+    constexpr auto list = make("LIST");
+    constexpr auto info = make("INFO");
+    constexpr auto cue  = make("cue ");
+
+    // Padding, which a writer can reuse.
+    constexpr auto junk = make("JUNK");
+    constexpr auto fllr = make("FLLR");
+    constexpr auto pad  = make("PAD ");
+
+    static_assert(fmt == 0x20746d66, "Tags should hold the id bytes in little-endian order");
+}
@@ -0,0 +1,317 @@
+/*
+  ==============================================================================
+
+    HttpRangeSource.cpp
+
+  ==============================================================================
+*/
+
+#include "HttpRangeSource.h"
+
+namespace
+{
+    /* Threads for the requests that overlap another one, unless the options
+       give a pool of their own. They spend nearly all their time waiting on
+       the network, so there are more of them than in the file sources' pool. */
+    juce::ThreadPool& getSharedRequestPool()
+    {
+        static juce::ThreadPool pool(16);
+        return pool;
+    }
+
+    /* Parses a "bytes first-last/length" Content-Range value. The length may
+       be "*", for unknown, in which case it's left at -1. */
+    bool parseContentRange(const juce::String& value, juce::uint64& first, juce::uint64& last, juce::int64& length)
+    {
+        auto spec = value.trim();
+
+        if (! spec.startsWithIgnoreCase("bytes "))
+            return false;
+
+        spec = spec.substring(6).trim();
+
+        auto firstText = spec.upToFirstOccurrenceOf("-", false, false).trim();
+        auto lastText = spec.fromFirstOccurrenceOf("-", false, false).upToFirstOccurrenceOf("/", false, false).trim();
+        auto lengthText = spec.fromFirstOccurrenceOf("/", false, false).trim();
+
+        auto isNumber = [](const juce::String& text)
+            {
+                return text.isNotEmpty() && text.containsOnly("0123456789");
+            };
+
+        if (! isNumber(firstText) || ! isNumber(lastText))
+            return false;
+
+        first = (juce::uint64) firstText.getLargeIntValue();
+        last = (juce::uint64) lastText.getLargeIntValue();
+        length = isNumber(lengthText) ? lengthText.getLargeIntValue() : -1;
+
+        return last >= first;
+    }
+}
+
+//==============================================================================
+const char* HttpRangeSource::Window::find(juce::uint64 offset, size_t numBytes) const noexcept
+{
+    if (data == nullptr || offset < start || offset - start > size || numBytes > size - (size_t) (offset - start))
+        return nullptr;
+
+    return data + (offset - start);
+}
+
+HttpRangeSource::HttpRangeSource(const juce::URL& urlToRead, const Options& optionsToUse)
+    : url(urlToRead),
+      options(optionsToUse)
+{
+    auto windowSize = juce::jmax((size_t) 1, options.windowSize);
+
+    // Ask for the tail as a suffix range on another thread while this one
+    // asks for the head, so opening costs one round-trip and we needn't know
+    // the length first. We wait for it before returning, so it's safe for
+    // the job to refer to our members.
+    juce::WaitableEvent tailFinished;
+
+    getRequestPool().addJob([&]
+        {
+            fetch("bytes=-" + juce::String(windowSize), windowSize, tail);
+            tailFinished.signal();
+        });
+
+    fetch("bytes=0-" + juce::String(windowSize - 1), windowSize, head);
+    tailFinished.wait();
+
+    statusCode = head.statusCode;
+
+    if (head.size == 0)
+        return;
+
+    auto length = head.objectLength >= 0 ? head.objectLength : tail.objectLength;
+
+    if (length <= 0)
+        return;
+
+    totalLength = (juce::uint64) length;
+    rangesSupported = ! head.rangeIgnored;
+
+    // A server that ignored the range sent the start of the object again.
+    if (tail.rangeIgnored)
+    {
+        tail.data.free();
+        tail.size = 0;
+    }
+}
+
+bool HttpRangeSource::openedOk() const
+{
+    return totalLength > 0;
+}
+
+juce::uint64 HttpRangeSource::getTotalLength() const
+{
+    return totalLength;
+}
+
+const char* HttpRangeSource::getBytes(juce::uint64 offset, size_t numBytes)
+{
+    if (! openedOk() || offset > totalLength || numBytes > totalLength - offset)
+        return nullptr;
+
+    if (auto* found = findInWindows(offset, numBytes))
+        return found;
+
+    if (! rangesSupported)
+        return nullptr;
+
+    // As with a file, the next thing asked for is usually just after this,
+    // so fetch the aligned blocks around it. Earlier views must stay valid,
+    // so each read gets a block of its own.
+    auto blockSize = (juce::uint64) juce::jmax((size_t) 1, options.blockSize);
+    auto start = offset / blockSize * blockSize;
+    auto end = juce::jmin(totalLength, (offset + numBytes + blockSize - 1) / blockSize * blockSize);
+
+    auto* extra = extraReads.add(new Window());
+
+    const ParseTimings::ScopedTimer timer(timings, ParseTimings::io);
+
+    if (! fetchRange(start, end, *extra))
+        return nullptr;
+
+    return extra->find(offset, numBytes);
+}
+
+void HttpRangeSource::prefetch(const juce::Array<juce::Range<juce::uint64>>& ranges)
+{
+    if (! openedOk() || ! rangesSupported)
+        return;
+
+    juce::Array<juce::Range<juce::uint64>> missing;
+
+    for (auto range : ranges)
+    {
+        range = range.getIntersectionWith({ 0, totalLength });
+
+        if (! range.isEmpty() && findInWindows(range.getStart(), (size_t) range.getLength()) == nullptr)
+            missing.add(range);
+    }
+
+    if (missing.isEmpty())
+        return;
+
+    std::sort(missing.begin(), missing.end(), [](const auto& a, const auto& b)
+        {
+            return a.getStart() < b.getStart();
+        });
+
+    juce::Array<juce::Range<juce::uint64>> requests { missing.getFirst() };
+
+    for (int i = 1; i < missing.size(); ++i)
+    {
+        auto& last = requests.getReference(requests.size() - 1);
+
+        if (missing[i].getStart() <= last.getEnd() + options.mergeGap)
+            last = last.getUnionWith(missing[i]);
+        else
+            requests.add(missing[i]);
+    }
+
+    const ParseTimings::ScopedTimer timer(timings, ParseTimings::io);
+
+    // The windows are all added before any request starts, so the array
+    // isn't changed while the other threads are filling them in.
+    auto firstWindow = extraReads.size();
+
+    for (int i = 0; i < requests.size(); ++i)
+        extraReads.add(new Window());
+
+    // Everything but the first request goes to the pool, and this thread
+    // makes the first itself. A request that fails just leaves its window
+    // empty, and getBytes() tries again for whatever is asked for.
+    std::atomic<int> numPending { requests.size() - 1 };
+    juce::WaitableEvent allFinished;
+
+    for (int i = 1; i < requests.size(); ++i)
+    {
+        getRequestPool().addJob([&, i]
+            {
+                fetchRange(requests[i].getStart(), requests[i].getEnd(), *extraReads[firstWindow + i]);
+
+                if (--numPending == 0)
+                    allFinished.signal();
+            });
+    }
+
+    fetchRange(requests[0].getStart(), requests[0].getEnd(), *extraReads[firstWindow]);
+
+    if (requests.size() > 1)
+        allFinished.wait();
+}
+
+//==============================================================================
+juce::ThreadPool& HttpRangeSource::getRequestPool() const
+{
+    return options.requestPool != nullptr ? *options.requestPool : getSharedRequestPool();
+}
+
+bool HttpRangeSource::fetch(const juce::String& range, size_t maxBytes, Window& window)
+{
+    ++numRequests;
+
+    auto fail = [&window]
+        {
+            window.data.free();
+            window.size = 0;
+            return false;
+        };
+
+    juce::StringPairArray responseHeaders;
+
+    auto requestOptions = juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inAddress)
+                              .withExtraHeaders("Range: " + range + "\r\n" + options.extraHeaders)
+                              .withConnectionTimeoutMs(options.timeoutMilliseconds)
+                              .withResponseHeaders(&responseHeaders)
+                              .withStatusCode(&window.statusCode);
+
+    auto stream = url.createInputStream(requestOptions);
+
+    if (stream == nullptr)
+        return fail();
+
+    auto expected = maxBytes;
+    auto lengthKnown = true;
+
+    if (window.statusCode == 206)
+    {
+        juce::uint64 first = 0, last = 0;
+
+        if (! parseContentRange(responseHeaders["Content-Range"], first, last, window.objectLength))
+            return fail();
+
+        window.start = first;
+        expected = (size_t) juce::jmin((juce::uint64) maxBytes, last - first + 1);
+    }
+    else if (window.statusCode == 200)
+    {
+        // The range was ignored, so this is the whole object from the start.
+        window.rangeIgnored = true;
+        window.start = 0;
+        window.objectLength = stream->getTotalLength();
+        lengthKnown = window.objectLength >= 0;
+
+        if (lengthKnown)
+            expected = (size_t) juce::jmin((juce::int64) maxBytes, window.objectLength);
+    }
+    else
+    {
+        return fail();
+    }
+
+    window.data.malloc(juce::jmax((size_t) 1, expected));
+
+    size_t numRead = 0;
+
+    while (numRead < expected)
+    {
+        auto chunkSize = (int) juce::jmin(expected - numRead, (size_t) 1 << 20);
+        auto bytesRead = stream->read(window.data + numRead, chunkSize);
+
+        if (bytesRead <= 0)
+            break;
+
+        numRead += (size_t) bytesRead;
+    }
+
+    numBytesRead.fetch_add(numRead, std::memory_order_relaxed);
+
+    if (numRead < expected)
+    {
+        // Without a length, running out early just means we have it all.
+        if (lengthKnown)
+            return fail();
+
+        window.objectLength = (juce::int64) numRead;
+    }
+
+    window.size = numRead;
+    return numRead > 0;
+}
+
+bool HttpRangeSource::fetchRange(juce::uint64 start, juce::uint64 end, Window& window)
+{
+    return fetch("bytes=" + juce::String(start) + "-" + juce::String(end - 1), (size_t) (end - start), window)
+            && ! window.rangeIgnored && window.start == start;
+}
+
+const char* HttpRangeSource::findInWindows(juce::uint64 offset, size_t numBytes) const
+{
+    if (auto* inHead = head.find(offset, numBytes))
+        return inHead;
+
+    if (auto* inTail = tail.find(offset, numBytes))
+        return inTail;
+
+    for (auto* extra : extraReads)
+        if (auto* inExtra = extra->find(offset, numBytes))
+            return inExtra;
+
+    return nullptr;
+}
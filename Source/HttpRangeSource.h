@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    HttpRangeSource.h
+
+    Reads a WAV file held on a web server or in object storage (e.g. through
+    a presigned S3 or GCS URL) with HTTP range requests, so only the bytes
+    the chunk walk needs ever cross the network.
+
+    It works like WindowedFileSource: opening the source asks for the first
+    and last few kilobytes at the same time, the tail as a suffix range so
+    the object's length needn't be known first. Most files need nothing
+    else. What the reader asks for beyond that is fetched in aligned blocks,
+    and the metadata payloads it announces through prefetch() are merged
+    where they lie close together and fetched concurrently, so a file whose
+    chunks are spread out still takes a round-trip or two rather than one
+    per chunk.
+
+    A server that ignores the Range header sends the whole object instead;
+    only its first window is kept in that case, and nothing outside it can
+    be read.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ByteSource.h"
+
+//==============================================================================
+class HttpRangeSource : public ByteSource
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        size_t windowSize = WindowedFileSource::defaultWindowSize;
+
+        // Reads outside the windows are whole blocks of this size, aligned to it.
+        size_t blockSize = WindowedFileSource::blockSize;
+
+        // Prefetched ranges closer together than this share a request: past a
+        // few hundred KB, another round-trip is cheaper than the extra bytes.
+        size_t mergeGap = 256 * 1024;
+
+        int timeoutMilliseconds = 15000;
+
+        // Sent with every request, one "Name: value" per line, e.g. for an
+        // Authorization header.
+        juce::String extraHeaders;
+
+        // If set, runs the requests that overlap another one instead of the
+        // small pool shared by the whole process. Anything opening many
+        // sources at once should give them a pool with at least a thread per
+        // source, or some of them wait an extra round-trip on it. It must
+        // outlive the sources.
+        juce::ThreadPool* requestPool = nullptr;
+    };
+
+    //==============================================================================
+    explicit HttpRangeSource(const juce::URL& url, const Options& options = {});
+
+    bool openedOk() const override;
+    juce::uint64 getTotalLength() const override;
+    const char* getBytes(juce::uint64 offset, size_t numBytes) override;
+    void prefetch(const juce::Array<juce::Range<juce::uint64>>& ranges) override;
+
+    /* The HTTP status of the first request, or 0 if no response came back. */
+    int getStatusCode() const noexcept      { return statusCode; }
+
+    /* How many requests have been made, including the two made on opening. */
+    int getNumRequests() const noexcept     { return numRequests.load(); }
+
+private:
+    //==============================================================================
+    struct Window
+    {
+        juce::uint64 start = 0;
+        juce::HeapBlock<char> data;
+        size_t size = 0;
+
+        // Learnt from the response; -1 if it didn't say.
+        juce::int64 objectLength = -1;
+        int statusCode = 0;
+        bool rangeIgnored = false;
+
+        const char* find(juce::uint64 offset, size_t numBytes) const noexcept;
+    };
+
+    /* Makes one GET with the given Range header value and reads up to
+       maxBytes of the response into the window. */
+    bool fetch(const juce::String& range, size_t maxBytes, Window& window);
+    bool fetchRange(juce::uint64 start, juce::uint64 end, Window& window);
+    juce::ThreadPool& getRequestPool() const;
+    const char* findInWindows(juce::uint64 offset, size_t numBytes) const;
+
+    //==============================================================================
+    juce::URL url;
+    Options options;
+
+    juce::uint64 totalLength = 0;
+    int statusCode = 0;
+    bool rangesSupported = false;
+    std::atomic<int> numRequests { 0 };
+
+    Window head, tail;
+    juce::OwnedArray<Window> extraReads;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HttpRangeSource)
+};
@@ -0,0 +1,622 @@
+/*
+  ==============================================================================
+
+    IxmlStreamParser.cpp
+
+  ==============================================================================
+*/
+
+#include "IxmlStreamParser.h"
+#include "XmlTextScanner.h"
+
+namespace
+{
+    //==============================================================================
+    // Each level is indented further, so the indented copy of a document nested
+    // this deep would grow with the square of its size. Real iXML goes about
+    // five levels deep; anything nested past this is shown as it is.
+    constexpr int maxNestingDepth = 64;
+
+    // Even within that depth, a document of nothing but one-character text
+    // nodes would come out a hundred times its size once indented. Real
+    // documents grow by well under this, so one that would grow more is
+    // shown as it is too.
+    constexpr size_t maxGrowth = 4;
+    constexpr size_t growthAllowance = 64 * 1024;
+
+    //==============================================================================
+    /* A range of bytes inside the payload being parsed. */
+    struct Span
+    {
+        const char* start = nullptr;
+        const char* end = nullptr;
+
+        bool isEmpty() const noexcept       { return start == end; }
+        size_t length() const noexcept      { return (size_t) (end - start); }
+
+        bool equals(const char* text) const noexcept
+        {
+            auto textLength = std::strlen(text);
+            return length() == textLength && std::memcmp(start, text, textLength) == 0;
+        }
+    };
+
+    bool isXmlWhitespace(char c) noexcept
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    Span trim(Span span) noexcept
+    {
+        while (span.start < span.end && isXmlWhitespace(*span.start))
+            ++span.start;
+
+        while (span.end > span.start && isXmlWhitespace(span.end[-1]))
+            --span.end;
+
+        return span;
+    }
+
+    /* Converts element text to a String, expanding the predefined and numeric
+       character entities. */
+    juce::String decodeText(Span span)
+    {
+        if (std::memchr(span.start, '&', span.length()) == nullptr)
+            return juce::String::fromUTF8(span.start, (int) span.length());
+
+        juce::MemoryOutputStream decoded(span.length());
+
+        for (auto* p = span.start; p < span.end; ++p)
+        {
+            if (*p != '&')
+            {
+                decoded.writeByte(*p);
+                continue;
+            }
+
+            auto* semicolon = static_cast<const char*>(std::memchr(p, ';', (size_t) (span.end - p)));
+
+            if (semicolon == nullptr)
+            {
+                decoded.writeByte(*p);
+                continue;
+            }
+
+            Span entity { p + 1, semicolon };
+
+            if (entity.equals("amp"))        decoded.writeByte('&');
+            else if (entity.equals("lt"))    decoded.writeByte('<');
+            else if (entity.equals("gt"))    decoded.writeByte('>');
+            else if (entity.equals("quot"))  decoded.writeByte('"');
+            else if (entity.equals("apos"))  decoded.writeByte('\'');
+            else if (entity.length() > 1 && entity.start[0] == '#')
+            {
+                auto digits = juce::String(entity.start + 1, entity.length() - 1);
+                auto codePoint = digits.startsWithIgnoreCase("x") ? digits.substring(1).getHexValue32()
+                                                                  : digits.getIntValue();
+
+                if (codePoint > 0)
+                    decoded << juce::String::charToString((juce::juce_wchar) codePoint);
+            }
+            else
+            {
+                // Not an entity we know, so keep it as written.
+                decoded.write(p, (size_t) (semicolon - p + 1));
+            }
+
+            p = semicolon;
+        }
+
+        return decoded.toUTF8();
+    }
+
+    //==============================================================================
+    class Parser
+    {
+    public:
+        Parser(const char* data, size_t numBytes, WavMetadata::Ixml& resultToFill, ParseArena& arena)
+            : documentStart(data),
+              scan(XmlTextScanner::scan(data, numBytes, arena)),    // Before out, so out can grow in place.
+              markupEnd(scan.markup + scan.numMarkup),
+              pos(data), end(data + scan.documentLength), result(resultToFill),
+              out(arena, (size_t) (end - pos) + (size_t) (end - pos) / 4 + 64)    // Indenting adds a little.
+        {
+        }
+
+        /* Makes the run record where these elements are among the root's
+           children, for editing in place rather than displaying. */
+        void locate(const juce::StringArray& names, IxmlStreamParser::RootChildren& result)
+        {
+            locateNames = &names;
+            located = &result;
+            located->elements.clearQuick();
+            located->elements.insertMultiple(0, {}, names.size());
+        }
+
+        bool run()
+        {
+            // XML has to be in an encoding it says it's in, and iXML says
+            // UTF-8. Locating works on bytes, so doesn't mind.
+            if (! scan.isValidUtf8 && located == nullptr)
+                return false;
+
+            out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\n";
+
+            auto maxOutputSize = (size_t) (end - pos) * maxGrowth + growthAllowance;
+
+            while (pos < end)
+            {
+                if (*pos == '<')
+                {
+                    if (! parseMarkup())
+                        return false;
+                }
+                else
+                {
+                    auto* textEnd = findMarkup(pos, '<');
+
+                    if (textEnd == nullptr)
+                        textEnd = end;
+
+                    handleText({ pos, textEnd }, false);
+                    pos = textEnd;
+                }
+
+                if (out.getSize() > maxOutputSize)
+                    return false;
+            }
+
+            if (! sawRootElement || ! openElements.isEmpty())
+                return false;
+
+            if (located == nullptr)
+                result.text = juce::String::fromUTF8(out.getData(), (int) out.getSize());
+
+            return true;
+        }
+
+    private:
+        //==============================================================================
+        // Where the document ends and where its '<'s and '>'s are, from one
+        // pass over it up front. Past the first null is padding, not document.
+        const char* documentStart;
+        XmlTextScanner::Result scan;
+        const juce::uint32* markupEnd;
+
+        const char* pos;
+        const char* end;
+        WavMetadata::Ixml& result;
+
+        ParseArena::Buffer out;
+        juce::Array<Span> openElements;
+        bool sawRootElement = false;
+
+        // The last start tag has been written without a newline, in case the
+        // element turns out to hold only text and can go on a single line.
+        bool startTagPending = false;
+        Span pendingText;
+        bool pendingTextIsCData = false;
+
+        // Only set when locating elements (see locate()).
+        const juce::StringArray* locateNames = nullptr;
+        IxmlStreamParser::RootChildren* located = nullptr;
+        int openLocatedElement = -1;
+
+        //==============================================================================
+        /* The index entries at or after an offset into the document. */
+        const juce::uint32* markupFrom(size_t offset) const noexcept
+        {
+            return std::lower_bound(scan.markup, markupEnd, (juce::uint32) offset);
+        }
+
+        size_t offsetOf(const char* p) const noexcept   { return (size_t) (p - documentStart); }
+
+        /* The first '<' or '>' at or after a position, or nullptr. */
+        const char* findMarkup(const char* from, char c) const noexcept
+        {
+            for (auto* entry = markupFrom(offsetOf(from)); entry != markupEnd; ++entry)
+                if (documentStart[*entry] == c)
+                    return documentStart + *entry;
+
+            return nullptr;
+        }
+
+        /* The first occurrence at or after a position of something ending in
+           '>', e.g. "-->", or nullptr. Only the '>'s need looking at. */
+        const char* findTerminator(const char* from, const char* terminator) const noexcept
+        {
+            auto length = std::strlen(terminator);
+            jassert(length > 0 && terminator[length - 1] == '>');
+
+            for (auto* entry = markupFrom(offsetOf(from) + length - 1); entry != markupEnd; ++entry)
+            {
+                auto* start = documentStart + *entry - (length - 1);
+
+                if (documentStart[*entry] == '>' && std::memcmp(start, terminator, length) == 0)
+                    return start;
+            }
+
+            return nullptr;
+        }
+
+        //==============================================================================
+        bool parseMarkup()
+        {
+            auto remaining = (size_t) (end - pos);
+
+            if (remaining >= 2 && pos[1] == '?')
+                return skipPast("?>");
+
+            if (remaining >= 4 && std::memcmp(pos, "<!--", 4) == 0)
+                return skipPast("-->");
+
+            if (remaining >= 9 && std::memcmp(pos, "<![CDATA[", 9) == 0)
+            {
+                auto* contentStart = pos + 9;
+                auto* contentEnd = findTerminator(contentStart, "]]>");
+
+                if (contentEnd == nullptr)
+                    return false;
+
+                handleText({ contentStart, contentEnd }, true);
+                pos = contentEnd + 3;
+                return true;
+            }
+
+            if (remaining >= 2 && pos[1] == '!')
+                return skipPast(">");   // DOCTYPE and friends
+
+            if (remaining >= 2 && pos[1] == '/')
+                return parseEndTag();
+
+            return parseStartTag();
+        }
+
+        bool skipPast(const char* terminator)
+        {
+            auto* found = findTerminator(pos, terminator);
+
+            if (found == nullptr)
+                return false;
+
+            pos = found + std::strlen(terminator);
+            return true;
+        }
+
+        /* Finds the closing '>' of a tag, stepping over quoted attribute values. */
+        const char* findTagEnd(const char* p) const noexcept
+        {
+            auto* firstClose = findMarkup(p, '>');
+
+            if (firstClose == nullptr)
+                return nullptr;
+
+            // A '>' can only be inside a value if there's a quote before it.
+            auto length = (size_t) (firstClose - p);
+
+            if (std::memchr(p, '"', length) == nullptr && std::memchr(p, '\'', length) == nullptr)
+                return firstClose;
+
+            char quote = 0;
+
+            for (; p < end; ++p)
+            {
+                if (quote != 0)
+                {
+                    if (*p == quote)
+                        quote = 0;
+                }
+                else if (*p == '"' || *p == '\'')
+                {
+                    quote = *p;
+                }
+                else if (*p == '>')
+                {
+                    return p;
+                }
+            }
+
+            return nullptr;
+        }
+
+        bool parseStartTag()
+        {
+            auto* tagEnd = findTagEnd(pos + 1);
+
+            if (tagEnd == nullptr)
+                return false;
+
+            Span name { pos + 1, pos + 1 };
+
+            while (name.end < tagEnd && ! isXmlWhitespace(*name.end) && *name.end != '/')
+                ++name.end;
+
+            if (name.isEmpty())
+                return false;
+
+            // Only one top-level element is allowed.
+            if (openElements.isEmpty() && sawRootElement)
+                return false;
+
+            if (openElements.size() >= maxNestingDepth)
+                return false;
+
+            bool selfClosing = tagEnd[-1] == '/' && tagEnd - 1 >= name.end;
+            auto attributes = trim({ name.end, selfClosing ? tagEnd - 1 : tagEnd });
+
+            flushPendingStartTag();
+            writeIndent();
+            out << '<';
+            write(name);
+
+            if (! attributes.isEmpty())
+            {
+                out << ' ';
+                write(attributes);
+            }
+
+            sawRootElement = true;
+            onElementStarted(name);
+
+            if (located != nullptr)
+                noteStartTag(name, tagEnd, selfClosing);
+
+            if (selfClosing)
+            {
+                out << "/>\n";
+            }
+            else
+            {
+                out << '>';
+                openElements.add(name);
+                startTagPending = true;
+            }
+
+            pos = tagEnd + 1;
+            return true;
+        }
+
+        bool parseEndTag()
+        {
+            auto* tagEnd = findMarkup(pos, '>');
+
+            if (tagEnd == nullptr || openElements.isEmpty())
+                return false;
+
+            auto name = trim({ pos + 2, tagEnd });
+            auto openName = openElements.getLast();
+
+            if (name.length() != openName.length() || std::memcmp(name.start, openName.start, name.length()) != 0)
+                return false;
+
+            if (located != nullptr)
+                noteEndTag(tagEnd);
+
+            openElements.removeLast();
+
+            if (startTagPending)
+            {
+                // <NAME>text</NAME> all on one line.
+                writeText(pendingText, pendingTextIsCData);
+                startTagPending = false;
+                pendingText = {};
+            }
+            else
+            {
+                writeIndent();
+            }
+
+            out << "</";
+            write(name);
+            out << ">\n";
+
+            pos = tagEnd + 1;
+            return true;
+        }
+
+        void handleText(Span rawText, bool isCData)
+        {
+            auto text = isCData ? rawText : trim(rawText);
+
+            // Locating only needs the tags.
+            if (text.isEmpty() || openElements.isEmpty() || located != nullptr)
+                return;
+
+            extractField(text, isCData);
+
+            if (startTagPending && pendingText.isEmpty())
+            {
+                pendingText = text;
+                pendingTextIsCData = isCData;
+                return;
+            }
+
+            flushPendingStartTag();
+            writeIndent();
+            writeText(text, isCData);
+            out << '\n';
+        }
+
+        /* A child is about to be written, so the pending start tag needs its own line. */
+        void flushPendingStartTag()
+        {
+            if (! startTagPending)
+                return;
+
+            out << '\n';
+            startTagPending = false;
+
+            if (! pendingText.isEmpty())
+            {
+                writeIndent();
+                writeText(pendingText, pendingTextIsCData);
+                out << '\n';
+                pendingText = {};
+            }
+        }
+
+        //==============================================================================
+        /* Called before the element is added to openElements. */
+        void noteStartTag(Span name, const char* tagEnd, bool selfClosing)
+        {
+            if (openElements.isEmpty())
+            {
+                located->rootName = juce::String::fromUTF8(name.start, (int) name.length());
+                return;
+            }
+
+            if (openElements.size() != 1)
+                return;
+
+            for (int i = 0; i < locateNames->size(); ++i)
+            {
+                auto& element = located->elements.getReference(i);
+
+                if (element.found || ! name.equals((*locateNames)[i].toRawUTF8()))
+                    continue;
+
+                element.start = offsetOf(pos);
+                element.selfClosing = selfClosing;
+
+                if (selfClosing)
+                {
+                    element.end = element.contentStart = element.contentEnd = offsetOf(tagEnd + 1);
+                    element.found = true;
+                }
+                else
+                {
+                    element.contentStart = offsetOf(tagEnd + 1);
+                    openLocatedElement = i;
+                }
+
+                return;
+            }
+        }
+
+        /* Called before the element is taken off openElements. */
+        void noteEndTag(const char* tagEnd)
+        {
+            if (openElements.size() == 1)
+            {
+                located->rootEndTag = offsetOf(pos);
+            }
+            else if (openElements.size() == 2 && openLocatedElement >= 0)
+            {
+                auto& element = located->elements.getReference(openLocatedElement);
+                element.contentEnd = offsetOf(pos);
+                element.end = offsetOf(tagEnd + 1);
+                element.found = true;
+                openLocatedElement = -1;
+            }
+        }
+
+        //==============================================================================
+        /* The element name n levels up from the innermost open element (0 = innermost). */
+        Span getOpenElement(int levelsUp) const noexcept
+        {
+            auto index = openElements.size() - 1 - levelsUp;
+            return juce::isPositiveAndBelow(index, openElements.size()) ? openElements.getReference(index) : Span();
+        }
+
+        void onElementStarted(Span name)
+        {
+            // openElements doesn't contain the new element yet, so level 0 is its parent.
+            if (name.equals("TRACK") && getOpenElement(0).equals("TRACK_LIST"))
+                result.tracks.add(WavMetadata::IxmlTrack());
+        }
+
+        void extractField(Span text, bool isCData)
+        {
+            auto element = getOpenElement(0);
+            auto parent = getOpenElement(1);
+
+            auto value = [&] { return isCData ? juce::String::fromUTF8(text.start, (int) text.length())
+                                              : decodeText(text); };
+
+            if (parent.equals("BWFXML"))
+            {
+                if (element.equals("PROJECT"))      result.project = value();
+                else if (element.equals("SCENE"))   result.scene = value();
+                else if (element.equals("TAKE"))    result.take = value();
+                else if (element.equals("TAPE"))    result.tape = value();
+            }
+            else if (parent.equals("TRACK") && getOpenElement(2).equals("TRACK_LIST") && ! result.tracks.isEmpty())
+            {
+                auto& track = result.tracks.getReference(result.tracks.size() - 1);
+
+                if (element.equals("CHANNEL_INDEX"))            track.channelIndex = value();
+                else if (element.equals("INTERLEAVE_INDEX"))    track.interleaveIndex = value();
+                else if (element.equals("NAME"))                track.name = value();
+                else if (element.equals("FUNCTION"))            track.function = value();
+            }
+        }
+
+        //==============================================================================
+        void write(Span span)
+        {
+            out.write(span.start, span.length());
+        }
+
+        void writeText(Span text, bool isCData)
+        {
+            if (text.isEmpty())
+                return;
+
+            if (isCData)
+                out << "<![CDATA[";
+
+            write(text);
+
+            if (isCData)
+                out << "]]>";
+        }
+
+        void writeIndent()
+        {
+            out.writeRepeatedByte(' ', (size_t) openElements.size() * 2);
+        }
+
+        JUCE_DECLARE_NON_COPYABLE(Parser)
+    };
+}
+
+//==============================================================================
+bool IxmlStreamParser::parse(const char* data, size_t numBytes, WavMetadata::Ixml& result, ParseArena* scratch)
+{
+    if (data == nullptr || numBytes == 0)
+        return false;
+
+    // An arena only allocates once something is asked of it, so this is free
+    // when the caller supplied one.
+    ParseArena temporaryArena;
+    Parser parser(data, numBytes, result, scratch != nullptr ? *scratch : temporaryArena);
+    return parser.run();
+}
+
+bool IxmlStreamParser::prettyPrint(const char* data, size_t numBytes, juce::String& text, ParseArena* scratch)
+{
+    // None of the iXML fields will be found outside a BWFXML element, so
+    // looking for them costs next to nothing.
+    WavMetadata::Ixml unused;
+
+    if (! parse(data, numBytes, unused, scratch))
+        return false;
+
+    text = std::move(unused.text);
+    return true;
+}
+
+bool IxmlStreamParser::locateRootChildren(const char* data, size_t numBytes, const juce::StringArray& names,
+                                          RootChildren& result, ParseArena* scratch)
+{
+    result = {};
+
+    if (data == nullptr || numBytes == 0)
+        return false;
+
+    ParseArena temporaryArena;
+    WavMetadata::Ixml unused;
+    Parser parser(data, numBytes, unused, scratch != nullptr ? *scratch : temporaryArena);
+    parser.locate(names, result);
+    return parser.run();
+}
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    IxmlStreamParser.h
+
+    A single-pass tokenizer for iXML payloads. It works directly on the raw
+    UTF-8 chunk bytes, writes an indented copy of the document as it goes and
+    picks out the production fields, without ever building an element tree.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WavMetadata.h"
+#include "ParseArena.h"
+
+//==============================================================================
+class IxmlStreamParser
+{
+public:
+    //==============================================================================
+    /* Parses an iXML payload, filling in the text and the key fields of the
+       result. Returns false if the payload isn't well-formed XML, or would
+       be many times its size once indented, in which case the text is left
+       untouched (fields found before the error are kept).
+       The indented copy is built up in the given arena if there is one, or in
+       a temporary one if not. */
+    static bool parse(const char* data, size_t numBytes, WavMetadata::Ixml& result, ParseArena* scratch = nullptr);
+
+    /* Indents any other XML payload the same way, e.g. axml or XMP. Returns
+       false, leaving the text untouched, if it isn't well-formed. */
+    static bool prettyPrint(const char* data, size_t numBytes, juce::String& text, ParseArena* scratch = nullptr);
+
+    //==============================================================================
+    /* Where an element sits in a payload, as byte offsets from its start. */
+    struct ElementLocation
+    {
+        bool found = false;
+        bool selfClosing = false;
+        size_t start = 0, end = 0;                  // From its '<' to just past its last '>'.
+        size_t contentStart = 0, contentEnd = 0;    // Between its tags, if it isn't self-closing.
+    };
+
+    struct RootChildren
+    {
+        juce::String rootName;
+        size_t rootEndTag = 0;                      // Where the root element's end tag starts.
+        juce::Array<ElementLocation> elements;      // One for each name asked for, in the same order.
+    };
+
+    /* Finds the first element with each of the given names among the direct
+       children of the root element, e.g. SCENE in BWFXML, with the same
+       tokenizer as parse(), so a comment, CDATA or a nested element with the
+       same name isn't taken for one. The payload only has to be well-formed,
+       not UTF-8, so Latin-1 documents can be located in too. Returns false
+       if it isn't well-formed. */
+    static bool locateRootChildren(const char* data, size_t numBytes, const juce::StringArray& names,
+                                   RootChildren& result, ParseArena* scratch = nullptr);
+
+private:
+    //==============================================================================
+    IxmlStreamParser() = delete;
+};
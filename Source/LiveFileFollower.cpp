@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    LiveFileFollower.cpp
+
+  ==============================================================================
+*/
+
+#include "LiveFileFollower.h"
+#include "WavMetadataReader.h"
+#include <string_view>
+
+namespace
+{
+    size_t hashPayload(const char* payload, juce::uint64 size)
+    {
+        return std::hash<std::string_view>()(std::string_view(payload, (size_t) size));
+    }
+}
+
+//==============================================================================
+LiveFileFollower::LiveFileFollower(const juce::File& fileToFollow)
+    : file(fileToFollow)
+{
+}
+
+void LiveFileFollower::reset()
+{
+    metadata = WavMetadata();
+    completeChunks.clear();
+    decodedChunks.clear();
+}
+
+//==============================================================================
+bool LiveFileFollower::update()
+{
+    auto size = file.getSize();
+    auto modificationTime = file.getLastModificationTime().toMilliseconds();
+
+    if (size == lastSize && modificationTime == lastModificationTime)
+        return false;
+
+    // A file that got shorter has been replaced rather than appended to.
+    if (size < lastSize)
+        reset();
+
+    lastSize = size;
+    lastModificationTime = modificationTime;
+
+    WindowedFileSource source(file);
+    auto scanner = std::make_unique<RiffChunkScanner>(source);
+
+    if (scanner->getStatus() != RiffChunkScanner::Status::ok)
+    {
+        // Not a readable WAV (yet): let the reader say why.
+        reset();
+        metadata = WavMetadataReader::readFromSource(source);
+        return true;
+    }
+
+    // Only the chunks after the last complete one get their headers read.
+    scanner->resumeFrom(completeChunks);
+
+    bool changed = false;
+
+    if (! checkDecodedChunks(*scanner, changed))
+    {
+        reset();
+        scanner = std::make_unique<RiffChunkScanner>(source);
+        changed = true;
+    }
+
+    const auto& chunks = scanner->getAllChunks();
+
+    for (int i = completeChunks.size(); i < chunks.size(); ++i)
+    {
+        const auto& chunk = chunks.getReference(i);
+
+        // Still being written; it'll be picked up once it's complete.
+        if (chunk.available < chunk.size)
+            break;
+
+        // As in the reader, the first chunk of each kind is the one that
+        // counts, except for LIST, where every list is read in turn and the
+        // INFO one can come after an adtl. Chunks that move force a full
+        // rescan, so an offset is enough to tell a LIST we've seen.
+        auto alreadyDecoded = std::any_of(decodedChunks.begin(), decodedChunks.end(), [&chunk](const DecodedChunk& decoded)
+            {
+                return chunk.hasId(FourCC::list) ? decoded.chunk.offset == chunk.offset
+                                                 : decoded.chunk.getTag() == chunk.getTag();
+            });
+
+        // Only metadata chunks are fetched; the audio never is.
+        if (alreadyDecoded || ! WavMetadataReader::isDecodable(chunk.getTag(), chunk.size))
+            continue;
+
+        if (auto* payload = scanner->getPayload(chunk))
+        {
+            if (WavMetadataReader::decodeChunk(chunk.getTag(), payload, chunk.size, metadata))
+            {
+                decodedChunks.add({ chunk, hashPayload(payload, chunk.size) });
+                changed = true;
+            }
+        }
+    }
+
+    completeChunks.clearQuick();
+
+    for (const auto& chunk : chunks)
+    {
+        if (chunk.available < chunk.size)
+            break;
+
+        completeChunks.add(chunk);
+    }
+
+    if (chunks.size() != metadata.chunks.size())
+    {
+        metadata.chunks.clearQuick();
+
+        for (const auto& chunk : chunks)
+            metadata.chunks.add({ FourCC::idToString(chunk.id), chunk.offset, chunk.size });
+
+        changed = true;
+    }
+
+    auto wasOk = metadata.status.wasOk();
+
+    // Part-written files often end in a header that isn't complete yet, so
+    // only a bad size says anything about the file itself.
+    if (scanner->getStatus() == RiffChunkScanner::Status::invalidChunkSize)
+        metadata.status = juce::Result::fail("Encountered an invalid chunk size.");
+    else if (scanner->getStatus() == RiffChunkScanner::Status::tooManyChunks)
+        metadata.status = juce::Result::fail("The file has too many chunks to index.");
+    else
+        metadata.status = juce::Result::ok();
+
+    return changed || wasOk != metadata.status.wasOk();
+}
+
+/* Makes sure the chunks we remembered are still where they were, and decodes
+   any metadata chunk again whose payload has been rewritten in place. Returns
+   false if the layout has changed and the file needs scanning from the start. */
+bool LiveFileFollower::checkDecodedChunks(RiffChunkScanner& scanner, bool& changed)
+{
+    for (const auto& chunk : completeChunks)
+    {
+        RiffChunkScanner::Chunk current;
+
+        if (! scanner.readChunkHeader((juce::uint64) chunk.offset, current)
+             || current.getTag() != chunk.getTag() || current.size != chunk.size)
+            return false;
+    }
+
+    for (auto& decoded : decodedChunks)
+    {
+        const auto& chunk = decoded.chunk;
+        auto* payload = scanner.getPayload(chunk);
+
+        if (payload == nullptr)
+            return false;
+
+        auto hash = hashPayload(payload, chunk.size);
+
+        if (hash != decoded.payloadHash)
+        {
+            WavMetadataReader::decodeChunk(chunk.getTag(), payload, chunk.size, metadata);
+            decoded.payloadHash = hash;
+            changed = true;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    LiveFileFollower.h
+
+    Keeps the metadata of a file that is still being written up to date.
+    Each update remembers the chunks that were complete, so the next one only
+    reads the headers of chunks appended since, and only decodes a metadata
+    chunk again if its bytes have changed. Only depends on juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WavMetadata.h"
+#include "RiffChunkScanner.h"
+#include "MetadataCache.h"
+
+//==============================================================================
+class LiveFileFollower
+{
+public:
+    //==============================================================================
+    explicit LiveFileFollower(const juce::File& fileToFollow);
+
+    const juce::File& getFile() const noexcept              { return file; }
+
+    /* Checks the file and brings the metadata up to date. Costs a single stat
+       when nothing has changed. Returns true if the metadata changed. */
+    bool update();
+
+    const WavMetadata& getMetadata() const noexcept         { return metadata; }
+
+    /* The file's size and modification time as they were when the last update
+       began, i.e. what the current metadata was read from at most. */
+    MetadataCache::Stamp getStamp() const noexcept          { return { lastSize, lastModificationTime }; }
+
+private:
+    //==============================================================================
+    /* A metadata chunk we've decoded, and a hash of its payload at the time. */
+    struct DecodedChunk
+    {
+        RiffChunkScanner::Chunk chunk;
+        size_t payloadHash = 0;
+    };
+
+    void reset();
+    bool checkDecodedChunks(RiffChunkScanner& scanner, bool& changed);
+
+    juce::File file;
+    juce::int64 lastSize = -1;
+    juce::int64 lastModificationTime = 0;
+
+    WavMetadata metadata;
+    juce::Array<RiffChunkScanner::Chunk> completeChunks;    // A prefix of the chunk table.
+    juce::Array<DecodedChunk> decodedChunks;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LiveFileFollower)
+};
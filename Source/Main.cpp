@@ -8,6 +8,35 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "BatchScanner.h"
+#include "MetadataExporter.h"
+#include "BatchEditor.h"
+#include "FolderWatcher.h"
+#include "RemoteScanner.h"
+#include "MetricsReporter.h"
+#include <csignal>
+
+#if JUCE_WINDOWS && ! defined (_CONSOLE)
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #include <windows.h>
+#endif
+
+//==============================================================================
+namespace
+{
+    // Set by SIGINT or SIGTERM (or Ctrl+Break on Windows) to end "--watch".
+    std::atomic<bool> stopRequested { false };
+
+    void requestStop (int)
+    {
+        stopRequested = true;
+    }
+}
 
 //==============================================================================
 class iXMLViewerApplication  : public juce::JUCEApplication
@@ -18,14 +47,18 @@ public:
 
     const juce::String getApplicationName() override       { return ProjectInfo::projectName; }
     const juce::String getApplicationVersion() override    { return ProjectInfo::versionString; }
-    bool moreThanOneInstanceAllowed() override             { return true; }
+
+    // Only one viewer runs at a time: opening more files from Finder/Explorer
+    // forwards them to the running instance. Command-line modes never get as
+    // far as creating the application, so they can always run alongside it.
+    bool moreThanOneInstanceAllowed() override             { return false; }
 
     //==============================================================================
     void initialise (const juce::String& commandLine) override
     {
         // This method is where you should put your application's initialisation code..
 
-        mainWindow.reset (new MainWindow (getApplicationName()));
+        mainWindow.reset (new MainWindow (getApplicationName(), getFilesFromCommandLine (commandLine)));
     }
 
     void shutdown() override
@@ -48,6 +81,8 @@ public:
         // When another instance of the app is launched while this one is running,
         // this method is invoked, and the commandLine parameter tells you what
         // the other instance's command-line arguments were.
+        if (mainWindow != nullptr)
+            mainWindow->openFiles (getFilesFromCommandLine (commandLine));
     }
 
     //==============================================================================
@@ -58,14 +93,14 @@ public:
     class MainWindow    : public juce::DocumentWindow
     {
     public:
-        MainWindow (juce::String name)
+        MainWindow (juce::String name, const juce::Array<juce::File>& filesToOpen)
             : DocumentWindow (name,
                               juce::Desktop::getInstance().getDefaultLookAndFeel()
                                                           .findColour (juce::ResizableWindow::backgroundColourId),
                               DocumentWindow::allButtons)
         {
             setUsingNativeTitleBar (true);
-            setContentOwned (new MainComponent(), true);
+            setContentOwned (new MainComponent (filesToOpen), true);
 
            #if JUCE_IOS || JUCE_ANDROID
             setFullScreen (true);
@@ -77,6 +112,18 @@ public:
             setVisible (true);
         }
 
+        /* Opens files in the session and brings the window to the front. */
+        void openFiles (const juce::Array<juce::File>& files)
+        {
+            if (files.isEmpty())
+                return;
+
+            if (auto* content = dynamic_cast<MainComponent*> (getContentComponent()))
+                content->openFiles (files);
+
+            toFront (true);
+        }
+
         void closeButtonPressed() override
         {
             // This is called when the user tries to close this window. Here, we'll just
@@ -96,10 +143,771 @@ public:
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainWindow)
     };
 
+    //==============================================================================
+    /* True if the arguments ask for one of the command-line modes rather than the viewer. */
+    static bool isConsoleMode (const juce::ArgumentList& args)
+    {
+        return args.containsOption ("--scan") || args.containsOption ("--scan-urls") || args.containsOption ("--edit")
+                || args.containsOption ("--resume-edit") || args.containsOption ("--rollback-edit")
+                || args.containsOption ("--watch");
+    }
+
+    /* Runs a command-line mode and returns the process exit code. This is called
+       from main() before the application object exists, so nothing it does may
+       need the message manager or any of the GUI. */
+    static int runConsoleMode (const juce::ArgumentList& args)
+    {
+        if (args.containsOption ("--scan"))
+            return runBatchScan (args);
+
+        if (args.containsOption ("--scan-urls"))
+            return runRemoteScan (args);
+
+        if (args.containsOption ("--watch"))
+            return runWatch (args);
+
+        return runBatchEdit (args);
+    }
+
 private:
+    //==============================================================================
+    /* The existing files and folders named on a command line. */
+    static juce::Array<juce::File> getFilesFromCommandLine (const juce::String& commandLine)
+    {
+        juce::ArgumentList args ({}, commandLine);
+        juce::Array<juce::File> files;
+
+        for (int i = 0; i < args.size(); ++i)
+        {
+            if (args[i].isOption())
+                continue;
+
+            auto file = args[i].resolveAsFile();
+
+            if (file.exists())
+                files.add (file);
+        }
+
+        return files;
+    }
+
+    /* Returns the value following an option, accepting both "--opt value" and "--opt=value". */
+    static juce::String getOptionValue (const juce::ArgumentList& args, juce::StringRef option)
+    {
+        auto value = args.getValueForOption (option);
+
+        if (value.isEmpty())
+        {
+            auto index = args.indexOfOption (option);
+
+            if (index >= 0 && index + 1 < args.size() && ! args[index + 1].isOption())
+                value = args[index + 1].text;
+        }
+
+        return value;
+    }
+
+    /* Prints where a scan's time went to stderr, so it doesn't mix with the records. */
+    static void printTimings (const ParseTimings& timings, int numFiles, double wallSeconds)
+    {
+        auto total = juce::jmax (1.0e-9, timings.getTotalSeconds());
+        auto files = juce::jmax (1, numFiles);
+
+        std::cerr << "\n" << numFiles << " files in " << juce::String (wallSeconds, 3) << " s ("
+                  << juce::String (numFiles / juce::jmax (1.0e-9, wallSeconds), 1) << " files/s)\n"
+                  << "Stage times are summed over all worker threads:\n\n"
+                  << juce::String ("stage").paddedRight (' ', 18)
+                  << juce::String ("total ms").paddedLeft (' ', 12)
+                  << juce::String ("ms/file").paddedLeft (' ', 10)
+                  << juce::String ("share").paddedLeft (' ', 8) << "\n";
+
+        for (int i = 0; i < ParseTimings::numStages; ++i)
+        {
+            auto stage = (ParseTimings::Stage) i;
+            auto seconds = timings.getSeconds (stage);
+
+            std::cerr << juce::String (ParseTimings::getStageName (stage)).paddedRight (' ', 18)
+                      << juce::String (seconds * 1000.0, 2).paddedLeft (' ', 12)
+                      << juce::String (seconds * 1000.0 / files, 3).paddedLeft (' ', 10)
+                      << (juce::String (seconds / total * 100.0, 1) + "%").paddedLeft (' ', 8) << "\n";
+        }
+
+        std::cerr << std::flush;
+    }
+
+    /* Starts reporting a run's metrics if "--metrics-interval S" (JSON lines on stderr every
+       S seconds) or "--metrics-port N" (Prometheus text at http://127.0.0.1:N/metrics) asks
+       for it. "--metrics-bind <address>" listens somewhere other than localhost, and an
+       empty address listens on every interface. Returns false, having said why, if the
+       port couldn't be opened. */
+    static bool startMetricsReporter (const juce::ArgumentList& args, const ScanMetrics& metrics,
+                                      std::unique_ptr<MetricsReporter>& reporter)
+    {
+        MetricsReporter::Options options;
+        auto interval = getOptionValue (args, "--metrics-interval");
+        auto port = getOptionValue (args, "--metrics-port");
+
+        if (interval.isNotEmpty())
+            options.logIntervalSeconds = juce::jmax (0.1, interval.getDoubleValue());
+
+        if (port.isNotEmpty())
+            options.port = port.getIntValue();
+
+        // Looked for by hand, as an empty value is meaningful here.
+        auto bindIndex = args.indexOfOption ("--metrics-bind");
+
+        if (bindIndex >= 0)
+            options.bindAddress = getOptionValue (args, "--metrics-bind");
+
+        if (options.logIntervalSeconds <= 0.0 && options.port <= 0)
+            return true;
+
+        reporter = std::make_unique<MetricsReporter> (metrics, options, [] (const juce::String& line)
+        {
+            std::cerr << line << std::endl;
+        });
+
+        if (! reporter->start())
+        {
+            std::cerr << "Error: could not listen for metrics requests on port " << options.port << "." << std::endl;
+            reporter.reset();
+            return false;
+        }
+
+        return true;
+    }
+
+    /* Handles "--scan <dir> [--jobs N] [--read-ahead N] [--no-cache] [--timings] [--export <file> [--format csv|jsonl]]":
+       prints one record per WAV file found under the directory, or writes them to the
+       export file, and returns the process exit code. With --timings, a breakdown of
+       where the time went follows on stderr. Also takes the metrics options (see
+       startMetricsReporter()). */
+    static int runBatchScan (const juce::ArgumentList& args)
+    {
+        BatchScanner::Options options;
+        options.root = juce::File::getCurrentWorkingDirectory().getChildFile (getOptionValue (args, "--scan"));
+
+        auto jobs = getOptionValue (args, "--jobs");
+
+        if (jobs.isNotEmpty())
+            options.numJobs = jobs.getIntValue();
+
+        auto readAhead = getOptionValue (args, "--read-ahead");
+
+        if (readAhead.isNotEmpty())
+            options.readAhead = readAhead.getIntValue();
+
+        if (! options.root.isDirectory())
+        {
+            std::cerr << "Error: " << options.root.getFullPathName() << " is not a directory." << std::endl;
+            return 1;
+        }
+
+        MetadataCache cache;
+
+        if (! args.containsOption ("--no-cache"))
+        {
+            cache.load();
+            options.cache = &cache;
+        }
+
+        std::unique_ptr<MetadataExporter> exporter;
+        auto exportPath = getOptionValue (args, "--export");
+
+        if (exportPath.isNotEmpty())
+        {
+            auto exportFile = juce::File::getCurrentWorkingDirectory().getChildFile (exportPath);
+            auto format = MetadataExporter::getFormatForFile (exportFile);
+            auto formatName = getOptionValue (args, "--format");
+
+            if (formatName.isNotEmpty() && ! MetadataExporter::getFormatFromName (formatName, format))
+            {
+                std::cerr << "Error: unknown export format \"" << formatName << "\"." << std::endl;
+                return 1;
+            }
+
+            exporter = std::make_unique<MetadataExporter> (exportFile, format);
+
+            if (! exporter->openedOk())
+            {
+                std::cerr << "Error: could not write to " << exportFile.getFullPathName() << "." << std::endl;
+                return 1;
+            }
+        }
+
+        ScanMetrics metrics;
+        std::unique_ptr<MetricsReporter> reporter;
+        options.metrics = &metrics;
+
+        if (! startMetricsReporter (args, metrics, reporter))
+            return 1;
+
+        BatchScanner scanner (options);
+        ParseTimings totalTimings;
+        auto scanStart = juce::Time::getHighResolutionTicks();
+
+        auto numFiles = scanner.run ([&exporter, &totalTimings] (const juce::File& file, const WavMetadata& metadata)
+        {
+            // Callbacks are serialised, so the totals don't need a lock of their own.
+            totalTimings.add (metadata.timings);
+
+            if (exporter != nullptr)
+                exporter->write (file, metadata);
+            else
+                std::cout << BatchScanner::formatRecord (file, metadata) << "\n";
+        });
+
+        std::cout << std::flush;
+
+        // Logs the final totals.
+        reporter.reset();
+
+        if (args.containsOption ("--timings"))
+            printTimings (totalTimings, numFiles,
+                          juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - scanStart));
+
+        if (options.cache != nullptr)
+            cache.save();
+
+        if (exporter != nullptr && ! exporter->finish())
+        {
+            std::cerr << "Error: the export file could not be completely written." << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    /* Handles "--scan-urls <list> [--jobs N] [--header \"Name: value\"...] [--timeout S] [--timings]":
+       reads WAV files from a web server or object storage with range requests, e.g. through
+       presigned URLs, and prints one record per URL. The list has one URL per line; blank
+       lines and lines starting with '#' are skipped, and "-" reads it from stdin. Exits
+       with 1 if any URL couldn't be read, e.g. because its presigned URL had expired. Also
+       takes the metrics options (see startMetricsReporter()). */
+    static int runRemoteScan (const juce::ArgumentList& args)
+    {
+        auto listPath = getOptionValue (args, "--scan-urls");
+        juce::StringArray lines;
+
+        if (listPath == "-")
+        {
+            for (std::string line; std::getline (std::cin, line);)
+                lines.add (juce::String (line));
+        }
+        else
+        {
+            auto listFile = juce::File::getCurrentWorkingDirectory().getChildFile (listPath);
+
+            if (! listFile.existsAsFile())
+            {
+                std::cerr << "Error: " << listFile.getFullPathName() << " does not exist." << std::endl;
+                return 1;
+            }
+
+            listFile.readLines (lines);
+        }
+
+        RemoteScanner::Options options;
+
+        for (auto line : lines)
+        {
+            line = line.trim();
+
+            if (line.isNotEmpty() && ! line.startsWithChar ('#'))
+                options.urls.add (juce::URL (line));
+        }
+
+        auto jobs = getOptionValue (args, "--jobs");
+
+        if (jobs.isNotEmpty())
+            options.numJobs = jobs.getIntValue();
+
+        auto timeout = getOptionValue (args, "--timeout");
+
+        if (timeout.isNotEmpty())
+            options.source.timeoutMilliseconds = juce::roundToInt (timeout.getDoubleValue() * 1000.0);
+
+        // "--header" can be given more than once, so it's looked for by hand.
+        juce::StringArray headers;
+
+        for (int i = 0; i < args.size(); ++i)
+        {
+            if (args[i].text.startsWith ("--header="))
+                headers.add (args[i].text.fromFirstOccurrenceOf ("=", false, false));
+            else if (args[i].text == "--header" && i + 1 < args.size())
+                headers.add (args[++i].text);
+        }
+
+        options.source.extraHeaders = headers.joinIntoString ("\r\n");
+
+        ScanMetrics metrics;
+        std::unique_ptr<MetricsReporter> reporter;
+        options.metrics = &metrics;
+
+        if (! startMetricsReporter (args, metrics, reporter))
+            return 1;
+
+        RemoteScanner scanner (options);
+        ParseTimings totalTimings;
+        auto scanStart = juce::Time::getHighResolutionTicks();
+
+        int numFailed = 0;
+
+        auto numUrls = scanner.run ([&totalTimings, &numFailed] (const juce::URL& url, const WavMetadata& metadata)
+        {
+            // Callbacks are serialised, so the totals don't need a lock of their own.
+            totalTimings.add (metadata.timings);
+
+            if (metadata.status.failed())
+                ++numFailed;
+
+            // Without its query string, so presigned URLs don't leak their signatures into the output.
+            std::cout << BatchScanner::formatRecord (url.toString (false), metadata) << "\n";
+        });
+
+        std::cout << std::flush;
+        reporter.reset();
+
+        if (args.containsOption ("--timings"))
+            printTimings (totalTimings, numUrls,
+                          juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - scanStart));
+
+        if (numFailed > 0)
+        {
+            std::cerr << numFailed << " of " << numUrls << " URLs could not be read." << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    /* Handles "--edit <dir> --set FIELD=VALUE [--set FIELD=VALUE...] [--where FIELD=VALUE]",
+       "--resume-edit" and "--rollback-edit", each optionally with [--journal <file>],
+       [--jobs N] and [--per-volume N]. Prints one line per file saying what happened
+       to it, and returns the process exit code. */
+    static int runBatchEdit (const juce::ArgumentList& args)
+    {
+        auto journalPath = getOptionValue (args, "--journal");
+        auto journalFile = journalPath.isNotEmpty() ? juce::File::getCurrentWorkingDirectory().getChildFile (journalPath)
+                                                    : EditJournal::getDefaultFile();
+        EditJournal journal (journalFile);
+
+        int numFailed = 0;
+
+        auto printResult = [&numFailed] (const juce::File& file, BatchEditor::Outcome outcome, const juce::String& error)
+        {
+            if (outcome == BatchEditor::Outcome::failed)
+                ++numFailed;
+
+            std::cout << file.getFullPathName() << "\t" << BatchEditor::getOutcomeName (outcome);
+
+            if (error.isNotEmpty())
+                std::cout << "\t" << error.replaceCharacters ("\t\r\n", "   ");
+
+            std::cout << "\n";
+        };
+
+        if (args.containsOption ("--rollback-edit"))
+        {
+            auto loaded = journal.load();
+
+            if (loaded.wasOk())
+                loaded = journal.reopen();
+
+            if (loaded.failed())
+            {
+                std::cerr << "Error: " << loaded.getErrorMessage() << std::endl;
+                return 1;
+            }
+
+            auto numRolledBack = BatchEditor::rollBack (journal, printResult);
+            std::cout << std::flush;
+            std::cerr << "Rolled back " << numRolledBack << " files." << std::endl;
+            return numFailed > 0 ? 1 : 0;
+        }
+
+        BatchEditor::Options options;
+        auto jobs = getOptionValue (args, "--jobs");
+        auto perVolume = getOptionValue (args, "--per-volume");
+
+        if (jobs.isNotEmpty())
+            options.numJobs = jobs.getIntValue();
+
+        if (perVolume.isNotEmpty())
+            options.maxJobsPerVolume = perVolume.getIntValue();
+
+        if (args.containsOption ("--resume-edit"))
+        {
+            auto loaded = journal.load();
+
+            if (loaded.wasOk())
+                loaded = journal.reopen();
+
+            if (loaded.failed())
+            {
+                std::cerr << "Error: " << loaded.getErrorMessage() << std::endl;
+                return 1;
+            }
+
+            const auto& info = journal.getRunInfo();
+            options.root = info.root;
+            options.changes = info.changes;
+            options.whereField = info.whereField;
+            options.whereValue = info.whereValue;
+        }
+        else
+        {
+            options.root = juce::File::getCurrentWorkingDirectory().getChildFile (getOptionValue (args, "--edit"));
+
+            // "--set" can be given more than once, so it's looked for by hand.
+            for (int i = 0; i < args.size(); ++i)
+            {
+                juce::String change;
+
+                if (args[i].text.startsWith ("--set="))
+                    change = args[i].text.fromFirstOccurrenceOf ("=", false, false);
+                else if (args[i].text == "--set" && i + 1 < args.size())
+                    change = args[++i].text;
+                else
+                    continue;
+
+                auto field = change.upToFirstOccurrenceOf ("=", false, false).trim().toUpperCase();
+
+                if (! change.contains ("=") || ! BatchEditor::getEditableFields().contains (field))
+                {
+                    std::cerr << "Error: \"" << change << "\" isn't a change that can be made. The fields are "
+                              << BatchEditor::getEditableFields().joinIntoString (", ") << "." << std::endl;
+                    return 1;
+                }
+
+                options.changes.set (field, change.fromFirstOccurrenceOf ("=", false, false));
+            }
+
+            auto where = getOptionValue (args, "--where");
+
+            if (where.isNotEmpty())
+            {
+                options.whereField = where.upToFirstOccurrenceOf ("=", false, false).trim().toUpperCase();
+                options.whereValue = where.fromFirstOccurrenceOf ("=", false, false);
+            }
+
+            if (options.changes.size() == 0)
+            {
+                std::cerr << "Error: say what to change with --set FIELD=VALUE." << std::endl;
+                return 1;
+            }
+
+            if (! options.root.isDirectory())
+            {
+                std::cerr << "Error: " << options.root.getFullPathName() << " is not a directory." << std::endl;
+                return 1;
+            }
+
+            // Starting afresh would lose what's needed to finish or undo an interrupted run.
+            if (journal.load().wasOk() && journal.hasUnfinishedEdits())
+            {
+                std::cerr << "Error: the run journalled in " << journalFile.getFullPathName()
+                          << " was interrupted. Use --resume-edit or --rollback-edit first." << std::endl;
+                return 1;
+            }
+
+            auto created = journal.create ({ options.root, options.changes, options.whereField, options.whereValue });
+
+            if (created.failed())
+            {
+                std::cerr << "Error: " << created.getErrorMessage() << std::endl;
+                return 1;
+            }
+        }
+
+        BatchEditor editor (options, journal);
+        auto numFiles = editor.run (printResult);
+
+        std::cout << std::flush;
+        std::cerr << numFiles << " files, " << numFailed << " errors. Journal: " << journalFile.getFullPathName() << std::endl;
+        return numFailed > 0 ? 1 : 0;
+    }
+
+    /* Handles "--watch <dir> [--watch <dir>...] [--jobs N] [--read-ahead N] [--settle S]
+       [--poll] [--poll-interval S]": brings the cache up to date with the folders, then
+       keeps it that way, printing a record for each WAV file as it arrives or changes and
+       "<path>\tremoved" for each one that goes. Runs until interrupted (Ctrl+C or
+       SIGTERM), then saves the cache and exits. Also takes the metrics options (see
+       startMetricsReporter()). */
+    static int runWatch (const juce::ArgumentList& args)
+    {
+        juce::Array<juce::File> roots;
+
+        // "--watch" can be given more than once, so it's looked for by hand.
+        for (int i = 0; i < args.size(); ++i)
+        {
+            juce::String path;
+
+            if (args[i].text.startsWith ("--watch="))
+                path = args[i].text.fromFirstOccurrenceOf ("=", false, false);
+            else if (args[i].text == "--watch" && i + 1 < args.size())
+                path = args[++i].text;
+            else
+                continue;
+
+            auto root = juce::File::getCurrentWorkingDirectory().getChildFile (path);
+
+            if (! root.isDirectory())
+            {
+                std::cerr << "Error: " << root.getFullPathName() << " is not a directory." << std::endl;
+                return 1;
+            }
+
+            roots.addIfNotAlreadyThere (root);
+        }
+
+        if (roots.isEmpty())
+        {
+            std::cerr << "Error: say which folder to watch with --watch <dir>." << std::endl;
+            return 1;
+        }
+
+        BatchScanner::Options scanOptions;
+        auto jobs = getOptionValue (args, "--jobs");
+        auto readAhead = getOptionValue (args, "--read-ahead");
+
+        if (jobs.isNotEmpty())
+            scanOptions.numJobs = jobs.getIntValue();
+
+        if (readAhead.isNotEmpty())
+            scanOptions.readAhead = readAhead.getIntValue();
+
+        FolderWatcher::Options watchOptions;
+        auto settle = getOptionValue (args, "--settle");
+        auto pollInterval = getOptionValue (args, "--poll-interval");
+
+        if (settle.isNotEmpty())
+            watchOptions.settleMilliseconds = juce::roundToInt (settle.getDoubleValue() * 1000.0);
+
+        if (pollInterval.isNotEmpty())
+            watchOptions.pollIntervalMilliseconds = juce::jmax (100, juce::roundToInt (pollInterval.getDoubleValue() * 1000.0));
+
+        watchOptions.forcePolling = args.containsOption ("--poll");
+
+        MetadataCache cache;
+        cache.load();
+        scanOptions.cache = &cache;
+
+        std::signal (SIGINT, requestStop);
+        std::signal (SIGTERM, requestStop);
+       #ifdef SIGBREAK
+        std::signal (SIGBREAK, requestStop);
+       #endif
+
+        scanOptions.shouldStop = [] { return stopRequested.load(); };
+
+        ScanMetrics metrics;
+        std::unique_ptr<MetricsReporter> reporter;
+        scanOptions.metrics = &metrics;
+
+        if (! startMetricsReporter (args, metrics, reporter))
+            return 1;
+
+        // The watchers only queue up what they find; it's all parsed here, so
+        // the cache is only ever written from one thread.
+        juce::CriticalSection queueLock;
+        juce::WaitableEvent queueChanged;
+        juce::Array<juce::File> changedFiles, removedFiles;
+
+        auto onChanges = [&] (const FolderWatcher::Changes& changes)
+        {
+            {
+                const juce::ScopedLock sl (queueLock);
+
+                for (const auto& file : changes.removed)
+                {
+                    changedFiles.removeFirstMatchingValue (file);
+                    removedFiles.addIfNotAlreadyThere (file);
+                }
+
+                for (const auto& file : changes.changed)
+                {
+                    removedFiles.removeFirstMatchingValue (file);
+                    changedFiles.addIfNotAlreadyThere (file);
+                }
+            }
+
+            queueChanged.signal();
+        };
+
+        // Started before the catch-up scan, so nothing arriving during it is missed.
+        juce::OwnedArray<FolderWatcher> watchers;
+
+        for (const auto& root : roots)
+        {
+            watchOptions.root = root;
+            watchers.add (new FolderWatcher (watchOptions, onChanges))->start();
+
+            std::cerr << "Watching " << root.getFullPathName()
+                      << (watchers.getLast()->isUsingNotifications() ? "" : " (polling)") << std::endl;
+        }
+
+        auto parse = [&cache, &scanOptions] (const juce::Array<juce::File>& files)
+        {
+            if (files.isEmpty())
+                return;
+
+            auto options = scanOptions;
+            options.files = files;
+
+            BatchScanner scanner (options);
+
+            scanner.run ([] (const juce::File& file, const WavMetadata& metadata)
+            {
+                std::cout << BatchScanner::formatRecord (file, metadata) << "\n";
+            });
+
+            std::cout << std::flush;
+            cache.saveChanges();
+        };
+
+        // Anything that changed or went while no one was watching.
+        {
+            juce::Array<juce::File> outOfDate;
+
+            for (const auto& root : roots)
+            {
+                for (const auto& file : cache.removeMissing (root))
+                    std::cout << file.getFullPathName() << "\tremoved\n";
+
+                for (const auto& entry : juce::RangedDirectoryIterator (root, true, "*", juce::File::findFiles))
+                    if (entry.getFile().hasFileExtension ("wav") && ! cache.contains (entry.getFile()))
+                        outOfDate.add (entry.getFile());
+            }
+
+            parse (outOfDate);
+        }
+
+        while (! stopRequested)
+        {
+            // A signal handler can't safely wake the event, so look at the flag now and then.
+            if (! queueChanged.wait (250))
+                continue;
+
+            juce::Array<juce::File> toParse, toRemove;
+
+            {
+                const juce::ScopedLock sl (queueLock);
+                toParse.swapWith (changedFiles);
+                toRemove.swapWith (removedFiles);
+            }
+
+            for (const auto& file : toRemove)
+            {
+                cache.remove (file);
+                std::cout << file.getFullPathName() << "\tremoved\n";
+            }
+
+            // Files already brought up to date by the catch-up scan don't need parsing again.
+            toParse.removeIf ([&cache] (const juce::File& file) { return cache.contains (file); });
+
+            if (toParse.isEmpty())
+            {
+                std::cout << std::flush;
+                cache.saveChanges();
+            }
+
+            parse (toParse);
+        }
+
+        std::cerr << "Stopping." << std::endl;
+
+        for (auto* watcher : watchers)
+            watcher->stop();
+
+        // Removals were already seen, so they're kept; changes are left for
+        // the next run's catch-up scan to find.
+        {
+            const juce::ScopedLock sl (queueLock);
+
+            for (const auto& file : removedFiles)
+            {
+                cache.remove (file);
+                std::cout << file.getFullPathName() << "\tremoved\n";
+            }
+        }
+
+        std::cout << std::flush;
+        auto saved = cache.save();
+
+        if (reporter != nullptr)
+            reporter->stop();
+
+        if (! saved)
+        {
+            std::cerr << "Error: could not save the cache." << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
     std::unique_ptr<MainWindow> mainWindow;
 };
 
 //==============================================================================
-// This macro generates the main() routine that launches the app.
-START_JUCE_APPLICATION (iXMLViewerApplication)
+// This is what START_JUCE_APPLICATION would generate, except that command-line
+// modes are run straight from main(). They then start without initialising
+// the GUI, creating the application or checking for another instance.
+JUCE_CREATE_APPLICATION_DEFINE (iXMLViewerApplication)
+
+#if JUCE_WINDOWS && ! defined (_CONSOLE)
+/* The viewer is a GUI-subsystem executable, so Windows gives it no console
+   and the std streams go nowhere unless they were redirected. This connects
+   whichever of them weren't to the console of the shell it was run from.
+   cmd.exe doesn't wait for GUI programs, so output can land after its next
+   prompt: "start /wait iXMLViewer --scan ..." or a redirect avoids that. */
+static void attachToParentConsole()
+{
+    auto isConnected = [] (DWORD stream)
+    {
+        auto handle = GetStdHandle (stream);
+        return handle != nullptr && handle != INVALID_HANDLE_VALUE;
+    };
+
+    auto attachOut = ! isConnected (STD_OUTPUT_HANDLE);
+    auto attachErr = ! isConnected (STD_ERROR_HANDLE);
+    auto attachIn  = ! isConnected (STD_INPUT_HANDLE);
+
+    if (! (attachOut || attachErr || attachIn) || ! AttachConsole (ATTACH_PARENT_PROCESS))
+        return;
+
+    FILE* reopened = nullptr;
+
+    if (attachOut)  freopen_s (&reopened, "CONOUT$", "w", stdout);
+    if (attachErr)  freopen_s (&reopened, "CONOUT$", "w", stderr);
+    if (attachIn)   freopen_s (&reopened, "CONIN$", "r", stdin);
+
+    // The iostreams may have failed on the old streams already.
+    std::ios::sync_with_stdio();
+    std::cout.clear();
+    std::cerr.clear();
+    std::cin.clear();
+}
+#endif
+
+extern "C" JUCE_MAIN_FUNCTION
+{
+   #if JUCE_WINDOWS && ! defined (_CONSOLE)
+    juce::ArgumentList args (ProjectInfo::projectName, juce::JUCEApplicationBase::getCommandLineParameters());
+   #else
+    juce::ArgumentList args (argc, argv);
+   #endif
+
+    if (iXMLViewerApplication::isConsoleMode (args))
+    {
+       #if JUCE_WINDOWS && ! defined (_CONSOLE)
+        attachToParentConsole();
+       #endif
+
+        return iXMLViewerApplication::runConsoleMode (args);
+    }
+
+    juce::JUCEApplicationBase::createInstance = &juce_CreateApplication;
+    return juce::JUCEApplicationBase::main (JUCE_MAIN_FUNCTION_ARGS);
+}
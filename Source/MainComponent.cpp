@@ -11,29 +11,284 @@
 */
 
 #include "MainComponent.h"
+#include "BatchScanner.h"
+#include "MetadataExporter.h"
+#include "WavMetadataReader.h"
+#include "WavMetadataWriter.h"
 
 //==============================================================================
-MainComponent::MainComponent()
+/*
+    Runs the open files through a BatchScanner, so cached files are answered
+    straight away and the rest are parsed in parallel, and streams a record
+    for each one into the export file as it arrives.
+*/
+class MainComponent::ExportThread : public juce::Thread
+{
+public:
+    ExportThread(MainComponent& ownerComponent, const juce::Array<juce::File>& filesToExport, const juce::File& target)
+        : juce::Thread("Metadata export"),
+          owner(&ownerComponent),
+          cache(ownerComponent.metadataCache),
+          files(filesToExport),
+          targetFile(target)
+    {
+    }
+
+    ~ExportThread() override
+    {
+        stopThread(10000);
+    }
+
+    void run() override
+    {
+        MetadataExporter exporter(targetFile, MetadataExporter::getFormatForFile(targetFile));
+        auto succeeded = exporter.openedOk();
+
+        if (succeeded)
+        {
+            BatchScanner::Options options;
+            options.files = files;
+            options.numJobs = juce::jlimit(1, 4, juce::SystemStats::getNumCpus() - 1);
+            options.cache = &cache;
+            options.shouldStop = [this] { return threadShouldExit(); };
+
+            BatchScanner scanner(options);
+            scanner.run([&exporter](const juce::File& file, const WavMetadata& metadata) { exporter.write(file, metadata); });
+
+            succeeded = exporter.finish();
+        }
+
+        if (threadShouldExit())
+            return;
+
+        juce::MessageManager::callAsync([safeOwner = owner, target = targetFile, numRecords = exporter.getNumRecords(), succeeded]
+            {
+                if (safeOwner != nullptr)
+                    safeOwner->handleExportFinished(target, numRecords, succeeded);
+            });
+    }
+
+private:
+    juce::Component::SafePointer<MainComponent> owner;
+    MetadataCache& cache;       // Outlives us: MainComponent stops the export before it's destroyed.
+    juce::Array<juce::File> files;
+    juce::File targetFile;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ExportThread)
+};
+
+//==============================================================================
+/*
+    Loads the cache and searches the first folders opened, which can take a
+    while for a large library, so the window doesn't have to wait for either
+    before it's first painted.
+*/
+class MainComponent::StartupThread : public juce::Thread
+{
+public:
+    StartupThread(MainComponent& ownerComponent, const juce::Array<juce::File>& filesToOpen)
+        : juce::Thread("Startup"),
+          owner(&ownerComponent),
+          cache(ownerComponent.metadataCache),
+          files(filesToOpen)
+    {
+    }
+
+    ~StartupThread() override
+    {
+        stopThread(10000);
+    }
+
+    void run() override
+    {
+        cache.load();
+
+        auto wavFiles = ParseSession::findWavFiles(files);
+
+        if (threadShouldExit())
+            return;
+
+        juce::MessageManager::callAsync([safeOwner = owner, wavFiles]
+            {
+                if (safeOwner != nullptr)
+                    safeOwner->handleStartupFinished(wavFiles);
+            });
+    }
+
+private:
+    juce::Component::SafePointer<MainComponent> owner;
+    MetadataCache& cache;       // Outlives us: MainComponent stops us before it's destroyed.
+    juce::Array<juce::File> files;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StartupThread)
+};
+
+//==============================================================================
+/*
+    Brings a LiveFileFollower up to date and hands what it read to the
+    session, so neither the read nor building its document holds up the
+    message thread while a long recording grows.
+*/
+class MainComponent::FollowJob : public juce::ThreadPoolJob
+{
+public:
+    FollowJob(MainComponent& ownerComponent, std::shared_ptr<LiveFileFollower> followerToUpdate)
+        : juce::ThreadPoolJob("Follow update"),
+          owner(&ownerComponent),
+          session(ownerComponent.session),
+          follower(std::move(followerToUpdate))
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        auto changed = follower->update();
+
+        if (changed)
+            session.setResult(follower->getFile(), follower->getMetadata(), follower->getStamp());
+
+        juce::MessageManager::callAsync([safeOwner = owner, file = follower->getFile(), changed]
+            {
+                if (safeOwner != nullptr)
+                    safeOwner->handleFollowUpdated(file, changed);
+            });
+
+        return jobHasFinished;
+    }
+
+private:
+    juce::Component::SafePointer<MainComponent> owner;
+    ParseSession& session;      // Outlives us: MainComponent stops its jobs before it's destroyed.
+    std::shared_ptr<LiveFileFollower> follower;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FollowJob)
+};
+
+//==============================================================================
+/*
+    Writes edited fields into a file and reads the result back, with the
+    session's parses held off the file until it's done, so nothing reads
+    it while it's half written.
+*/
+class MainComponent::SaveJob : public juce::ThreadPoolJob
+{
+public:
+    SaveJob(MainComponent& ownerComponent, const juce::File& fileToSave, const WavMetadata& editedMetadata)
+        : juce::ThreadPoolJob("Save edits"),
+          owner(&ownerComponent),
+          session(ownerComponent.session),
+          file(fileToSave),
+          edited(editedMetadata)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        session.holdFile(file);
+
+        // The audio isn't touched, so the peaks stay good; they just need
+        // storing again under the file's new modification time.
+        PeakCache peakCache;
+        WaveformPeaks peaks;
+        auto hadPeaks = peakCache.lookup(file, peaks);
+
+        auto result = WavMetadataWriter::write(file, edited);
+
+        if (hadPeaks)
+            peakCache.store(file, peaks);
+
+        if (result.wasOk())
+        {
+            auto stamp = MetadataCache::Stamp::of(file);
+            session.setResult(file, WavMetadataReader::read(file), stamp);
+        }
+
+        session.releaseFile(file);
+
+        juce::MessageManager::callAsync([safeOwner = owner, file = file, result]
+            {
+                if (safeOwner != nullptr)
+                    safeOwner->handleSaveFinished(file, result);
+            });
+
+        return jobHasFinished;
+    }
+
+private:
+    juce::Component::SafePointer<MainComponent> owner;
+    ParseSession& session;      // Outlives us: MainComponent stops its jobs before it's destroyed.
+    juce::File file;
+    WavMetadata edited;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SaveJob)
+};
+
+//==============================================================================
+MainComponent::MainComponent(const juce::Array<juce::File>& filesToOpen)
 {
     // --- UI Setup ---
 
     // Configure the "Open File" button
     addAndMakeVisible(openButton);
-    openButton.setButtonText("Open WAV File...");
+    openButton.setButtonText("Open WAV Files...");
     openButton.onClick = [this] { openFile(); };
 
-    // Configure the text editor for displaying the iXML content
+    // Configure the "Export" button
+    addAndMakeVisible(exportButton);
+    exportButton.setButtonText("Export...");
+    exportButton.onClick = [this] { exportFiles(); };
+
+    // Configure the "Edit" button, which writes changed fields back into the file
+    addAndMakeVisible(editButton);
+    editButton.setButtonText("Edit...");
+    editButton.onClick = [this] { editSelectedFile(); };
+
+    // Configure the toggle that keeps the selected file's view live while it's recorded
+    addAndMakeVisible(followButton);
+    followButton.onClick = [this] { updateFollowing(); };
+
+    // Configure the search box, which looks files up in the cache's index
+    addAndMakeVisible(searchBox);
+    searchBox.setTextToShowWhenEmpty("Search scene, take, tape, project...", juce::Colours::grey);
+    searchBox.onReturnKey = [this] { searchLibrary(); };
+
+    // Configure the list of open files
+    addAndMakeVisible(fileList);
+    fileList.setModel(this);
+    fileList.setRowHeight(22);
+    fileList.setColour(juce::ListBox::backgroundColourId, juce::Colours::darkgrey.darker());
+
+    // Configure the waveform overview above the metadata
+    addAndMakeVisible(waveformView);
+
+    // Configure the view for displaying the iXML content
     addAndMakeVisible(xmlDisplay);
-    xmlDisplay.setMultiLine(true);
-    xmlDisplay.setReadOnly(true);
-    // FIXED: Use the modern JUCE Font constructor that takes FontOptions
-    
-    xmlDisplay.setColour(juce::TextEditor::backgroundColourId, juce::Colours::darkgrey.darker());
-    xmlDisplay.setColour(juce::TextEditor::textColourId, juce::Colours::lightgoldenrodyellow);
-    xmlDisplay.setText("Select a Broadcast WAV file to view its iXML metadata...");
+
+    // Configure the status bar under it that shows where the time went
+    addAndMakeVisible(timingsBar);
+    timingsBar.onExpandedChanged = [this] { resized(); };
+    xmlDisplay.setMessage(filesToOpen.isEmpty() ? "Select a Broadcast WAV file to view its iXML metadata..."
+                                                : "Opening files...");
+
+    session.onFileParsed = [this](int index) { handleFileParsed(index); };
 
     // Set the size of our main component window
-    setSize(800, 600);
+    setSize(1000, 600);
+
+    startupThread = std::make_unique<StartupThread>(*this, filesToOpen);
+    startupThread->startThread();
+}
+
+MainComponent::~MainComponent()
+{
+    // Stop any export or parse still running before our members go away.
+    stopTimer();
+    startupThread = nullptr;
+    exportThread = nullptr;
+    fileJobs.removeAllJobs(true, 10000);
+    session.clear();
+    fileList.setModel(nullptr);
+    metadataCache.save();
 }
 
 //==============================================================================
@@ -43,6 +298,16 @@ void MainComponent::paint(juce::Graphics& g)
     g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
 }
 
+void MainComponent::paintOverChildren(juce::Graphics& g)
+{
+    // Outline the window while files are being dragged over it.
+    if (fileDragIsOver)
+    {
+        g.setColour(juce::Colours::lightgoldenrodyellow);
+        g.drawRect(getLocalBounds(), 3);
+    }
+}
+
 void MainComponent::resized()
 {
     // This is called when the MainComponent is resized.
@@ -51,229 +316,449 @@ void MainComponent::resized()
 
     int buttonHeight = 40;
     int padding = 10;
+    int listWidth = 260;
 
-    openButton.setBounds(area.removeFromTop(buttonHeight).reduced(padding / 2));
+    auto buttonRow = area.removeFromTop(buttonHeight);
+    exportButton.setBounds(buttonRow.removeFromRight(140).reduced(padding / 2));
+    editButton.setBounds(buttonRow.removeFromRight(100).reduced(padding / 2));
+    followButton.setBounds(buttonRow.removeFromRight(90).reduced(padding / 2));
+    openButton.setBounds(buttonRow.reduced(padding / 2));
     area.removeFromTop(padding); // Add some space
-    xmlDisplay.setBounds(area.reduced(padding));
+    area.reduce(padding, padding);
+
+    auto listArea = area.removeFromLeft(listWidth);
+    searchBox.setBounds(listArea.removeFromTop(26));
+    listArea.removeFromTop(padding / 2);
+    fileList.setBounds(listArea);
+    area.removeFromLeft(padding);
+    waveformView.setBounds(area.removeFromTop(80));
+    area.removeFromTop(padding / 2);
+    timingsBar.setBounds(area.removeFromBottom(timingsBar.getPreferredHeight()));
+    xmlDisplay.setBounds(area);
 }
 
 //==============================================================================
-/* This is the core logic function to find and display the iXML chunk. */
-void MainComponent::displayIxmlFromFile(const juce::File& file)
+/* Called on the message thread once the cache has loaded. */
+void MainComponent::handleStartupFinished(const juce::Array<juce::File>& wavFiles)
 {
-    xmlDisplay.clear();
+    startupThread = nullptr;
+
+    if (wavFiles.isEmpty())
+        xmlDisplay.setMessage("Select a Broadcast WAV file to view its iXML metadata...");
+
+    auto firstIndex = session.addWavFiles(wavFiles);
+    fileList.updateContent();
+
+    if (firstIndex >= 0)
+        fileList.selectRow(firstIndex);
 
-    // Create a stream to read the file
-    std::unique_ptr<juce::FileInputStream> inputStream(file.createInputStream());
+    openFiles(std::exchange(filesOpenedDuringStartup, {}));
+}
 
-    if (inputStream == nullptr)
+void MainComponent::openFiles(const juce::Array<juce::File>& files)
+{
+    // Parsing before the cache has loaded would miss it, and what was stored
+    // would be lost when the load finished.
+    if (startupThread != nullptr)
     {
-        xmlDisplay.setText("Error: Could not open file for reading.");
+        filesOpenedDuringStartup.addArray(files);
         return;
     }
 
-    // A WAV file is a type of RIFF container. We need to manually parse it
-    // to find the iXML chunk, as JUCE's audio format readers are focused on audio data.
+    auto firstIndex = session.addFiles(files);
+    fileList.updateContent();
 
-    // Check for "RIFF" header
-    char riffHeader[4];
-    if (inputStream->read(riffHeader, 4) != 4 || juce::String(riffHeader, 4) != "RIFF")
-    {
-        xmlDisplay.setText("Error: This does not appear to be a valid RIFF (WAV) file.");
+    if (firstIndex >= 0)
+        fileList.selectRow(firstIndex);
+}
+
+/* Called whenever the selection moves, to show that file's result. */
+void MainComponent::showSelectedFile()
+{
+    auto row = fileList.getSelectedRow();
+
+    if (row < 0)
         return;
-    }
 
-    // Skip overall file size (4 bytes)
-    inputStream->skipNextBytes(4);
+    session.setCursor(row);
+    updateFollowing();
 
-    // Check for "WAVE" format identifier
-    char waveHeader[4];
-    if (inputStream->read(waveHeader, 4) != 4 || juce::String(waveHeader, 4) != "WAVE")
+    if (session.getDocument(row) != nullptr)
     {
-        xmlDisplay.setText("Error: This is not a WAVE file.");
-        return;
+        showResult(row, false);
     }
+    else
+    {
+        xmlDisplay.setMessage("Reading " + session.getFile(row).getFileName() + "...");
+        timingsBar.clearTimings();
+        waveformView.clear();
+    }
+}
 
-    bool ixmlFound = false;
-    bool bextFound = false;
-    juce::String formatSummary;
-    juce::String bextSummary;
-    juce::String ixmlContent;
+/* Puts a parsed file's document in the display and its timings in the status bar. */
+void MainComponent::showResult(int row, bool isUpdate)
+{
+    auto document = session.getDocument(row);
+    auto metadata = session.getMetadata(row);
 
-    // Loop through all the chunks in the file
-    while (!inputStream->isExhausted())
-    {
-        char chunkId[4];
-        if (inputStream->read(chunkId, 4) != 4)
-            break; // End of file reached prematurely
+    if (document == nullptr || metadata == nullptr)
+        return;
 
-        // Read chunk size (little-endian 32-bit integer)
-        juce::int32 chunkSize = inputStream->readInt();
-        if (chunkSize < 0)
-        {
-            xmlDisplay.setText("Error: Encountered an invalid chunk size.");
-            return;
-        }
+    auto timings = metadata->timings;
 
-        auto currentChunkId = juce::String(chunkId, 4);
+    {
+        // The tree only builds what's on screen, and painting happens later,
+        // so this is the cost of handing the rows over rather than of drawing them.
+        const ParseTimings::ScopedTimer timer(&timings, ParseTimings::display);
 
-        if (currentChunkId == "fmt ")
-        {
-            // It's the format chunk. Let's read the data.
-            // The input stream is little-endian by default which is correct for WAV.
-            short audioFormat = inputStream->readShort();
-            short numChannels = inputStream->readShort();
-            int sampleRate = inputStream->readInt();
-            inputStream->skipNextBytes(4); // Skip Byte Rate
-            inputStream->skipNextBytes(2); // Skip Block Align
-            short bitsPerSample = inputStream->readShort();
-
-            formatSummary << "WAV File Properties:\n";
-            formatSummary << "--------------------\n";
-            formatSummary << "Audio Format: " << (audioFormat == 1 ? "PCM" : "Compressed (Format ID: " + juce::String(audioFormat) + ")") << "\n";
-            formatSummary << "Channels: " << juce::String(numChannels) << "\n";
-            formatSummary << "Sample Rate: " << juce::String(sampleRate) << " Hz\n";
-            formatSummary << "Bit Depth: " << juce::String(bitsPerSample) << " bits\n";
-
-            // The fmt chunk can sometimes be larger than the standard 16 bytes.
-            // We need to skip any extra bytes to get to the next chunk correctly.
-            int bytesRead = 2 + 2 + 4 + 4 + 2 + 2;
-            if (chunkSize > bytesRead)
-            {
-                inputStream->skipNextBytes(chunkSize - bytesRead);
-            }
-        }
-        else if (currentChunkId == "bext")
-        {
-            // It's the Broadcast Wave Format (BWF) extension chunk.
-            bextFound = true;
-
-            auto readBextField = [&inputStream](int numBytes) -> juce::String
-                {
-                    juce::MemoryBlock temp(numBytes);
-                    inputStream->read(temp.getData(), numBytes);
-                    // Create a string and trim any trailing null characters
-                    return juce::String::fromUTF8(static_cast<const char*>(temp.getData()), numBytes).trim();
-                };
-
-            bextSummary << "Broadcast Extension (bext) Data:\n";
-            bextSummary << "----------------------------------\n";
-            bextSummary << "Description: " << readBextField(256) << "\n";
-            bextSummary << "Originator: " << readBextField(32) << "\n";
-            bextSummary << "Originator Ref: " << readBextField(32) << "\n";
-            bextSummary << "Origination Date: " << readBextField(10) << "\n";
-            bextSummary << "Origination Time: " << readBextField(8) << "\n";
-            bextSummary << "Time Reference: " << juce::String(inputStream->readInt64()) << " (samples since midnight)\n";
-
-            // Skip the rest of the bext chunk to get to the next one
-            // We've read 256+32+32+10+8+8 = 346 bytes.
-            int bextBytesRead = 346;
-            if (chunkSize > bextBytesRead)
-            {
-                inputStream->skipNextBytes(chunkSize - bextBytesRead);
-            }
-        }
-        else if (currentChunkId == "iXML")
-        {
-            // We found it!
-            ixmlFound = true;
-
-            // Read the chunk data into memory
-            juce::MemoryBlock chunkData;
-            // FIXED: Correctly resize the memory block and read the data into its raw data pointer
-            chunkData.setSize(chunkSize);
-            if (inputStream->read(chunkData.getData(), chunkSize) == chunkSize)
-            {
-                // The data is XML, which is text. We can convert it to a String.
-                // The iXML spec says it should be UTF-8.
-                auto xmlString = juce::String::fromUTF8(static_cast<const char*>(chunkData.getData()), (int)chunkData.getSize());
-
-                // Try to parse and pretty-print it for readability
-                if (auto parsedXml = juce::XmlDocument::parse(xmlString))
-                {
-                    ixmlContent = parsedXml->toString();
-                }
-                else
-                {
-                    // If parsing fails, just show the raw text
-                    ixmlContent = xmlString;
-                }
-            }
-        }
+        if (isUpdate)
+            xmlDisplay.updateDocument(std::move(document));
         else
-        {
-            // This is not the chunk we're looking for. Skip over its data.
-            inputStream->skipNextBytes(chunkSize);
-
-            // RIFF chunks are padded to be an even number of bytes.
-            // If chunkSize is odd, we need to skip one more padding byte.
-            if (chunkSize % 2 != 0)
-            {
-                inputStream->skipNextBytes(1);
-            }
-        }
+            xmlDisplay.setDocument(std::move(document));
     }
 
-    // Assemble the final string for display
-    juce::String finalText;
-    if (formatSummary.isNotEmpty())
+    timingsBar.setTimings(timings);
+
+    // A file that's still being recorded keeps the waveform it had when it
+    // was selected; rebuilding it on every update would mean re-reading all
+    // the audio each time. One that's being saved gets it back once it's written.
+    if (! isUpdate && session.getFile(row) != fileBeingSaved)
+        waveformView.showFile(session.getFile(row), metadata->format);
+}
+
+/* Called on the message thread when a background parse has finished. */
+void MainComponent::handleFileParsed(int index)
+{
+    fileList.repaintRow(index);
+
+    if (index == fileList.getSelectedRow())
+        showResult(index, false);
+}
+
+/* Replaces the open files with every previously parsed file matching the search. */
+void MainComponent::searchLibrary()
+{
+    // More than this isn't useful to step through, and each one has to be stat'ed.
+    constexpr int maxResults = 500;
+
+    auto query = searchBox.getText().trim();
+
+    if (query.isEmpty())
+        return;
+
+    if (startupThread != nullptr)
     {
-        finalText << formatSummary;
+        xmlDisplay.setMessage("The library is still loading...");
+        return;
     }
-    else
+
+    auto results = metadataCache.getSearchIndex().search(query, maxResults);
+
+    if (results.isEmpty())
     {
-        finalText << "WAV Format data (fmt chunk) not found.\n";
+        xmlDisplay.setMessage("No parsed files match \"" + query + "\".");
+        return;
     }
 
-    finalText << "\n";
+    session.clear();
+    fileList.deselectAllRows();
+    openFiles(results);
+
+    if (session.getNumFiles() == 0)
+        xmlDisplay.setMessage("The files matching \"" + query + "\" have been moved or deleted.");
+}
 
-    if (bextFound)
+//==============================================================================
+bool MainComponent::isInterestedInFileDrag(const juce::StringArray& files)
+{
+    for (const auto& path : files)
     {
-        finalText << bextSummary;
+        juce::File file(path);
+
+        if (file.isDirectory() || file.hasFileExtension("wav"))
+            return true;
     }
-    else
+
+    return false;
+}
+
+void MainComponent::fileDragEnter(const juce::StringArray&, int, int)
+{
+    fileDragIsOver = true;
+    repaint();
+}
+
+void MainComponent::fileDragExit(const juce::StringArray&)
+{
+    fileDragIsOver = false;
+    repaint();
+}
+
+void MainComponent::filesDropped(const juce::StringArray& files, int, int)
+{
+    fileDragIsOver = false;
+    repaint();
+
+    juce::Array<juce::File> droppedFiles;
+
+    for (const auto& path : files)
+        droppedFiles.add(juce::File(path));
+
+    openFiles(droppedFiles);
+}
+
+//==============================================================================
+int MainComponent::getNumRows()
+{
+    return session.getNumFiles();
+}
+
+void MainComponent::paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected)
+{
+    if (rowIsSelected)
+        g.fillAll(juce::Colours::lightgoldenrodyellow.withAlpha(0.2f));
+
+    // Files that haven't been parsed yet are dimmed.
+    auto isParsed = session.getDocument(rowNumber) != nullptr;
+
+    g.setColour(juce::Colours::lightgoldenrodyellow.withAlpha(isParsed ? 1.0f : 0.5f));
+    g.setFont(juce::Font(juce::FontOptions(14.0f)));
+    g.drawText(session.getFile(rowNumber).getFileName(), 6, 0, width - 6, height, juce::Justification::centredLeft, true);
+}
+
+void MainComponent::selectedRowsChanged(int)
+{
+    showSelectedFile();
+}
+
+//==============================================================================
+/* Starts or stops following, and makes sure it's the selected file that's followed. */
+void MainComponent::updateFollowing()
+{
+    auto row = fileList.getSelectedRow();
+
+    if (! followButton.getToggleState() || row < 0)
     {
-        finalText << "No Broadcast Extension (bext) chunk found in this file.\n";
+        stopTimer();
+        follower = nullptr;
+        return;
     }
 
-    finalText << "\n";
+    auto file = session.getFile(row);
+
+    startTimer(1000);
 
-    if (ixmlFound)
+    if (follower == nullptr || follower->getFile() != file)
     {
-        finalText << "iXML Metadata:\n";
-        finalText << "--------------------\n";
-        finalText << ixmlContent;
+        // The first update is a full read; after that only what changed is read.
+        follower = std::make_shared<LiveFileFollower>(file);
+        timerCallback();
     }
-    else
+}
+
+void MainComponent::timerCallback()
+{
+    auto row = fileList.getSelectedRow();
+
+    if (follower == nullptr || session.getFile(row) != follower->getFile())
     {
-        finalText << "No iXML chunk was found in this file.";
+        updateFollowing();
+        return;
     }
 
-    xmlDisplay.setText(finalText);
+    // A read that takes longer than a tick just means the next one is skipped.
+    if (isFollowUpdating)
+        return;
+
+    isFollowUpdating = true;
+    fileJobs.addJob(new FollowJob(*this, follower), true);
 }
 
-/* Opens a file chooser dialog to select a WAV file. */
+/* Called on the message thread once a follower's update has been stored in the session. */
+void MainComponent::handleFollowUpdated(const juce::File& file, bool changed)
+{
+    isFollowUpdating = false;
+
+    auto index = session.indexOf(file);
+
+    if (! changed || index < 0)
+        return;
+
+    fileList.repaintRow(index);
+
+    if (index == fileList.getSelectedRow())
+        showResult(index, true);
+}
+
+//==============================================================================
+/* Opens a file chooser dialog to select one or more WAV files. */
 void MainComponent::openFile()
 {
     // Use JUCE's FileChooser to create a native "open file" dialog
     fileChooser = std::make_unique<juce::FileChooser>(
-        "Select a WAV file to open...",
+        "Select WAV files to open...",
         juce::File{},
         "*.wav");
 
-    auto chooserFlags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+    auto chooserFlags = juce::FileBrowserComponent::openMode
+                      | juce::FileBrowserComponent::canSelectFiles
+                      | juce::FileBrowserComponent::canSelectMultipleItems;
 
     // Launch the dialog asynchronously
     fileChooser->launchAsync(chooserFlags, [this](const juce::FileChooser& fc)
         {
-            auto file = fc.getResult();
-            if (file != juce::File{})
+            auto files = fc.getResults();
+            if (! files.isEmpty())
             {
-                // A file was selected, so let's process it
-                displayIxmlFromFile(file);
+                // Files were selected, so let's queue them all up
+                openFiles(files);
             }
         });
 }
 
+//==============================================================================
+/* Asks where to export the open files to, or cancels the export that's running. */
+void MainComponent::exportFiles()
+{
+    if (exportThread != nullptr)
+    {
+        exportThread = nullptr;
+        exportButton.setButtonText("Export...");
+        return;
+    }
+
+    if (session.getNumFiles() == 0)
+    {
+        xmlDisplay.setMessage("Open some WAV files before exporting their metadata.");
+        return;
+    }
+
+    fileChooser = std::make_unique<juce::FileChooser>(
+        "Export metadata as JSON Lines or CSV...",
+        juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("metadata.jsonl"),
+        "*.jsonl;*.csv");
+
+    auto chooserFlags = juce::FileBrowserComponent::saveMode
+                      | juce::FileBrowserComponent::canSelectFiles
+                      | juce::FileBrowserComponent::warnAboutOverwriting;
+
+    fileChooser->launchAsync(chooserFlags, [this](const juce::FileChooser& fc)
+        {
+            auto target = fc.getResult();
+
+            if (target != juce::File())
+                startExport(target);
+        });
+}
+
+void MainComponent::startExport(const juce::File& targetFile)
+{
+    juce::Array<juce::File> files;
+
+    for (int i = 0; i < session.getNumFiles(); ++i)
+        files.add(session.getFile(i));
+
+    exportThread = std::make_unique<ExportThread>(*this, files, targetFile);
+    exportThread->startThread();
+    exportButton.setButtonText("Cancel Export");
+}
 
+/* Called on the message thread once every record has been written. */
+void MainComponent::handleExportFinished(const juce::File& targetFile, int numRecords, bool succeeded)
+{
+    exportThread = nullptr;
+    exportButton.setButtonText("Export...");
+
+    if (succeeded)
+        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::InfoIcon, "Export finished",
+                                               "Wrote " + juce::String(numRecords) + " records to " + targetFile.getFullPathName() + ".");
+    else
+        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export failed",
+                                               "Couldn't write to " + targetFile.getFullPathName() + ".");
+}
 
+//==============================================================================
+/* Asks for new values of the editable fields of the selected file. */
+void MainComponent::editSelectedFile()
+{
+    auto row = fileList.getSelectedRow();
+    auto metadata = row >= 0 ? session.getMetadata(row) : nullptr;
+
+    if (metadata == nullptr || metadata->status.failed())
+    {
+        xmlDisplay.setMessage("Select a WAV file that has been read before editing it.");
+        return;
+    }
+
+    if (followButton.getToggleState())
+    {
+        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Can't edit this file",
+                                               "Turn off Follow before editing a file that's still being recorded.");
+        return;
+    }
+
+    auto file = session.getFile(row);
+    auto* window = new juce::AlertWindow("Edit metadata", file.getFileName(), juce::MessageBoxIconType::NoIcon);
+
+    window->addTextEditor("project", metadata->ixml.project, "Project:");
+    window->addTextEditor("scene", metadata->ixml.scene, "Scene:");
+    window->addTextEditor("take", metadata->ixml.take, "Take:");
+    window->addTextEditor("tape", metadata->ixml.tape, "Tape:");
+    window->addTextEditor("description", metadata->bext.description, "Description:");
+    window->addButton("Save", 1, juce::KeyPress(juce::KeyPress::returnKey));
+    window->addButton("Cancel", 0, juce::KeyPress(juce::KeyPress::escapeKey));
+
+    // The window deletes itself once the callback has run.
+    window->enterModalState(true, juce::ModalCallbackFunction::create(
+        [safeThis = juce::Component::SafePointer<MainComponent>(this), window, file, edited = *metadata](int result) mutable
+        {
+            if (result != 1 || safeThis == nullptr)
+                return;
+
+            edited.ixml.project = window->getTextEditorContents("project");
+            edited.ixml.scene = window->getTextEditorContents("scene");
+            edited.ixml.take = window->getTextEditorContents("take");
+            edited.ixml.tape = window->getTextEditorContents("tape");
+            edited.bext.description = window->getTextEditorContents("description");
+
+            safeThis->saveEdits(file, edited);
+        }), true);
+}
+
+/* Starts writing the edited fields into the file, once nothing else is reading it. */
+void MainComponent::saveEdits(const juce::File& file, const WavMetadata& edited)
+{
+    // Its waveform is read straight from the audio, so has to stop before the
+    // file is rewritten; the session's parses are held off by the job itself.
+    waveformView.stopReading(file);
+
+    fileBeingSaved = file;
+    editButton.setEnabled(false);
+    fileJobs.addJob(new SaveJob(*this, file, edited), true);
+}
+
+/* Called on the message thread once the edits have been written and read back. */
+void MainComponent::handleSaveFinished(const juce::File& file, const juce::Result& result)
+{
+    fileBeingSaved = juce::File();
+    editButton.setEnabled(true);
+
+    if (result.failed())
+        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Couldn't save the changes",
+                                               result.getErrorMessage());
+
+    auto index = session.indexOf(file);
+
+    if (index < 0)
+        return;
+
+    fileList.repaintRow(index);
+
+    if (index != fileList.getSelectedRow())
+        return;
+
+    showResult(index, true);
+
+    if (auto metadata = session.getMetadata(index))
+        waveformView.showFile(file, metadata->format);
+}
@@ -13,33 +13,115 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "WavMetadata.h"
+#include "MetadataView.h"
+#include "MetadataCache.h"
+#include "ParseSession.h"
+#include "LiveFileFollower.h"
+#include "TimingsBar.h"
+#include "WaveformView.h"
 
 //==============================================================================
 /*
     This component lives inside our window, and this is where you should put all
     your controls and content.
 */
-class MainComponent : public juce::Component
+class MainComponent : public juce::Component,
+                      public juce::FileDragAndDropTarget,
+                      private juce::ListBoxModel,
+                      private juce::Timer
 {
 public:
     //==============================================================================
-    MainComponent();
+    /* The window can be shown straight away: the cache, and any files to
+       open, are loaded in the background and shown once they're ready. */
+    explicit MainComponent(const juce::Array<juce::File>& filesToOpen = {});
+    ~MainComponent() override;
 
     //==============================================================================
     void paint(juce::Graphics&) override;
+    void paintOverChildren(juce::Graphics&) override;
     void resized() override;
 
+    //==============================================================================
+    /* Adds files (or folders of them) to the session and selects the first one. */
+    void openFiles(const juce::Array<juce::File>& files);
+
+    // --- FileDragAndDropTarget ---
+    bool isInterestedInFileDrag(const juce::StringArray& files) override;
+    void fileDragEnter(const juce::StringArray& files, int x, int y) override;
+    void fileDragExit(const juce::StringArray& files) override;
+    void filesDropped(const juce::StringArray& files, int x, int y) override;
+
 private:
     //==============================================================================
     // --- Private Methods ---
-    void displayIxmlFromFile(const juce::File& file);
+    void handleStartupFinished(const juce::Array<juce::File>& wavFiles);
+    void showSelectedFile();
+    void showResult(int row, bool isUpdate);
+    void handleFileParsed(int index);
     void openFile();
+    void searchLibrary();
+    void exportFiles();
+    void startExport(const juce::File& targetFile);
+    void handleExportFinished(const juce::File& targetFile, int numRecords, bool succeeded);
+    void editSelectedFile();
+    void saveEdits(const juce::File& file, const WavMetadata& edited);
+    void handleSaveFinished(const juce::File& file, const juce::Result& result);
+
+    // --- ListBoxModel ---
+    int getNumRows() override;
+    void paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected) override;
+    void selectedRowsChanged(int lastRowSelected) override;
+
+    // --- Timer ---
+    void timerCallback() override;
+    void updateFollowing();
+    void handleFollowUpdated(const juce::File& file, bool changed);
 
     // --- Member Variables ---
     juce::TextButton openButton;
-    juce::TextEditor xmlDisplay;
+    juce::TextButton exportButton;
+    juce::TextButton editButton;
+    juce::TextEditor searchBox;
+    juce::ToggleButton followButton { "Follow" };
+    juce::ListBox fileList;
+    WaveformView waveformView;
+    MetadataView xmlDisplay;
+    TimingsBar timingsBar;
     std::unique_ptr<juce::FileChooser> fileChooser;
+    bool fileDragIsOver = false;
+
+    // Files that haven't changed since they were last parsed are shown from here.
+    MetadataCache metadataCache;
+
+    // Every open file; parsing happens in the background, ahead of the selection.
+    ParseSession session { metadataCache };
+
+    // While "Follow" is on, re-reads the selected file as it's being recorded.
+    // Shared with the job updating it, which may outlive a change of selection.
+    class FollowJob;
+    std::shared_ptr<LiveFileFollower> follower;
+    bool isFollowUpdating = false;
+
+    // Loads the cache and the first files, while the window is already up.
+    // Anything opened in the meantime waits here until it's done.
+    class StartupThread;
+    std::unique_ptr<StartupThread> startupThread;
+    juce::Array<juce::File> filesOpenedDuringStartup;
+
+    // Writes a record for every open file in the background, while it's running.
+    class ExportThread;
+    std::unique_ptr<ExportThread> exportThread;
+
+    // Edited fields are written back into the file in the background, while
+    // its waveform is kept from reading it.
+    class SaveJob;
+    juce::File fileBeingSaved;
 
+    // Reads and writes files outside the session, one at a time. Declared last so its
+    // jobs are stopped before the session and cache they write to go away.
+    juce::ThreadPool fileJobs { 1 };
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MainComponent)
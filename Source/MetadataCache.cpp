@@ -0,0 +1,408 @@
+/*
+  ==============================================================================
+
+    MetadataCache.cpp
+
+  ==============================================================================
+*/
+
+#include "MetadataCache.h"
+
+namespace
+{
+    // Bump the version whenever WavMetadata::writeTo() changes, so old
+    // caches are thrown away rather than misread.
+    constexpr int cacheMagic = 0x434d5869;     // "iXMC"
+    constexpr int journalMagic = 0x4a4d5869;   // "iXMJ"
+    constexpr int cacheVersion = 6;
+
+    // What each journal record says happened to its path.
+    constexpr char storedRecord = 'S';
+    constexpr char removedRecord = 'R';
+}
+
+//==============================================================================
+MetadataCache::MetadataCache(const juce::File& fileToUse)
+    : indexFile(fileToUse)
+{
+}
+
+juce::File MetadataCache::getDefaultIndexFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("iXMLViewer")
+        .getChildFile("metadata.cache");
+}
+
+juce::File MetadataCache::getSearchIndexFile() const
+{
+    return indexFile.withFileExtension("index");
+}
+
+juce::File MetadataCache::getJournalFile() const
+{
+    return indexFile.withFileExtension("journal");
+}
+
+//==============================================================================
+bool MetadataCache::load()
+{
+    std::unordered_map<juce::String, Entry> loadedEntries;
+
+    juce::FileInputStream fileStream(indexFile);
+
+    if (! fileStream.openedOk())
+        return false;
+
+    juce::GZIPDecompressorInputStream in(fileStream);
+
+    if (in.readInt() != cacheMagic || in.readInt() != cacheVersion)
+        return false;
+
+    auto loadedGeneration = in.readInt64();
+    auto numEntries = in.readInt();
+
+    if (numEntries < 0)
+        return false;
+
+    for (int i = 0; i < numEntries; ++i)
+    {
+        auto path = in.readString();
+
+        Entry entry;
+        entry.stamp.size = in.readInt64();
+        entry.stamp.modificationTime = in.readInt64();
+
+        auto dataSize = in.readInt();
+
+        if (path.isEmpty() || dataSize <= 0
+             || in.readIntoMemoryBlock(entry.data, dataSize) != (size_t) dataSize)
+            return false;
+
+        loadedEntries[path] = std::move(entry);
+    }
+
+    // The search index is saved with the cache, so it only needs rebuilding
+    // if it's missing or was written by an older version.
+    auto rebuildIndex = ! searchIndex.load(getSearchIndexFile())
+                         || searchIndex.getNumFiles() != (int) loadedEntries.size();
+
+    if (rebuildIndex)
+    {
+        searchIndex.clear();
+
+        for (const auto& [path, entry] : loadedEntries)
+        {
+            WavMetadata metadata;
+            juce::MemoryInputStream entryStream(entry.data, false);
+
+            if (metadata.readFrom(entryStream))
+                searchIndex.add(juce::File(path), metadata);
+        }
+    }
+
+    // Then whatever has changed since the index file was written.
+    int numReplayed = 0;
+    auto journalIsWhole = replayJournal(loadedGeneration, loadedEntries, numReplayed);
+
+    const juce::ScopedLock sl(lock);
+    entries = std::move(loadedEntries);
+    unjournalled.clear();
+    journalMatches = journalIsWhole;
+
+    // Records appended after a broken one would never be read, and starting
+    // the journal again would lose the ones before it, so the next save is a
+    // full one.
+    generation = (journalIsWhole || numReplayed == 0) ? loadedGeneration : 0;
+    needsSaving = rebuildIndex || numReplayed > 0;
+    return true;
+}
+
+bool MetadataCache::replayJournal(juce::int64 indexGeneration, std::unordered_map<juce::String, Entry>& loadedEntries,
+                                  int& numReplayed)
+{
+    juce::FileInputStream in(getJournalFile());
+
+    if (! in.openedOk() || in.readInt() != journalMagic || in.readInt() != cacheVersion
+         || in.readInt64() != indexGeneration)
+        return false;
+
+    // A record cut short by a crash ends it; everything before that stands.
+    while (! in.isExhausted())
+    {
+        auto kind = in.readByte();
+        auto path = in.readString();
+
+        if (path.isEmpty())
+            return false;
+
+        if (kind == removedRecord)
+        {
+            loadedEntries.erase(path);
+            searchIndex.remove(juce::File(path));
+        }
+        else if (kind == storedRecord)
+        {
+            Entry entry;
+            entry.stamp.size = in.readInt64();
+            entry.stamp.modificationTime = in.readInt64();
+
+            auto dataSize = in.readInt();
+
+            if (dataSize <= 0 || in.readIntoMemoryBlock(entry.data, dataSize) != (size_t) dataSize)
+                return false;
+
+            WavMetadata metadata;
+            juce::MemoryInputStream entryStream(entry.data, false);
+
+            if (metadata.readFrom(entryStream))
+                searchIndex.add(juce::File(path), metadata);
+
+            loadedEntries[path] = std::move(entry);
+        }
+        else
+        {
+            return false;
+        }
+
+        ++numReplayed;
+    }
+
+    return true;
+}
+
+bool MetadataCache::save()
+{
+    const juce::ScopedLock sl(lock);
+
+    if (! needsSaving)
+        return true;
+
+    if (! indexFile.getParentDirectory().createDirectory())
+        return false;
+
+    // Write to a temporary file first, so a crash mid-save can't leave a
+    // half-written cache behind.
+    juce::TemporaryFile temp(indexFile);
+    auto newGeneration = juce::jmax((juce::int64) 1, juce::Random::getSystemRandom().nextInt64() & 0x7fffffffffffffff);
+
+    {
+        juce::FileOutputStream fileStream(temp.getFile());
+
+        if (! fileStream.openedOk())
+            return false;
+
+        juce::GZIPCompressorOutputStream out(fileStream, 1);
+
+        out.writeInt(cacheMagic);
+        out.writeInt(cacheVersion);
+        out.writeInt64(newGeneration);
+        out.writeInt((int) entries.size());
+
+        for (const auto& [path, entry] : entries)
+        {
+            out.writeString(path);
+            out.writeInt64(entry.stamp.size);
+            out.writeInt64(entry.stamp.modificationTime);
+            out.writeInt((int) entry.data.getSize());
+            out.write(entry.data.getData(), entry.data.getSize());
+        }
+
+        out.flush();
+    }
+
+    if (! temp.overwriteTargetFileWithTemporary())
+        return false;
+
+    // Everything in the journal is in the new file now. Were deleting it to
+    // fail, the new generation keeps it from being replayed.
+    generation = newGeneration;
+    journalMatches = false;
+    unjournalled.clear();
+    getJournalFile().deleteFile();
+
+    if (! searchIndex.save(getSearchIndexFile()))
+        return false;
+
+    needsSaving = false;
+    return true;
+}
+
+bool MetadataCache::saveChanges()
+{
+    const juce::ScopedLock sl(lock);
+
+    if (unjournalled.empty())
+        return true;
+
+    auto journalFile = getJournalFile();
+
+    if (generation == 0 || (journalMatches && journalFile.getSize() >= indexFile.getSize()))
+        return save();
+
+    // One left over from an earlier index file is started again.
+    if (! journalMatches && ! journalFile.deleteFile())
+        return false;
+
+    juce::FileOutputStream out(journalFile);
+
+    if (! out.openedOk())
+        return false;
+
+    if (! journalMatches)
+    {
+        out.writeInt(journalMagic);
+        out.writeInt(cacheVersion);
+        out.writeInt64(generation);
+    }
+
+    for (const auto& path : unjournalled)
+    {
+        auto found = entries.find(path);
+
+        out.writeByte(found != entries.end() ? storedRecord : removedRecord);
+        out.writeString(path);
+
+        if (found != entries.end())
+        {
+            const auto& entry = found->second;
+            out.writeInt64(entry.stamp.size);
+            out.writeInt64(entry.stamp.modificationTime);
+            out.writeInt((int) entry.data.getSize());
+            out.write(entry.data.getData(), entry.data.getSize());
+        }
+    }
+
+    out.flush();
+
+    if (out.getStatus().failed())
+    {
+        // The journal may end in half a record now, so the next save is a full one.
+        generation = 0;
+        return false;
+    }
+
+    journalMatches = true;
+    unjournalled.clear();
+    return true;
+}
+
+//==============================================================================
+MetadataCache::Stamp MetadataCache::Stamp::of(const juce::File& file)
+{
+    return { file.getSize(), file.getLastModificationTime().toMilliseconds() };
+}
+
+bool MetadataCache::lookup(const juce::File& file, WavMetadata& result, Stamp* stampChecked) const
+{
+    // Stat the file before taking the lock, as that can be slow on network volumes.
+    auto path = file.getFullPathName();
+    auto stamp = Stamp::of(file);
+
+    if (stampChecked != nullptr)
+        *stampChecked = stamp;
+
+    juce::MemoryBlock data;
+
+    {
+        const juce::ScopedLock sl(lock);
+        auto found = entries.find(path);
+
+        if (found == entries.end())
+            return false;
+
+        const auto& entry = found->second;
+
+        if (entry.stamp != stamp)
+            return false;
+
+        data = entry.data;
+    }
+
+    juce::MemoryInputStream in(data, false);
+    return result.readFrom(in);
+}
+
+void MetadataCache::store(const juce::File& file, const Stamp& stampBeforeReading, const WavMetadata& metadata)
+{
+    if (metadata.cancelled)
+        return;
+
+    Entry entry;
+    entry.stamp = stampBeforeReading;
+
+    {
+        juce::MemoryOutputStream out(entry.data, false);
+        metadata.writeTo(out);
+    }
+
+    searchIndex.add(file, metadata);
+
+    auto path = file.getFullPathName();
+
+    const juce::ScopedLock sl(lock);
+    entries[path] = std::move(entry);
+    unjournalled.insert(path);
+    needsSaving = true;
+}
+
+void MetadataCache::remove(const juce::File& file)
+{
+    searchIndex.remove(file);
+
+    auto path = file.getFullPathName();
+
+    const juce::ScopedLock sl(lock);
+
+    if (entries.erase(path) > 0)
+    {
+        unjournalled.insert(path);
+        needsSaving = true;
+    }
+}
+
+juce::Array<juce::File> MetadataCache::removeMissing(const juce::File& directory)
+{
+    juce::Array<juce::File> underDirectory, missing;
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (const auto& [path, entry] : entries)
+        {
+            juce::File file(path);
+
+            if (file.isAChildOf(directory))
+                underDirectory.add(file);
+        }
+    }
+
+    // Stat the files without holding the lock, as in lookup().
+    for (const auto& file : underDirectory)
+    {
+        if (! file.existsAsFile())
+        {
+            remove(file);
+            missing.add(file);
+        }
+    }
+
+    return missing;
+}
+
+bool MetadataCache::contains(const juce::File& file) const
+{
+    auto path = file.getFullPathName();
+    auto stamp = Stamp::of(file);
+
+    const juce::ScopedLock sl(lock);
+    auto found = entries.find(path);
+
+    return found != entries.end() && found->second.stamp == stamp;
+}
+
+int MetadataCache::getNumEntries() const
+{
+    const juce::ScopedLock sl(lock);
+    return (int) entries.size();
+}
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    MetadataCache.h
+
+    A persistent index of parsed WAV metadata, keyed by file path and
+    validated against the file's size and modification time. A hit only
+    needs the file's directory entry, never its contents. A search index
+    over the same entries is kept next to it. Only depends on juce_core.
+
+    Rewriting the whole file is too slow to do after every few files, so
+    saveChanges() appends what changed to a journal beside it instead, and
+    load() replays that. The journal is folded back in by the next save().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WavMetadata.h"
+#include "MetadataSearchIndex.h"
+#include <unordered_map>
+#include <unordered_set>
+
+//==============================================================================
+class MetadataCache
+{
+public:
+    //==============================================================================
+    /* What an entry is validated against: the file's size and modification time. */
+    struct Stamp
+    {
+        juce::int64 size = 0;
+        juce::int64 modificationTime = 0;
+
+        /* Stats the file. */
+        static Stamp of(const juce::File& file);
+
+        bool operator==(const Stamp& other) const noexcept  { return size == other.size && modificationTime == other.modificationTime; }
+        bool operator!=(const Stamp& other) const noexcept  { return ! operator==(other); }
+    };
+
+    //==============================================================================
+    explicit MetadataCache(const juce::File& indexFile = getDefaultIndexFile());
+
+    /* The cache file in the user's application data directory. */
+    static juce::File getDefaultIndexFile();
+
+    //==============================================================================
+    /* Replaces the in-memory entries with those in the index file and its
+       journal. A missing, corrupt or out-of-date file just leaves the cache
+       empty. The search index is loaded too, or rebuilt from the entries if
+       it doesn't match. */
+    bool load();
+
+    /* Writes the entries and search index back if anything has changed, and
+       clears the journal. */
+    bool save();
+
+    /* Saves what's changed since the last save by appending it to the
+       journal, which costs next to nothing however big the cache is. Falls
+       back to a full save() if there's no index file yet or the journal has
+       grown as big as it is. */
+    bool saveChanges();
+
+    //==============================================================================
+    /* Fills in the result and returns true if an entry exists for this file and
+       its size and modification time still match. The stamp it checked is
+       handed back if asked for, so that a miss can be parsed and stored
+       without another stat. Thread-safe. */
+    bool lookup(const juce::File& file, WavMetadata& result, Stamp* stampChecked = nullptr) const;
+
+    /* Records the metadata for a file, as it was when the stamp was taken.
+       Take the stamp before reading: for a file that's still being written,
+       one taken after could already cover bytes the parse never saw, and
+       later lookups would keep answering with the incomplete result.
+       Cancelled reads are ignored. Thread-safe. */
+    void store(const juce::File& file, const Stamp& stampBeforeReading, const WavMetadata& metadata);
+
+    /* Forgets a file, e.g. once it's been deleted. Thread-safe. */
+    void remove(const juce::File& file);
+
+    /* Forgets every file under a directory that no longer exists, e.g. ones
+       deleted while nothing was watching, and returns them. Thread-safe. */
+    juce::Array<juce::File> removeMissing(const juce::File& directory);
+
+    /* True if lookup() would succeed, without decoding the entry. Thread-safe. */
+    bool contains(const juce::File& file) const;
+
+    int getNumEntries() const;
+
+    /* Every stored file, searchable by its production fields. */
+    const MetadataSearchIndex& getSearchIndex() const noexcept     { return searchIndex; }
+
+private:
+    //==============================================================================
+    struct Entry
+    {
+        Stamp stamp;
+        juce::MemoryBlock data;             // WavMetadata::writeTo() output, decoded on lookup.
+    };
+
+    juce::File getSearchIndexFile() const;
+    juce::File getJournalFile() const;
+
+    /* Applies the journal to entries loaded from an index file with the
+       given generation. Returns false if there's no journal for it, or it
+       ends in a broken record. */
+    bool replayJournal(juce::int64 indexGeneration, std::unordered_map<juce::String, Entry>& loadedEntries,
+                       int& numReplayed);
+
+    juce::File indexFile;
+    mutable juce::CriticalSection lock;
+    std::unordered_map<juce::String, Entry> entries;
+    bool needsSaving = false;
+
+    // Paths stored or removed since they last went into the index file or journal.
+    std::unordered_set<juce::String> unjournalled;
+
+    // Tells this index file apart from earlier ones, so a journal left over
+    // from one of those is never replayed onto it. Zero if there isn't one.
+    juce::int64 generation = 0;
+    bool journalMatches = false;
+
+    MetadataSearchIndex searchIndex;    // Has its own lock.
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MetadataCache)
+};
@@ -0,0 +1,268 @@
+/*
+  ==============================================================================
+
+    MetadataExporter.cpp
+
+  ==============================================================================
+*/
+
+#include "MetadataExporter.h"
+
+namespace
+{
+    //==============================================================================
+    /* Calls the function with the name and value of every column, in order.
+       Numeric values are empty when the chunk they come from wasn't found. */
+    template <typename Callback>
+    void forEachField(const juce::File& file, const WavMetadata& metadata, Callback&& callback)
+    {
+        const auto& format = metadata.format;
+        const auto& bext = metadata.bext;
+        const auto& ixml = metadata.ixml;
+
+        auto number = [](bool found, juce::int64 value) { return found ? juce::String(value) : juce::String(); };
+        auto loudness = [](float value) { return std::isnan(value) ? juce::String() : juce::String(value, 2); };
+
+        auto infoField = [&metadata](const char* id)
+            {
+                for (const auto& field : metadata.info.fields)
+                    if (field.id == id)
+                        return field.value;
+
+                return juce::String();
+            };
+
+        callback("path",                    file.getFullPathName(), false);
+        callback("status",                  juce::String(metadata.status.wasOk() ? "ok" : "error"), false);
+        callback("error",                   metadata.status.getErrorMessage(), false);
+        callback("audio_format",            number(format.found, format.audioFormat), true);
+        callback("sample_rate",             number(format.found, format.sampleRate), true);
+        callback("channels",                number(format.found, format.numChannels), true);
+        callback("bits_per_sample",         number(format.found, format.bitsPerSample), true);
+        callback("description",             bext.description, false);
+        callback("originator",              bext.originator, false);
+        callback("originator_reference",    bext.originatorReference, false);
+        callback("origination_date",        bext.originationDate, false);
+        callback("origination_time",        bext.originationTime, false);
+        callback("time_reference",          number(bext.found, bext.timeReference), true);
+        callback("bext_version",            number(bext.found, bext.version), true);
+        callback("umid",                    bext.getUmidAsHex(), false);
+        callback("loudness_value",          loudness(bext.loudnessValue), true);
+        callback("loudness_range",          loudness(bext.loudnessRange), true);
+        callback("max_true_peak_level",     loudness(bext.maxTruePeakLevel), true);
+        callback("max_momentary_loudness",  loudness(bext.maxMomentaryLoudness), true);
+        callback("max_short_term_loudness", loudness(bext.maxShortTermLoudness), true);
+        callback("project",                 ixml.project, false);
+        callback("scene",                   ixml.scene, false);
+        callback("take",                    ixml.take, false);
+        callback("tape",                    ixml.tape, false);
+        callback("has_adm",                 juce::String(metadata.adm.found ? 1 : 0), true);
+        callback("chna_tracks",             number(metadata.chna.found, metadata.chna.tracks.size()), true);
+        callback("has_xmp",                 juce::String(metadata.xmp.found ? 1 : 0), true);
+        callback("info_title",              infoField("INAM"), false);
+        callback("info_comment",            infoField("ICMT"), false);
+    }
+
+    /* Writes a CSV field, quoted if it contains anything that would break the row up. */
+    void writeCsvField(juce::OutputStream& out, const juce::String& value)
+    {
+        auto* text = value.toRawUTF8();
+
+        if (std::strpbrk(text, ",\"\r\n") == nullptr)
+        {
+            out.write(text, std::strlen(text));
+            return;
+        }
+
+        out.writeByte('"');
+
+        for (auto* p = text; *p != 0; ++p)
+        {
+            if (*p == '"')
+                out.writeByte('"');
+
+            out.writeByte(*p);
+        }
+
+        out.writeByte('"');
+    }
+
+    /* Writes a quoted JSON string. The text is already UTF-8, so only quotes,
+       backslashes and control characters need escaping. */
+    void writeJsonString(juce::OutputStream& out, const juce::String& value)
+    {
+        out.writeByte('"');
+
+        for (auto* p = value.toRawUTF8(); *p != 0; ++p)
+        {
+            auto c = (unsigned char) *p;
+
+            switch (c)
+            {
+                case '"':   out.write("\\\"", 2); break;
+                case '\\':  out.write("\\\\", 2); break;
+                case '\n':  out.write("\\n", 2); break;
+                case '\r':  out.write("\\r", 2); break;
+                case '\t':  out.write("\\t", 2); break;
+
+                default:
+                    if (c < 0x20)
+                        out << "\\u00" << juce::String::toHexString((int) c).paddedLeft('0', 2);
+                    else
+                        out.writeByte((char) c);
+
+                    break;
+            }
+        }
+
+        out.writeByte('"');
+    }
+}
+
+//==============================================================================
+bool MetadataExporter::getFormatFromName(const juce::String& name, Format& result)
+{
+    if (name.equalsIgnoreCase("csv"))
+    {
+        result = Format::csv;
+        return true;
+    }
+
+    if (name.equalsIgnoreCase("jsonl") || name.equalsIgnoreCase("json"))
+    {
+        result = Format::jsonLines;
+        return true;
+    }
+
+    return false;
+}
+
+MetadataExporter::Format MetadataExporter::getFormatForFile(const juce::File& file)
+{
+    return file.hasFileExtension("csv") ? Format::csv : Format::jsonLines;
+}
+
+//==============================================================================
+MetadataExporter::MetadataExporter(const juce::File& targetFile, Format formatToWrite)
+    : out(targetFile), format(formatToWrite)
+{
+    if (! out.openedOk())
+        return;
+
+    // FileOutputStream appends, but an export should replace whatever was there.
+    out.setPosition(0);
+    out.truncate();
+
+    if (format == Format::csv)
+    {
+        bool isFirst = true;
+
+        forEachField({}, {}, [&](const char* name, const juce::String&, bool)
+            {
+                if (! std::exchange(isFirst, false))
+                    out.writeByte(',');
+
+                out << name;
+            });
+
+        out << ",tracks\n";
+    }
+}
+
+MetadataExporter::~MetadataExporter()
+{
+    finish();
+}
+
+void MetadataExporter::write(const juce::File& file, const WavMetadata& metadata)
+{
+    if (! out.openedOk())
+        return;
+
+    const juce::ScopedLock sl(lock);
+
+    if (format == Format::csv)
+        writeCsv(file, metadata);
+    else
+        writeJson(file, metadata);
+
+    ++numRecords;
+}
+
+bool MetadataExporter::finish()
+{
+    const juce::ScopedLock sl(lock);
+
+    if (! out.openedOk())
+        return false;
+
+    out.flush();
+    return out.getStatus().wasOk();
+}
+
+//==============================================================================
+void MetadataExporter::writeCsv(const juce::File& file, const WavMetadata& metadata)
+{
+    bool isFirst = true;
+
+    forEachField(file, metadata, [&](const char*, const juce::String& value, bool)
+        {
+            if (! std::exchange(isFirst, false))
+                out.writeByte(',');
+
+            writeCsvField(out, value);
+        });
+
+    // A spreadsheet has no room for nested records, so the track names share a column.
+    juce::StringArray trackNames;
+
+    for (const auto& track : metadata.ixml.tracks)
+        trackNames.add(track.name);
+
+    out.writeByte(',');
+    writeCsvField(out, trackNames.joinIntoString("; "));
+    out.writeByte('\n');
+}
+
+void MetadataExporter::writeJson(const juce::File& file, const WavMetadata& metadata)
+{
+    bool isFirst = true;
+    out.writeByte('{');
+
+    forEachField(file, metadata, [&](const char* name, const juce::String& value, bool isNumber)
+        {
+            if (! std::exchange(isFirst, false))
+                out.writeByte(',');
+
+            out << '"' << name << "\":";
+
+            if (! isNumber)
+                writeJsonString(out, value);
+            else if (value.isEmpty())
+                out << "null";
+            else
+                out << value;
+        });
+
+    out << ",\"tracks\":[";
+
+    for (int i = 0; i < metadata.ixml.tracks.size(); ++i)
+    {
+        const auto& track = metadata.ixml.tracks.getReference(i);
+
+        if (i > 0)
+            out.writeByte(',');
+
+        out << "{\"channel_index\":";
+        writeJsonString(out, track.channelIndex);
+        out << ",\"interleave_index\":";
+        writeJsonString(out, track.interleaveIndex);
+        out << ",\"name\":";
+        writeJsonString(out, track.name);
+        out << ",\"function\":";
+        writeJsonString(out, track.function);
+        out.writeByte('}');
+    }
+
+    out << "]}\n";
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    MetadataExporter.h
+
+    Writes parsed metadata as structured records, one CSV row or JSON Lines
+    object per file, straight to a file stream as each result arrives. Nothing
+    is kept between records, so memory use doesn't depend on how many files
+    are exported. Only depends on juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WavMetadata.h"
+
+//==============================================================================
+class MetadataExporter
+{
+public:
+    //==============================================================================
+    enum class Format
+    {
+        csv,
+        jsonLines
+    };
+
+    /* Picks the format from a name such as "csv" or "jsonl", returning false
+       if it isn't one we know. */
+    static bool getFormatFromName(const juce::String& name, Format& result);
+
+    /* CSV for a ".csv" file, JSON Lines for anything else. */
+    static Format getFormatForFile(const juce::File& file);
+
+    //==============================================================================
+    /* Creates (or truncates) the target file and, for CSV, writes the header row. */
+    MetadataExporter(const juce::File& targetFile, Format format);
+
+    /* Flushes whatever is still buffered. */
+    ~MetadataExporter();
+
+    bool openedOk() const noexcept          { return out.openedOk(); }
+
+    /* Writes one record. Thread-safe. */
+    void write(const juce::File& file, const WavMetadata& metadata);
+
+    int getNumRecords() const noexcept      { return numRecords; }
+
+    /* Flushes the stream and returns false if anything failed to be written. */
+    bool finish();
+
+private:
+    //==============================================================================
+    void writeCsv(const juce::File& file, const WavMetadata& metadata);
+    void writeJson(const juce::File& file, const WavMetadata& metadata);
+
+    juce::FileOutputStream out;
+    Format format;
+    juce::CriticalSection lock;
+    std::atomic<int> numRecords { 0 };
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MetadataExporter)
+};
@@ -0,0 +1,438 @@
+/*
+  ==============================================================================
+
+    MetadataSearchIndex.cpp
+
+  ==============================================================================
+*/
+
+#include "MetadataSearchIndex.h"
+#include <algorithm>
+
+namespace
+{
+    // Bump the version whenever the layout written by save() changes.
+    constexpr int indexMagic = 0x49535869;     // "iXSI"
+    constexpr int indexVersion = 1;
+
+    constexpr juce::uint32 allFields = (1u << MetadataSearchIndex::numFields) - 1;
+
+    /* Calls the function with each lower-cased run of letters and digits in the text. */
+    template <typename Callback>
+    void forEachWord(const juce::String& text, Callback&& callback)
+    {
+        juce::String word;
+
+        for (auto p = text.getCharPointer(); ! p.isEmpty(); ++p)
+        {
+            auto c = *p;
+
+            if (juce::CharacterFunctions::isLetterOrDigit(c))
+            {
+                word += juce::CharacterFunctions::toLowerCase(c);
+            }
+            else if (word.isNotEmpty())
+            {
+                callback(word);
+                word.clear();
+            }
+        }
+
+        if (word.isNotEmpty())
+            callback(word);
+    }
+
+    std::vector<int> intersect(const std::vector<int>& a, const std::vector<int>& b)
+    {
+        std::vector<int> result;
+        std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+        return result;
+    }
+}
+
+//==============================================================================
+const char* MetadataSearchIndex::getFieldName(Field field) noexcept
+{
+    switch (field)
+    {
+        case project:               return "project";
+        case scene:                 return "scene";
+        case take:                  return "take";
+        case tape:                  return "tape";
+        case originator:            return "originator";
+        case originatorReference:   return "originatorref";
+        case description:           return "description";
+        case timeReference:         return "timeref";
+        case fileName:              return "file";
+        case numFields:             break;
+    }
+
+    return "";
+}
+
+//==============================================================================
+void MetadataSearchIndex::add(const juce::File& file, const WavMetadata& metadata)
+{
+    Document document;
+    document.path = file.getFullPathName();
+    document.values[project] = metadata.ixml.project;
+    document.values[scene] = metadata.ixml.scene;
+    document.values[take] = metadata.ixml.take;
+    document.values[tape] = metadata.ixml.tape;
+    document.values[originator] = metadata.bext.originator;
+    document.values[originatorReference] = metadata.bext.originatorReference;
+    document.values[description] = metadata.bext.description;
+    document.values[fileName] = file.getFileName();
+
+    if (metadata.bext.found)
+        document.values[timeReference] = juce::String(metadata.bext.timeReference);
+
+    const juce::ScopedLock sl(lock);
+    auto existing = documentsByPath.find(document.path);
+
+    if (existing != documentsByPath.end())
+    {
+        // Keep the same slot, so the file keeps its place in the results.
+        removeTerms(existing->second);
+        documents[(size_t) existing->second] = std::move(document);
+        addTerms(existing->second);
+        return;
+    }
+
+    auto index = (int) documents.size();
+    documentsByPath[document.path] = index;
+    documents.push_back(std::move(document));
+    addTerms(index);
+}
+
+void MetadataSearchIndex::remove(const juce::File& file)
+{
+    const juce::ScopedLock sl(lock);
+    auto found = documentsByPath.find(file.getFullPathName());
+
+    if (found == documentsByPath.end())
+        return;
+
+    auto index = found->second;
+    auto last = (int) documents.size() - 1;
+
+    removeTerms(index);
+    documentsByPath.erase(found);
+
+    // Move the last document into the gap, so only its postings need renumbering.
+    if (index != last)
+    {
+        removeTerms(last);
+        documents[(size_t) index] = std::move(documents[(size_t) last]);
+        documentsByPath[documents[(size_t) index].path] = index;
+        addTerms(index);
+    }
+
+    documents.pop_back();
+}
+
+void MetadataSearchIndex::clear()
+{
+    const juce::ScopedLock sl(lock);
+    documents.clear();
+    documentsByPath.clear();
+    postings.clear();
+}
+
+int MetadataSearchIndex::getNumFiles() const
+{
+    const juce::ScopedLock sl(lock);
+    return (int) documents.size();
+}
+
+//==============================================================================
+juce::Array<juce::File> MetadataSearchIndex::search(const juce::String& query, int maxResults) const
+{
+    struct Term
+    {
+        juce::String word;
+        juce::uint32 fieldMask;
+        bool isPrefix;
+    };
+
+    std::vector<Term> terms;
+
+    for (auto token : juce::StringArray::fromTokens(query, false))
+    {
+        auto fieldMask = allFields;
+        auto colon = token.indexOfChar(':');
+
+        if (colon > 0)
+        {
+            auto name = token.substring(0, colon);
+
+            for (int field = 0; field < numFields; ++field)
+            {
+                if (name.equalsIgnoreCase(getFieldName((Field) field)))
+                {
+                    fieldMask = 1u << field;
+                    token = token.substring(colon + 1);
+                    break;
+                }
+            }
+        }
+
+        auto isPrefix = token.endsWithChar('*');
+        auto firstTerm = terms.size();
+
+        // A term like "12-A" holds several words, all of which have to match.
+        forEachWord(token, [&](const juce::String& word) { terms.push_back({ word, fieldMask, false }); });
+
+        if (isPrefix && terms.size() > firstTerm)
+            terms.back().isPrefix = true;
+    }
+
+    juce::Array<juce::File> results;
+
+    if (terms.empty())
+        return results;
+
+    const juce::ScopedLock sl(lock);
+
+    std::vector<std::vector<int>> matches;
+
+    for (const auto& term : terms)
+    {
+        matches.push_back(findDocuments(term.word, term.fieldMask, term.isPrefix));
+
+        if (matches.back().empty())
+            return results;
+    }
+
+    // Intersecting the shortest lists first keeps every step as small as possible.
+    std::sort(matches.begin(), matches.end(),
+              [](const std::vector<int>& a, const std::vector<int>& b) { return a.size() < b.size(); });
+
+    auto found = std::move(matches.front());
+
+    for (size_t i = 1; i < matches.size() && ! found.empty(); ++i)
+        found = intersect(found, matches[i]);
+
+    for (auto document : found)
+    {
+        if (results.size() >= maxResults)
+            break;
+
+        results.add(juce::File(documents[(size_t) document].path));
+    }
+
+    return results;
+}
+
+std::vector<int> MetadataSearchIndex::findDocuments(const juce::String& word, juce::uint32 fieldMask, bool isPrefix) const
+{
+    std::vector<int> result;
+
+    auto collect = [&](const PostingList& list)
+        {
+            for (const auto& posting : list)
+                if ((posting.fields & fieldMask) != 0)
+                    result.push_back(posting.document);
+        };
+
+    if (! isPrefix)
+    {
+        auto found = postings.find(word);
+
+        if (found != postings.end())
+            collect(found->second);
+
+        return result;
+    }
+
+    for (auto it = postings.lower_bound(word); it != postings.end() && it->first.startsWith(word); ++it)
+        collect(it->second);
+
+    // Several words can share a document, so merge what the range produced.
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+//==============================================================================
+void MetadataSearchIndex::addTerms(int index)
+{
+    const auto& document = documents[(size_t) index];
+    std::unordered_map<juce::String, juce::uint32> words;
+
+    for (int field = 0; field < numFields; ++field)
+        forEachWord(document.values[field], [&](const juce::String& word) { words[word] |= 1u << field; });
+
+    for (const auto& [word, fields] : words)
+    {
+        auto& list = postings[word];
+        auto position = std::lower_bound(list.begin(), list.end(), index,
+                                         [](const Posting& posting, int target) { return posting.document < target; });
+        list.insert(position, { index, fields });
+    }
+}
+
+void MetadataSearchIndex::removeTerms(int index)
+{
+    const auto& document = documents[(size_t) index];
+
+    for (const auto& value : document.values)
+    {
+        forEachWord(value, [&](const juce::String& word)
+            {
+                auto found = postings.find(word);
+
+                if (found == postings.end())
+                    return;
+
+                auto& list = found->second;
+                auto position = std::lower_bound(list.begin(), list.end(), index,
+                                                 [](const Posting& posting, int target) { return posting.document < target; });
+
+                if (position != list.end() && position->document == index)
+                    list.erase(position);
+
+                if (list.empty())
+                    postings.erase(found);
+            });
+    }
+}
+
+//==============================================================================
+bool MetadataSearchIndex::load(const juce::File& file)
+{
+    clear();
+
+    juce::FileInputStream fileStream(file);
+
+    if (! fileStream.openedOk())
+        return false;
+
+    juce::GZIPDecompressorInputStream in(fileStream);
+
+    if (in.readInt() != indexMagic || in.readInt() != indexVersion)
+        return false;
+
+    std::vector<Document> loadedDocuments;
+    std::unordered_map<juce::String, int> loadedPaths;
+    std::map<juce::String, PostingList> loadedPostings;
+
+    auto numDocuments = in.readInt();
+
+    if (numDocuments < 0)
+        return false;
+
+    loadedDocuments.resize((size_t) numDocuments);
+
+    for (int i = 0; i < numDocuments; ++i)
+    {
+        auto& document = loadedDocuments[(size_t) i];
+        document.path = in.readString();
+
+        for (auto& value : document.values)
+            value = in.readString();
+
+        if (document.path.isEmpty() || ! loadedPaths.emplace(document.path, i).second)
+            return false;
+    }
+
+    auto numWords = in.readInt();
+
+    if (numWords < 0)
+        return false;
+
+    for (int i = 0; i < numWords; ++i)
+    {
+        auto word = in.readString();
+        auto numPostings = in.readCompressedInt();
+
+        // Words were written in order, so each one goes at the end of the map.
+        if (word.isEmpty() || numPostings <= 0 || numPostings > numDocuments
+             || (! loadedPostings.empty() && ! (loadedPostings.rbegin()->first < word)))
+            return false;
+
+        PostingList list;
+        list.reserve((size_t) numPostings);
+        int document = -1;
+
+        for (int j = 0; j < numPostings; ++j)
+        {
+            // Document numbers are stored as gaps from the previous one.
+            auto gap = in.readCompressedInt();
+            auto fields = (juce::uint32) in.readCompressedInt();
+
+            // Checked before it's added, so a corrupt gap can't overflow.
+            if (gap <= 0 || gap >= numDocuments - document || fields == 0 || (fields & ~allFields) != 0)
+                return false;
+
+            document += gap;
+
+            list.push_back({ document, fields });
+        }
+
+        loadedPostings.emplace_hint(loadedPostings.end(), word, std::move(list));
+    }
+
+    if (in.readInt() != indexMagic)
+        return false;
+
+    const juce::ScopedLock sl(lock);
+    documents = std::move(loadedDocuments);
+    documentsByPath = std::move(loadedPaths);
+    postings = std::move(loadedPostings);
+    return true;
+}
+
+bool MetadataSearchIndex::save(const juce::File& file) const
+{
+    if (! file.getParentDirectory().createDirectory())
+        return false;
+
+    const juce::ScopedLock sl(lock);
+
+    juce::TemporaryFile temp(file);
+
+    {
+        juce::FileOutputStream fileStream(temp.getFile());
+
+        if (! fileStream.openedOk())
+            return false;
+
+        juce::GZIPCompressorOutputStream out(fileStream, 1);
+
+        out.writeInt(indexMagic);
+        out.writeInt(indexVersion);
+        out.writeInt((int) documents.size());
+
+        for (const auto& document : documents)
+        {
+            out.writeString(document.path);
+
+            for (const auto& value : document.values)
+                out.writeString(value);
+        }
+
+        out.writeInt((int) postings.size());
+
+        for (const auto& [word, list] : postings)
+        {
+            out.writeString(word);
+            out.writeCompressedInt((int) list.size());
+
+            int previous = -1;
+
+            for (const auto& posting : list)
+            {
+                out.writeCompressedInt(posting.document - previous);
+                out.writeCompressedInt((int) posting.fields);
+                previous = posting.document;
+            }
+        }
+
+        // An end marker, so a truncated file isn't mistaken for a smaller index.
+        out.writeInt(indexMagic);
+        out.flush();
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    MetadataSearchIndex.h
+
+    An inverted index over the production fields of parsed files (iXML
+    PROJECT/SCENE/TAKE/TAPE, the bext originator fields and time reference),
+    so takes can be found without reading any WAVs. Only depends on
+    juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WavMetadata.h"
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+//==============================================================================
+class MetadataSearchIndex
+{
+public:
+    //==============================================================================
+    enum Field
+    {
+        project,
+        scene,
+        take,
+        tape,
+        originator,
+        originatorReference,
+        description,
+        timeReference,
+        fileName,
+        numFields
+    };
+
+    /* The name used to restrict a query term to a field, e.g. "scene:12a". */
+    static const char* getFieldName(Field field) noexcept;
+
+    //==============================================================================
+    MetadataSearchIndex() = default;
+
+    /* Adds a file, or replaces what was indexed for it before. Thread-safe. */
+    void add(const juce::File& file, const WavMetadata& metadata);
+
+    /* Drops a file from the index, if it's there. Thread-safe. */
+    void remove(const juce::File& file);
+
+    void clear();
+
+    /* Returns the files matching every term of the query, in the order they
+       were first indexed, up to maxResults. Removing a file moves the most
+       recently indexed one into its place.
+
+       Terms are separated by spaces and matched case-insensitively against
+       whole words of any field. "field:word" only matches that field, and a
+       trailing '*' makes a term match any word starting with it. Thread-safe. */
+    juce::Array<juce::File> search(const juce::String& query, int maxResults) const;
+
+    int getNumFiles() const;
+
+    //==============================================================================
+    /* Replaces the contents with those of the file. A missing, corrupt or
+       out-of-date file leaves the index empty and returns false. */
+    bool load(const juce::File& file);
+
+    bool save(const juce::File& file) const;
+
+private:
+    //==============================================================================
+    struct Posting
+    {
+        int document;
+        juce::uint32 fields;                // One bit per Field the word appears in.
+    };
+
+    struct Document
+    {
+        juce::String path;
+        juce::String values[numFields];
+    };
+
+    using PostingList = std::vector<Posting>;
+
+    void addTerms(int document);
+    void removeTerms(int document);
+    std::vector<int> findDocuments(const juce::String& word, juce::uint32 fieldMask, bool isPrefix) const;
+
+    mutable juce::CriticalSection lock;
+    std::vector<Document> documents;
+    std::unordered_map<juce::String, int> documentsByPath;
+
+    // Ordered, so prefix queries are one contiguous range of words.
+    std::map<juce::String, PostingList> postings;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MetadataSearchIndex)
+};
@@ -0,0 +1,264 @@
+/*
+  ==============================================================================
+
+    MetadataView.cpp
+
+  ==============================================================================
+*/
+
+#include "MetadataView.h"
+
+//==============================================================================
+void MetadataDocument::addSection(const juce::String& title, const juce::String& body)
+{
+    auto titleText = title.toRawUTF8();
+    addRow(titleText, (int) std::strlen(titleText), 0);
+
+    auto* p = body.toRawUTF8();
+    int previousDepth = 0;
+
+    while (*p != 0)
+    {
+        auto* lineEnd = std::strchr(p, '\n');
+
+        if (lineEnd == nullptr)
+            lineEnd = p + std::strlen(p);
+
+        auto* textStart = p;
+
+        while (textStart < lineEnd && *textStart == ' ')
+            ++textStart;
+
+        auto* textEnd = lineEnd;
+
+        while (textEnd > textStart && (textEnd[-1] == '\r' || textEnd[-1] == ' ' || textEnd[-1] == '\t'))
+            --textEnd;
+
+        if (textEnd > textStart)
+        {
+            // A line can't be nested more than one level deeper than the row
+            // before it, otherwise it would have no parent to be shown under.
+            auto depth = juce::jmin(1 + (int) (textStart - p) / 2, previousDepth + 1);
+            addRow(textStart, (int) (textEnd - textStart), depth);
+            previousDepth = depth;
+        }
+
+        p = *lineEnd != 0 ? lineEnd + 1 : lineEnd;
+    }
+}
+
+void MetadataDocument::addRow(const char* text, int length, int depth)
+{
+    Row row;
+    row.start = (int) buffer.getDataSize();
+    row.length = length;
+    row.depth = depth;
+    row.isClosingTag = length > 1 && text[0] == '<' && text[1] == '/';
+
+    buffer.write(text, (size_t) length);
+    rows.add(row);
+}
+
+juce::String MetadataDocument::getRowText(int row) const
+{
+    const auto& r = rows.getReference(row);
+    return juce::String::fromUTF8(static_cast<const char*>(buffer.getData()) + r.start, r.length);
+}
+
+bool MetadataDocument::hasChildren(int row) const noexcept
+{
+    if (row < 0)
+        return ! rows.isEmpty();
+
+    return row + 1 < rows.size() && rows.getReference(row + 1).depth > rows.getReference(row).depth;
+}
+
+void MetadataDocument::forEachChild(int row, const std::function<void(int)>& callback) const
+{
+    auto parentDepth = row < 0 ? -1 : rows.getReference(row).depth;
+
+    for (int i = row + 1; i < rows.size(); ++i)
+    {
+        const auto& child = rows.getReference(i);
+
+        if (child.depth <= parentDepth)
+            break;
+
+        if (child.depth == parentDepth + 1 && ! child.isClosingTag)
+            callback(i);
+    }
+}
+
+juce::String MetadataDocument::getAllText() const
+{
+    juce::MemoryOutputStream text;
+
+    for (int i = 0; i < rows.size(); ++i)
+    {
+        text.writeRepeatedByte(' ', (size_t) getDepth(i) * 2);
+        text << getRowText(i) << "\n";
+    }
+
+    return text.toUTF8();
+}
+
+//==============================================================================
+/* One row of the document. Children are only created when the item is opened. */
+class MetadataView::RowItem : public juce::TreeViewItem
+{
+public:
+    RowItem(std::shared_ptr<const MetadataDocument> documentToShow, int rowIndex, int indexInParent)
+        : document(std::move(documentToShow)), row(rowIndex), ordinal(indexInParent)
+    {
+    }
+
+    bool mightContainSubItems() override
+    {
+        return document->hasChildren(row);
+    }
+
+    void itemOpennessChanged(bool isNowOpen) override
+    {
+        if (isNowOpen && getNumSubItems() == 0)
+            document->forEachChild(row, [this](int child) { addSubItem(new RowItem(document, child, getNumSubItems())); });
+    }
+
+    void paintItem(juce::Graphics& g, int width, int height) override
+    {
+        if (isSelected())
+            g.fillAll(juce::Colours::lightgoldenrodyellow.withAlpha(0.2f));
+
+        // Section titles stand out from the fields below them.
+        auto isTitle = row >= 0 && document->getDepth(row) == 0;
+
+        g.setColour(juce::Colours::lightgoldenrodyellow);
+        g.setFont(juce::Font(juce::FontOptions(juce::Font::getDefaultMonospacedFontName(), 14.0f,
+                                               isTitle ? juce::Font::bold : juce::Font::plain)));
+        g.drawText(document->getRowText(row), 4, 0, width - 4, height, juce::Justification::centredLeft, true);
+    }
+
+    juce::String getUniqueName() const override
+    {
+        // Named by position and text rather than row number, so when a document
+        // is replaced by an updated one, the openness of everything before the
+        // change still lines up with the new rows.
+        return juce::String(ordinal) + ":" + getText();
+    }
+
+    juce::String getText() const
+    {
+        return row >= 0 ? document->getRowText(row) : juce::String();
+    }
+
+private:
+    std::shared_ptr<const MetadataDocument> document;
+    int row, ordinal;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RowItem)
+};
+
+//==============================================================================
+MetadataView::MetadataView()
+{
+    addAndMakeVisible(tree);
+    tree.setRootItemVisible(false);
+    tree.setMultiSelectEnabled(true);
+    tree.setColour(juce::TreeView::backgroundColourId, juce::Colours::darkgrey.darker());
+    tree.setColour(juce::TreeView::linesColourId, juce::Colours::lightgoldenrodyellow.withAlpha(0.3f));
+}
+
+MetadataView::~MetadataView()
+{
+    // The tree doesn't own its root item, so detach it before it's deleted.
+    tree.setRootItem(nullptr);
+}
+
+void MetadataView::setDocument(std::shared_ptr<const MetadataDocument> newDocument)
+{
+    tree.setRootItem(nullptr);
+
+    document = std::move(newDocument);
+    rootItem = std::make_unique<RowItem>(document, -1, 0);
+    tree.setRootItem(rootItem.get());
+
+    // The root is hidden, so open it to show the sections, then open the
+    // sections and the top-level element inside each one.
+    rootItem->setOpen(true);
+
+    for (int i = 0; i < rootItem->getNumSubItems(); ++i)
+    {
+        auto* section = rootItem->getSubItem(i);
+        section->setOpen(true);
+
+        for (int j = 0; j < section->getNumSubItems(); ++j)
+            if (section->getSubItem(j)->mightContainSubItems())
+                section->getSubItem(j)->setOpen(true);
+    }
+}
+
+void MetadataView::updateDocument(std::shared_ptr<const MetadataDocument> newDocument)
+{
+    if (document == nullptr || rootItem == nullptr)
+    {
+        setDocument(std::move(newDocument));
+        return;
+    }
+
+    auto openness = tree.getOpennessState(true);
+
+    tree.setRootItem(nullptr);
+    document = std::move(newDocument);
+    rootItem = std::make_unique<RowItem>(document, -1, 0);
+    tree.setRootItem(rootItem.get());
+    rootItem->setOpen(true);
+
+    // Items are created as the state opens them, so this stays as cheap as
+    // the part of the tree the user actually had open.
+    if (openness != nullptr)
+        tree.restoreOpennessState(*openness, true);
+}
+
+void MetadataView::setMessage(const juce::String& message)
+{
+    auto messageDocument = std::make_shared<MetadataDocument>();
+    messageDocument->addSection(message, {});
+    setDocument(std::move(messageDocument));
+}
+
+//==============================================================================
+void MetadataView::resized()
+{
+    tree.setBounds(getLocalBounds());
+}
+
+bool MetadataView::keyPressed(const juce::KeyPress& key)
+{
+    // The tree uses the arrow keys itself and passes everything else up to us.
+    if (key == juce::KeyPress('c', juce::ModifierKeys::commandModifier, 0))
+    {
+        copySelectionToClipboard();
+        return true;
+    }
+
+    return false;
+}
+
+void MetadataView::copySelectionToClipboard()
+{
+    if (document == nullptr)
+        return;
+
+    if (tree.getNumSelectedItems() == 0)
+    {
+        juce::SystemClipboard::copyTextToClipboard(document->getAllText());
+        return;
+    }
+
+    juce::StringArray lines;
+
+    for (int i = 0; i < tree.getNumSelectedItems(); ++i)
+        if (auto* item = dynamic_cast<RowItem*>(tree.getSelectedItem(i)))
+            lines.add(item->getText());
+
+    juce::SystemClipboard::copyTextToClipboard(lines.joinIntoString("\n"));
+}
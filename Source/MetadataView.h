@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    MetadataView.h
+
+    A virtualized viewer for parsed metadata. The text is kept in one flat
+    MetadataDocument, and the TreeView only creates items when their parent
+    is opened and only paints the rows that are on screen, so the cost of
+    scrolling and resizing doesn't depend on the size of the payload.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    An outline of text rows stored in a single buffer. Each section has a title
+    row at depth 0, and every line of its body becomes a row whose depth comes
+    from its indentation. It can be built on any thread and is immutable once
+    it has been handed to a MetadataView.
+*/
+class MetadataDocument
+{
+public:
+    //==============================================================================
+    MetadataDocument() = default;
+
+    /* Appends a title row followed by one row per line of the body. */
+    void addSection(const juce::String& title, const juce::String& body);
+
+    //==============================================================================
+    int getNumRows() const noexcept                  { return rows.size(); }
+    int getDepth(int row) const noexcept             { return rows.getReference(row).depth; }
+    juce::String getRowText(int row) const;
+
+    /* True if the rows directly after this one are nested inside it. */
+    bool hasChildren(int row) const noexcept;
+
+    /* Calls the function with the index of every row one level below the given
+       row (or every depth-0 row if row is -1). Closing XML tags are skipped,
+       since the row of the opening tag already stands for the element. */
+    void forEachChild(int row, const std::function<void(int)>& callback) const;
+
+    /* The whole document as plain text, indented by depth. */
+    juce::String getAllText() const;
+
+private:
+    //==============================================================================
+    struct Row
+    {
+        int start = 0;          // Byte offset of the (unindented) text in the buffer.
+        int length = 0;         // Length of the text in bytes.
+        int depth = 0;
+        bool isClosingTag = false;
+    };
+
+    void addRow(const char* text, int length, int depth);
+
+    juce::MemoryOutputStream buffer;
+    juce::Array<Row> rows;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MetadataDocument)
+};
+
+//==============================================================================
+class MetadataView : public juce::Component
+{
+public:
+    //==============================================================================
+    MetadataView();
+    ~MetadataView() override;
+
+    /* Replaces the shown document. Sections, and the element directly inside
+       each one, start out open; everything deeper is created when opened. */
+    void setDocument(std::shared_ptr<const MetadataDocument> newDocument);
+
+    /* Replaces the shown document with a newer version of it, keeping the
+       open items, selection and scroll position wherever the rows still match. */
+    void updateDocument(std::shared_ptr<const MetadataDocument> newDocument);
+
+    /* Shows a single line of text, e.g. a progress or error message. */
+    void setMessage(const juce::String& message);
+
+    //==============================================================================
+    void resized() override;
+    bool keyPressed(const juce::KeyPress& key) override;
+
+private:
+    //==============================================================================
+    class RowItem;
+
+    void copySelectionToClipboard();
+
+    juce::TreeView tree;
+    std::shared_ptr<const MetadataDocument> document;
+    std::unique_ptr<juce::TreeViewItem> rootItem;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MetadataView)
+};
@@ -0,0 +1,237 @@
+/*
+  ==============================================================================
+
+    MetricsReporter.cpp
+
+  ==============================================================================
+*/
+
+#include "MetricsReporter.h"
+
+namespace
+{
+    // How long the server waits on the listener at a time, so it notices
+    // when to stop.
+    constexpr int listenerPollMilliseconds = 250;
+
+    // How long a client gets to send its request, in all. Requests are
+    // served in turn, so this is also the most one client can hold up the next.
+    constexpr int requestDeadlineMilliseconds = 1000;
+
+    // Enough for a request line and a scraper's headers.
+    constexpr int maxRequestSize = 8192;
+}
+
+//==============================================================================
+/* Answers "GET /metrics" on its own thread. */
+class MetricsReporter::Server : private juce::Thread
+{
+public:
+    Server(const ScanMetrics& metricsToServe, const Options& options)
+        : juce::Thread("Metrics server"),
+          metrics(metricsToServe),
+          port(options.port),
+          bindAddress(options.bindAddress)
+    {
+    }
+
+    ~Server() override
+    {
+        stop();
+    }
+
+    bool start()
+    {
+        if (! listener.createListener(port, bindAddress))
+            return false;
+
+        startThread();
+        return true;
+    }
+
+    void stop()
+    {
+        stopThread(2 * juce::jmax(listenerPollMilliseconds, requestDeadlineMilliseconds));
+        listener.close();
+    }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            if (listener.waitUntilReady(true, listenerPollMilliseconds) != 1)
+                continue;
+
+            std::unique_ptr<juce::StreamingSocket> connection(listener.waitForNextConnection());
+
+            if (connection != nullptr)
+                serve(*connection);
+        }
+    }
+
+    void serve(juce::StreamingSocket& connection);
+
+    const ScanMetrics& metrics;
+    int port;
+    juce::String bindAddress;
+    juce::StreamingSocket listener;
+
+    JUCE_DECLARE_NON_COPYABLE(Server)
+};
+
+void MetricsReporter::Server::serve(juce::StreamingSocket& connection)
+{
+    // Read up to the end of the request line; the headers don't matter. A
+    // client gets one deadline for the lot, however it trickles its bytes in.
+    auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32) requestDeadlineMilliseconds;
+    juce::MemoryBlock request;
+    char buffer[1024];
+
+    while (request.getSize() < (size_t) maxRequestSize && ! request.toString().containsChar('\n'))
+    {
+        auto now = juce::Time::getMillisecondCounter();
+
+        if (now >= deadline || connection.waitUntilReady(true, (int) (deadline - now)) != 1)
+            break;
+
+        auto numRead = connection.read(buffer, (int) sizeof(buffer), false);
+
+        if (numRead <= 0)
+            break;
+
+        request.append(buffer, (size_t) numRead);
+    }
+
+    auto requestLine = juce::StringArray::fromTokens(request.toString().upToFirstOccurrenceOf("\n", false, false).trim(), " ", "");
+    auto path = requestLine[1].upToFirstOccurrenceOf("?", false, false);
+
+    juce::String status, contentType, body;
+
+    if (requestLine[0] != "GET")
+    {
+        status = "405 Method Not Allowed";
+        contentType = "text/plain";
+        body = "Only GET is supported.\n";
+    }
+    else if (path == "/metrics")
+    {
+        status = "200 OK";
+        contentType = "text/plain; version=0.0.4; charset=utf-8";
+        body = metrics.toPrometheusText();
+    }
+    else
+    {
+        status = "404 Not Found";
+        contentType = "text/plain";
+        body = "Metrics are served at /metrics.\n";
+    }
+
+    auto bodyUtf8 = body.toUTF8();
+    auto bodySize = (int) bodyUtf8.sizeInBytes() - 1;
+
+    juce::String header;
+    header << "HTTP/1.1 " << status << "\r\n"
+           << "Content-Type: " << contentType << "\r\n"
+           << "Content-Length: " << bodySize << "\r\n"
+           << "Connection: close\r\n\r\n";
+
+    auto headerUtf8 = header.toUTF8();
+
+    if (connection.write(headerUtf8.getAddress(), (int) headerUtf8.sizeInBytes() - 1) >= 0)
+        connection.write(bodyUtf8.getAddress(), bodySize);
+
+    connection.close();
+}
+
+//==============================================================================
+MetricsReporter::MetricsReporter(const ScanMetrics& metricsToReport, const Options& optionsToUse,
+                                 const LogCallback& callback)
+    : juce::Thread("Metrics reporter"),
+      metrics(metricsToReport),
+      options(optionsToUse),
+      onLogLine(callback)
+{
+}
+
+MetricsReporter::~MetricsReporter()
+{
+    stop();
+}
+
+bool MetricsReporter::start()
+{
+    if (server != nullptr || isThreadRunning())
+        return true;
+
+    if (options.port > 0)
+    {
+        server = std::make_unique<Server>(metrics, options);
+
+        if (! server->start())
+        {
+            server.reset();
+            return false;
+        }
+    }
+
+    if (options.logIntervalSeconds > 0.0)
+    {
+        loggedFiles = metrics.getNumFiles();
+        loggedBytes = metrics.getNumBytesRead();
+        loggedAt = metrics.getUptime();
+
+        startThread();
+    }
+
+    return true;
+}
+
+void MetricsReporter::stop()
+{
+    server.reset();
+
+    if (! isThreadRunning())
+        return;
+
+    signalThreadShouldExit();
+    notify();
+    stopThread(5000);
+
+    writeLogLine();
+}
+
+//==============================================================================
+void MetricsReporter::run()
+{
+    auto nextLog = metrics.getUptime() + options.logIntervalSeconds;
+
+    while (! threadShouldExit())
+    {
+        auto now = metrics.getUptime();
+
+        if (now >= nextLog)
+        {
+            writeLogLine();
+
+            // Catch up rather than burst if the thread was held up.
+            while (nextLog <= now)
+                nextLog += options.logIntervalSeconds;
+        }
+
+        wait(juce::jmax(1, juce::roundToInt((nextLog - now) * 1000.0)));
+    }
+}
+
+void MetricsReporter::writeLogLine()
+{
+    auto now = metrics.getUptime();
+    auto line = metrics.toJsonLine(loggedFiles, loggedBytes, now - loggedAt);
+
+    loggedFiles = metrics.getNumFiles();
+    loggedBytes = metrics.getNumBytesRead();
+    loggedAt = now;
+
+    if (onLogLine != nullptr)
+        onLogLine(line);
+}
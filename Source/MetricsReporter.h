@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    MetricsReporter.h
+
+    Makes a ScanMetrics visible from outside the process while a run goes on:
+    a line of JSON every so often, for log shippers, and/or a Prometheus
+    endpoint answering "GET /metrics" on a TCP port, for scrapers. Each has
+    a background thread of its own, so the workers never wait on either, and
+    a slow client can't hold up the log. Only depends on juce_core.
+
+    The endpoint is deliberately minimal: one request per connection, served
+    in turn, each given a short deadline, with no TLS or authentication. It
+    only listens on localhost unless told otherwise.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ScanMetrics.h"
+
+//==============================================================================
+class MetricsReporter : private juce::Thread
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        // Seconds between JSON lines, or zero for none.
+        double logIntervalSeconds = 0.0;
+
+        // The port to serve "/metrics" on, or zero for none.
+        int port = 0;
+
+        // The address to listen on. Empty listens on every interface, e.g.
+        // for a scraper on another host.
+        juce::String bindAddress = "127.0.0.1";
+    };
+
+    /* Called from the reporting thread with each JSON line. */
+    using LogCallback = std::function<void(const juce::String&)>;
+
+    //==============================================================================
+    /* The metrics must outlive the reporter. */
+    MetricsReporter(const ScanMetrics& metrics, const Options& options, const LogCallback& onLogLine);
+    ~MetricsReporter() override;
+
+    /* Opens the port, if there is one, and starts reporting. Returns false if
+       the port couldn't be listened on. */
+    bool start();
+
+    /* Stops reporting, writing one last JSON line if they're being written,
+       so a run's totals always make it into the log. */
+    void stop();
+
+private:
+    //==============================================================================
+    class Server;
+
+    void run() override;
+    void writeLogLine();
+
+    //==============================================================================
+    const ScanMetrics& metrics;
+    Options options;
+    LogCallback onLogLine;
+
+    std::unique_ptr<Server> server;
+
+    // The totals at the last JSON line, for the rates in the next.
+    juce::uint64 loggedFiles = 0, loggedBytes = 0;
+    double loggedAt = 0.0;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MetricsReporter)
+};
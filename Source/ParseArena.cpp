@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+    ParseArena.cpp
+
+  ==============================================================================
+*/
+
+#include "ParseArena.h"
+
+//==============================================================================
+ParseArena::ParseArena(size_t blockSizeToUse)
+    : blockSize(juce::jmax((size_t) 1024, blockSizeToUse))
+{
+}
+
+void* ParseArena::allocate(size_t numBytes, size_t alignment)
+{
+    jassert(juce::isPowerOfTwo(alignment));
+
+    auto alignUp = [alignment](size_t offset) { return (offset + alignment - 1) & ~(alignment - 1); };
+
+    if (auto* block = blocks.getLast())
+    {
+        auto start = alignUp(used);
+
+        if (start <= block->size && numBytes <= block->size - start)
+        {
+            used = start + numBytes;
+            return block->data + start;
+        }
+    }
+
+    // HeapBlock memory is aligned for anything, so a new block starts aligned.
+    addBlock(numBytes);
+    used = numBytes;
+    return blocks.getLast()->data.get();
+}
+
+bool ParseArena::tryExtend(void* allocation, size_t oldSize, size_t newSize) noexcept
+{
+    auto* block = blocks.getLast();
+
+    if (block == nullptr || allocation == nullptr || newSize < oldSize)
+        return false;
+
+    auto* start = static_cast<char*>(allocation);
+
+    if (start + oldSize != block->data + used || newSize - oldSize > block->size - used)
+        return false;
+
+    used += newSize - oldSize;
+    return true;
+}
+
+void ParseArena::reset()
+{
+    auto capacity = getCapacity();
+
+    if (capacity > maxRetainedSize)
+    {
+        blocks.clear();
+    }
+    else if (blocks.size() > 1)
+    {
+        // This file needed more than one block; give the next one room for
+        // the same in a single block, so the arena settles after a few files.
+        blocks.clear();
+        addBlock(capacity);
+    }
+
+    used = 0;
+}
+
+size_t ParseArena::getCapacity() const noexcept
+{
+    size_t capacity = 0;
+
+    for (auto* block : blocks)
+        capacity += block->size;
+
+    return capacity;
+}
+
+void ParseArena::addBlock(size_t minimumSize)
+{
+    auto* block = blocks.add(new Block());
+    block->size = juce::jmax(blockSize, minimumSize);
+    block->data.malloc(block->size);
+}
+
+//==============================================================================
+ParseArena::Buffer::Buffer(ParseArena& arenaToUse, size_t initialCapacity, size_t alignmentToUse)
+    : arena(arenaToUse),
+      alignment(alignmentToUse),
+      data(static_cast<char*>(arenaToUse.allocate(initialCapacity, alignmentToUse))),
+      capacity(initialCapacity)
+{
+}
+
+void ParseArena::Buffer::write(const void* bytes, size_t numBytes)
+{
+    if (numBytes > 0)
+        std::memcpy(ensureSpace(numBytes), bytes, numBytes);
+}
+
+void ParseArena::Buffer::writeRepeatedByte(char byte, size_t numTimes)
+{
+    if (numTimes > 0)
+        std::memset(ensureSpace(numTimes), byte, numTimes);
+}
+
+/* Makes room for numBytes more and returns where they go. */
+char* ParseArena::Buffer::ensureSpace(size_t numBytes)
+{
+    auto needed = size + numBytes;
+
+    if (needed > capacity)
+    {
+        auto newCapacity = juce::jmax(capacity * 2, needed);
+
+        // Nothing else was allocated since, so the buffer can usually just
+        // grow into the rest of the block.
+        if (! arena.tryExtend(data, capacity, newCapacity))
+        {
+            auto* newData = static_cast<char*>(arena.allocate(newCapacity, alignment));
+            std::memcpy(newData, data, size);
+            data = newData;
+        }
+
+        capacity = newCapacity;
+    }
+
+    auto* destination = data + size;
+    size = needed;
+    return destination;
+}
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    ParseArena.h
+
+    A bump allocator for the scratch memory of parsing one file: the read
+    windows and the pretty-printed iXML. Everything is thrown away in one go
+    by reset(), which keeps the memory for the next file, so a worker that
+    reuses its arena stops going to the allocator for these at all once it
+    has warmed up. Not thread-safe; each file being parsed needs its own.
+    Only depends on juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class ParseArena
+{
+public:
+    //==============================================================================
+    static constexpr size_t defaultBlockSize = 256 * 1024;
+
+    explicit ParseArena(size_t blockSize = defaultBlockSize);
+
+    /* Returns numBytes of uninitialised memory, valid until the next reset(). */
+    void* allocate(size_t numBytes, size_t alignment = alignof(std::max_align_t));
+
+    /* Grows the most recent allocation in place if there's room after it.
+       Returns false (leaving it alone) if it isn't the most recent or won't fit. */
+    bool tryExtend(void* allocation, size_t oldSize, size_t newSize) noexcept;
+
+    /* Frees everything allocated since the last reset. The memory is kept,
+       merged into a single block if it had to grow, unless it's grown past
+       what is worth holding on to. */
+    void reset();
+
+    /* How much memory the arena is holding, used or not. */
+    size_t getCapacity() const noexcept;
+
+    //==============================================================================
+    /* A byte buffer that grows inside an arena, for building up text, or an
+       array of something trivial if given its alignment. */
+    class Buffer
+    {
+    public:
+        explicit Buffer(ParseArena& arenaToUse, size_t initialCapacity = 4096, size_t alignment = 1);
+
+        void write(const void* bytes, size_t numBytes);
+        void writeRepeatedByte(char byte, size_t numTimes);
+
+        Buffer& operator<<(char c)                  { write(&c, 1); return *this; }
+        Buffer& operator<<(const char* text)        { write(text, std::strlen(text)); return *this; }
+
+        const char* getData() const noexcept        { return data; }
+        size_t getSize() const noexcept             { return size; }
+
+    private:
+        char* ensureSpace(size_t numBytes);
+
+        ParseArena& arena;
+        size_t alignment;
+        char* data = nullptr;
+        size_t size = 0, capacity = 0;
+
+        JUCE_DECLARE_NON_COPYABLE(Buffer)
+    };
+
+private:
+    //==============================================================================
+    struct Block
+    {
+        juce::HeapBlock<char> data;
+        size_t size = 0;
+    };
+
+    void addBlock(size_t minimumSize);
+
+    // Anything bigger than this is given back on reset rather than kept.
+    static constexpr size_t maxRetainedSize = 4 * 1024 * 1024;
+
+    size_t blockSize;
+    juce::OwnedArray<Block> blocks;
+    size_t used = 0;    // Bytes used in the last block.
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParseArena)
+};
@@ -0,0 +1,482 @@
+/*
+  ==============================================================================
+
+    ParseSession.cpp
+
+  ==============================================================================
+*/
+
+#include "ParseSession.h"
+#include "WavMetadataReader.h"
+
+//==============================================================================
+/*
+    Parses whichever pending file is most urgent at the moment the job starts,
+    rather than one fixed file, so moving the cursor re-prioritises the queue
+    without having to cancel anything.
+*/
+class ParseSession::ParseJob : public juce::ThreadPoolJob
+{
+public:
+    explicit ParseJob(ParseSession& ownerSession)
+        : juce::ThreadPoolJob("Session parse"),
+          owner(ownerSession),
+          weakOwner(&ownerSession)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        int index, jobGeneration;
+        juce::File file;
+
+        {
+            const juce::ScopedLock sl(owner.lock);
+            index = owner.pickNextToParse();
+
+            if (index < 0)
+                return jobHasFinished;
+
+            auto& entry = owner.entries.getReference(index);
+            entry.state = State::parsing;
+            file = entry.file;
+            jobGeneration = owner.generation;
+        }
+
+        auto metadata = std::make_shared<WavMetadata>();
+        ParseTimings timings;
+        MetadataCache::Stamp stamp;
+        bool isCached;
+
+        {
+            const ParseTimings::ScopedTimer timer(&timings, ParseTimings::cacheLookup);
+            isCached = owner.cache.lookup(file, *metadata, &stamp);
+        }
+
+        if (! isCached)
+        {
+            *metadata = WavMetadataReader::read(file, [this, index, jobGeneration]
+                {
+                    return shouldExit() || owner.isHeld(index, jobGeneration);
+                });
+
+            if (! metadata->cancelled)
+                owner.cache.store(file, stamp, *metadata);
+        }
+
+        std::shared_ptr<const MetadataDocument> document;
+
+        if (! metadata->cancelled)
+        {
+            const ParseTimings::ScopedTimer timer(&timings, ParseTimings::documentBuild);
+            document = createDocument(*metadata);
+        }
+
+        metadata->timings.add(timings);
+
+        {
+            const juce::ScopedLock sl(owner.lock);
+
+            // clear() may have been called while we were parsing.
+            if (jobGeneration != owner.generation)
+                return jobHasFinished;
+
+            auto& entry = owner.entries.getReference(index);
+
+            if (metadata->cancelled)
+            {
+                entry.state = State::pending;
+                return jobHasFinished;
+            }
+
+            entry.state = State::parsed;
+            entry.metadata = metadata;
+            entry.document = document;
+        }
+
+        juce::MessageManager::callAsync([session = weakOwner, index, jobGeneration]
+            {
+                if (session != nullptr && session->generation == jobGeneration)
+                    session->handleParsed(index);
+            });
+
+        return jobHasFinished;
+    }
+
+private:
+    ParseSession& owner;    // Outlives us: the session waits for its jobs before it's destroyed.
+    juce::WeakReference<ParseSession> weakOwner;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParseJob)
+};
+
+//==============================================================================
+ParseSession::ParseSession(MetadataCache& cacheToUse)
+    : cache(cacheToUse)
+{
+}
+
+ParseSession::~ParseSession()
+{
+    pool.removeAllJobs(true, 2000);
+}
+
+//==============================================================================
+int ParseSession::addFiles(const juce::Array<juce::File>& filesOrDirectories)
+{
+    return addWavFiles(findWavFiles(filesOrDirectories));
+}
+
+juce::Array<juce::File> ParseSession::findWavFiles(const juce::Array<juce::File>& filesOrDirectories)
+{
+    juce::Array<juce::File> files;
+
+    for (const auto& item : filesOrDirectories)
+    {
+        if (item.isDirectory())
+        {
+            for (const auto& entry : juce::RangedDirectoryIterator(item, true, "*", juce::File::findFiles))
+                if (entry.getFile().hasFileExtension("wav"))
+                    files.add(entry.getFile());
+        }
+        else if (item.existsAsFile())
+        {
+            files.add(item);
+        }
+    }
+
+    // Directory order isn't guaranteed, and takes are easiest to step through by name.
+    files.sort();
+    return files;
+}
+
+int ParseSession::addWavFiles(const juce::Array<juce::File>& files)
+{
+    int firstIndex = -1;
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (const auto& file : files)
+        {
+            auto existing = [&]
+                {
+                    for (int i = 0; i < entries.size(); ++i)
+                        if (entries.getReference(i).file == file)
+                            return i;
+
+                    return -1;
+                }();
+
+            if (existing < 0)
+            {
+                existing = entries.size();
+                entries.add({ file });
+            }
+
+            if (firstIndex < 0)
+                firstIndex = existing;
+        }
+    }
+
+    scheduleParses();
+    return firstIndex;
+}
+
+void ParseSession::clear()
+{
+    {
+        const juce::ScopedLock sl(lock);
+        entries.clear();
+        cursor = 0;
+        ++generation;
+    }
+
+    pool.removeAllJobs(true, 0);
+}
+
+int ParseSession::getNumFiles() const
+{
+    const juce::ScopedLock sl(lock);
+    return entries.size();
+}
+
+juce::File ParseSession::getFile(int index) const
+{
+    const juce::ScopedLock sl(lock);
+    return juce::isPositiveAndBelow(index, entries.size()) ? entries.getReference(index).file : juce::File();
+}
+
+int ParseSession::indexOf(const juce::File& file) const
+{
+    const juce::ScopedLock sl(lock);
+
+    for (int i = 0; i < entries.size(); ++i)
+        if (entries.getReference(i).file == file)
+            return i;
+
+    return -1;
+}
+
+std::shared_ptr<const MetadataDocument> ParseSession::getDocument(int index) const
+{
+    const juce::ScopedLock sl(lock);
+    return juce::isPositiveAndBelow(index, entries.size()) ? entries.getReference(index).document : nullptr;
+}
+
+std::shared_ptr<const WavMetadata> ParseSession::getMetadata(int index) const
+{
+    const juce::ScopedLock sl(lock);
+    return juce::isPositiveAndBelow(index, entries.size()) ? entries.getReference(index).metadata : nullptr;
+}
+
+std::shared_ptr<const MetadataDocument> ParseSession::setResult(const juce::File& file, const WavMetadata& metadata,
+                                                                const MetadataCache::Stamp& stampBeforeReading)
+{
+    auto result = std::make_shared<WavMetadata>(metadata);
+
+    std::shared_ptr<const MetadataDocument> document;
+
+    {
+        const ParseTimings::ScopedTimer timer(&result->timings, ParseTimings::documentBuild);
+        document = createDocument(metadata);
+    }
+
+    if (indexOf(file) < 0)
+        return document;
+
+    cache.store(file, stampBeforeReading, metadata);
+
+    // Looked up again, as the session may have changed while we were storing.
+    const juce::ScopedLock sl(lock);
+    auto index = indexOf(file);
+
+    if (index < 0)
+        return document;
+
+    auto& entry = entries.getReference(index);
+    entry.state = State::parsed;
+    entry.metadata = result;
+    entry.document = document;
+    return document;
+}
+
+void ParseSession::holdFile(const juce::File& file)
+{
+    for (;;)
+    {
+        {
+            const juce::ScopedLock sl(lock);
+            auto index = indexOf(file);
+
+            if (index < 0)
+                return;
+
+            auto& entry = entries.getReference(index);
+            entry.held = true;
+
+            if (entry.state != State::parsing)
+                return;
+        }
+
+        juce::Thread::sleep(5);
+    }
+}
+
+void ParseSession::releaseFile(const juce::File& file)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        auto index = indexOf(file);
+
+        if (index < 0)
+            return;
+
+        entries.getReference(index).held = false;
+    }
+
+    // It's pending again if its parse was abandoned for the hold.
+    scheduleParses();
+}
+
+void ParseSession::setCursor(int index)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        cursor = index;
+    }
+
+    scheduleParses();
+}
+
+//==============================================================================
+int ParseSession::pickNextToParse()
+{
+    auto isPending = [this](int index)
+        {
+            return juce::isPositiveAndBelow(index, entries.size())
+                && entries.getReference(index).state == State::pending
+                && ! entries.getReference(index).held;
+        };
+
+    // The file under the cursor, then the ones after it, then a couple before.
+    for (int i = 0; i <= filesAhead; ++i)
+        if (isPending(cursor + i))
+            return cursor + i;
+
+    for (int i = 1; i <= filesBehind; ++i)
+        if (isPending(cursor - i))
+            return cursor - i;
+
+    return -1;
+}
+
+bool ParseSession::isHeld(int index, int entryGeneration) const
+{
+    const juce::ScopedLock sl(lock);
+
+    // After a clear() the index may not be there any more, but then the parse is stale anyway.
+    return entryGeneration == generation && entries.getReference(index).held;
+}
+
+void ParseSession::scheduleParses()
+{
+    int numPending = 0;
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        for (int i = cursor - filesBehind; i <= cursor + filesAhead; ++i)
+            if (juce::isPositiveAndBelow(i, entries.size()) && entries.getReference(i).state == State::pending
+                  && ! entries.getReference(i).held)
+                ++numPending;
+    }
+
+    // Each job takes the most urgent file when it starts, so we only need as
+    // many queued jobs as there are files left to parse around the cursor.
+    auto numToAdd = juce::jmin(numPending, pool.getNumThreads() * 2) - pool.getNumJobs();
+
+    for (int i = 0; i < numToAdd; ++i)
+        pool.addJob(new ParseJob(*this), true);
+}
+
+void ParseSession::handleParsed(int index)
+{
+    if (onFileParsed != nullptr)
+        onFileParsed(index);
+
+    scheduleParses();
+}
+
+//==============================================================================
+std::shared_ptr<MetadataDocument> ParseSession::createDocument(const WavMetadata& metadata)
+{
+    auto document = std::make_shared<MetadataDocument>();
+
+    if (metadata.status.failed())
+    {
+        document->addSection("Error: " + metadata.status.getErrorMessage(), {});
+        return document;
+    }
+
+    const auto& format = metadata.format;
+
+    if (format.found)
+    {
+        juce::String formatSummary;
+        auto sampleFormat = format.getSampleFormat();
+
+        formatSummary << "Audio Format: " << (sampleFormat == WavMetadata::Format::pcm ? "PCM"
+                                              : sampleFormat == WavMetadata::Format::ieeeFloat ? "IEEE float"
+                                              : "Compressed (Format ID: " + juce::String(format.audioFormat) + ")")
+                      << (format.audioFormat == WavMetadata::Format::extensible ? " (extensible)" : "") << "\n";
+        formatSummary << "Channels: " << juce::String(format.numChannels) << "\n";
+        formatSummary << "Sample Rate: " << juce::String(format.sampleRate) << " Hz\n";
+        formatSummary << "Bit Depth: " << juce::String(format.bitsPerSample) << " bits\n";
+
+        document->addSection("WAV File Properties", formatSummary);
+    }
+    else
+    {
+        document->addSection("WAV Format data (fmt chunk) not found.", {});
+    }
+
+    const auto& bext = metadata.bext;
+
+    if (bext.found)
+    {
+        // Values are free text, so keep any line breaks from splitting a field into several rows.
+        auto field = [](const juce::String& value) { return value.replaceCharacters("\r\n", "  "); };
+
+        juce::String bextSummary;
+        bextSummary << "Description: " << field(bext.description) << "\n";
+        bextSummary << "Originator: " << field(bext.originator) << "\n";
+        bextSummary << "Originator Ref: " << field(bext.originatorReference) << "\n";
+        bextSummary << "Origination Date: " << field(bext.originationDate) << "\n";
+        bextSummary << "Origination Time: " << field(bext.originationTime) << "\n";
+        bextSummary << "Time Reference: " << juce::String(bext.timeReference) << " (samples since midnight)\n";
+        bextSummary << "Version: " << juce::String(bext.version) << "\n";
+
+        if (bext.umidSize > 0)
+            bextSummary << "UMID: " << bext.getUmidAsHex() << "\n";
+
+        auto loudness = [&bextSummary](const char* name, float value, const char* unit)
+            {
+                if (! std::isnan(value))
+                    bextSummary << name << ": " << juce::String(value, 2) << " " << unit << "\n";
+            };
+
+        loudness("Loudness Value", bext.loudnessValue, "LUFS");
+        loudness("Loudness Range", bext.loudnessRange, "LU");
+        loudness("Max True Peak Level", bext.maxTruePeakLevel, "dBTP");
+        loudness("Max Momentary Loudness", bext.maxMomentaryLoudness, "LUFS");
+        loudness("Max Short-Term Loudness", bext.maxShortTermLoudness, "LUFS");
+
+        document->addSection("Broadcast Extension (bext) Data", bextSummary);
+    }
+    else
+    {
+        document->addSection("No Broadcast Extension (bext) chunk found in this file.", {});
+    }
+
+    if (metadata.ixml.found)
+        document->addSection("iXML Metadata", metadata.ixml.text);
+    else
+        document->addSection("No iXML chunk was found in this file.", {});
+
+    // The rest only get a section when the file has them, as most files don't.
+    if (metadata.adm.found)
+        document->addSection("ADM Metadata (axml chunk)", metadata.adm.text);
+
+    const auto& chna = metadata.chna;
+
+    if (chna.found)
+    {
+        juce::String chnaSummary;
+        chnaSummary << "Tracks: " << juce::String(chna.numTracks) << "\n";
+
+        for (const auto& track : chna.tracks)
+            chnaSummary << "Track " << juce::String(track.trackIndex) << ": " << track.uid
+                        << " -> " << track.trackReference << " / " << track.packReference << "\n";
+
+        document->addSection("ADM Channel Allocation (chna chunk)", chnaSummary);
+    }
+
+    if (metadata.xmp.found)
+        document->addSection("XMP Metadata (_PMX chunk)", metadata.xmp.text);
+
+    if (metadata.info.found)
+    {
+        juce::String infoSummary;
+
+        for (const auto& field : metadata.info.fields)
+        {
+            auto name = WavMetadata::Info::getFieldName(field.id);
+            infoSummary << (name.isNotEmpty() ? name + " (" + field.id + ")" : field.id) << ": " << field.value << "\n";
+        }
+
+        document->addSection("RIFF INFO List (LIST chunk)", infoSummary);
+    }
+
+    return document;
+}
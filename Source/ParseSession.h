@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    ParseSession.h
+
+    The list of files open in the viewer. Files are parsed on a small pool of
+    background threads, nearest to the user's cursor first, so by the time
+    the user steps to the next take it has usually been parsed already.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "WavMetadata.h"
+#include "MetadataView.h"
+#include "MetadataCache.h"
+
+//==============================================================================
+class ParseSession
+{
+public:
+    //==============================================================================
+    /* The cache must outlive the session. */
+    explicit ParseSession(MetadataCache& cacheToUse);
+    ~ParseSession();
+
+    //==============================================================================
+    /* Appends files to the session; directories are searched for WAV files.
+       Files that are already open aren't added again. Returns the index of the
+       first of the given files in the session, or -1 if none were usable. */
+    int addFiles(const juce::Array<juce::File>& filesOrDirectories);
+
+    /* Like addFiles(), but for files already found by findWavFiles(), which
+       are added as they are without being looked at again. */
+    int addWavFiles(const juce::Array<juce::File>& wavFiles);
+
+    /* The files, and the WAV files in any of the directories, sorted by name.
+       Touches nothing but the file system, so can be called on any thread. */
+    static juce::Array<juce::File> findWavFiles(const juce::Array<juce::File>& filesOrDirectories);
+
+    /* Closes every file, abandoning any parses in flight. */
+    void clear();
+
+    int getNumFiles() const;
+    juce::File getFile(int index) const;
+    int indexOf(const juce::File& file) const;
+
+    /* The parsed result for a file, or nullptr if it hasn't been parsed yet. */
+    std::shared_ptr<const MetadataDocument> getDocument(int index) const;
+    std::shared_ptr<const WavMetadata> getMetadata(int index) const;
+
+    /* Replaces a file's result with one read outside the session, e.g. by a
+       LiveFileFollower, and returns the document built from it. The stamp is
+       the file's as it was before that read, which is what gets cached (see
+       MetadataCache::store()). Building the document and storing it can take
+       a while, so this is best called from the thread that did the reading;
+       nothing is stored if the file has been closed in the meantime. */
+    std::shared_ptr<const MetadataDocument> setResult(const juce::File& file, const WavMetadata& metadata,
+                                                      const MetadataCache::Stamp& stampBeforeReading);
+
+    /* Keeps the session's parses off a file until releaseFile() is called,
+       e.g. while it's being rewritten. A parse of it that's already running
+       is abandoned at its next read, and this waits until it has stopped,
+       so call it from a background thread. */
+    void holdFile(const juce::File& file);
+    void releaseFile(const juce::File& file);
+
+    /* Tells the session which file the user is looking at, so it and the
+       files after it are parsed first. */
+    void setCursor(int index);
+
+    /* Called on the message thread whenever a file has been parsed. */
+    std::function<void(int index)> onFileParsed;
+
+    //==============================================================================
+    /* Builds the document shown in the display from a parsed file. */
+    static std::shared_ptr<MetadataDocument> createDocument(const WavMetadata& metadata);
+
+private:
+    //==============================================================================
+    class ParseJob;
+
+    enum class State
+    {
+        pending,
+        parsing,
+        parsed
+    };
+
+    struct Entry
+    {
+        juce::File file;
+        State state = State::pending;
+        bool held = false;
+        std::shared_ptr<const WavMetadata> metadata;
+        std::shared_ptr<const MetadataDocument> document;
+    };
+
+    // How far around the cursor files are parsed ahead of time.
+    static constexpr int filesAhead = 16;
+    static constexpr int filesBehind = 2;
+
+    int pickNextToParse();      // Called with the lock held.
+    bool isHeld(int index, int entryGeneration) const;
+    void scheduleParses();
+    void handleParsed(int index);
+
+    //==============================================================================
+    MetadataCache& cache;
+
+    mutable juce::CriticalSection lock;
+    juce::Array<Entry> entries;
+    int cursor = 0;
+    int generation = 0;         // Bumped by clear(), so stale results are dropped.
+
+    juce::ThreadPool pool { juce::jlimit(1, 4, juce::SystemStats::getNumCpus() - 1) };
+
+    //==============================================================================
+    JUCE_DECLARE_WEAK_REFERENCEABLE(ParseSession)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParseSession)
+};
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    ParseTimings.cpp
+
+  ==============================================================================
+*/
+
+#include "ParseTimings.h"
+
+//==============================================================================
+const char* ParseTimings::getStageName(Stage stage) noexcept
+{
+    switch (stage)
+    {
+        case cacheLookup:       return "cache lookup";
+        case io:                return "I/O";
+        case chunkWalk:         return "chunk walk";
+        case decode:            return "chunk decode";
+        case ixmlParse:         return "iXML parse";
+        case documentBuild:     return "document build";
+        case display:           return "display";
+        case numStages:         break;
+    }
+
+    return "";
+}
+
+double ParseTimings::getTotalSeconds() const noexcept
+{
+    double total = 0.0;
+
+    for (auto s : seconds)
+        total += s;
+
+    return total;
+}
+
+void ParseTimings::add(const ParseTimings& other) noexcept
+{
+    for (int i = 0; i < numStages; ++i)
+        seconds[i] += other.seconds[i];
+}
+
+juce::String ParseTimings::toString() const
+{
+    juce::StringArray parts;
+
+    for (int i = 0; i < numStages; ++i)
+        if (seconds[i] > 0.0)
+            parts.add(juce::String(getStageName((Stage) i)) + " " + juce::String(seconds[i] * 1000.0, 2) + " ms");
+
+    return parts.joinIntoString(", ");
+}
+
+void ParseTimings::switchTo(int stage) noexcept
+{
+    auto now = juce::Time::getHighResolutionTicks();
+
+    if (currentStage >= 0)
+        seconds[currentStage] += juce::Time::highResolutionTicksToSeconds(now - currentStart);
+
+    currentStage = stage;
+    currentStart = now;
+}
+
+//==============================================================================
+ParseTimings::ScopedTimer::ScopedTimer(ParseTimings* timingsToUpdate, Stage stageToTime) noexcept
+    : timings(timingsToUpdate),
+      previousStage(timingsToUpdate != nullptr ? timingsToUpdate->currentStage : -1)
+{
+    if (timings != nullptr)
+        timings->switchTo(stageToTime);
+}
+
+ParseTimings::ScopedTimer::~ScopedTimer()
+{
+    if (timings != nullptr)
+        timings->switchTo(previousStage);
+}
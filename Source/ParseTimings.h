@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    ParseTimings.h
+
+    Where the time went while opening a file: reading, walking the chunk
+    table, decoding, building the view. Stages are timed with scoped timers
+    that pause the enclosing stage while they run, so every stage's time is
+    its own and the stages add up to the total. Only depends on juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class ParseTimings
+{
+public:
+    //==============================================================================
+    enum Stage
+    {
+        cacheLookup,    // Stat'ing the file and decoding a cache entry.
+        io,             // Opening the file and reading bytes from it.
+        chunkWalk,      // Reading chunk headers and resolving sizes.
+        decode,         // Every metadata chunk other than iXML.
+        ixmlParse,      // Tokenizing and pretty-printing the iXML.
+        documentBuild,  // Turning the result into rows for the view.
+        display,        // Handing the rows to the view.
+        numStages
+    };
+
+    static const char* getStageName(Stage stage) noexcept;
+
+    //==============================================================================
+    double getSeconds(Stage stage) const noexcept       { return seconds[stage]; }
+    double getTotalSeconds() const noexcept;
+
+    void addSeconds(Stage stage, double secondsToAdd) noexcept  { seconds[stage] += secondsToAdd; }
+
+    /* Adds every stage of another set of timings to this one. */
+    void add(const ParseTimings& other) noexcept;
+
+    /* e.g. "io 1.20 ms, chunk walk 0.05 ms, ...", skipping stages that took no time. */
+    juce::String toString() const;
+
+    //==============================================================================
+    /* Times a stage for as long as it's in scope. Any timer already running on
+       the same ParseTimings is paused meanwhile. A null ParseTimings makes this
+       do nothing, so instrumented code works without anyone listening. */
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(ParseTimings* timingsToUpdate, Stage stageToTime) noexcept;
+        ~ScopedTimer();
+
+    private:
+        ParseTimings* timings;
+        int previousStage;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTimer)
+    };
+
+private:
+    //==============================================================================
+    void switchTo(int stage) noexcept;
+
+    double seconds[numStages] = {};
+
+    // The innermost running timer's stage, and when it last started counting.
+    int currentStage = -1;
+    juce::int64 currentStart = 0;
+};
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    PeakCache.cpp
+
+  ==============================================================================
+*/
+
+#include "PeakCache.h"
+#include "MetadataCache.h"
+
+namespace
+{
+    // Bump the version whenever WaveformPeaks::writeTo() changes, or
+    // peaks built before it are wrong. Version 2: extensible float files
+    // were drawn as integers.
+    constexpr int peakMagic = 0x4b505869;      // "iXPK"
+    constexpr int peakVersion = 2;
+    constexpr int endMarker = 0x444e4550;      // "PEND"
+}
+
+//==============================================================================
+PeakCache::PeakCache(const juce::File& directoryToUse)
+    : directory(directoryToUse)
+{
+}
+
+juce::File PeakCache::getDefaultDirectory()
+{
+    return MetadataCache::getDefaultIndexFile().getSiblingFile("Peaks");
+}
+
+/* Named after a hash of the path; the path itself is stored inside to catch collisions. */
+juce::File PeakCache::getPeakFile(const juce::File& audioFile) const
+{
+    return directory.getChildFile(juce::String::toHexString(audioFile.getFullPathName().hashCode64()) + ".peaks");
+}
+
+//==============================================================================
+bool PeakCache::lookup(const juce::File& audioFile, WaveformPeaks& result) const
+{
+    juce::FileInputStream in(getPeakFile(audioFile));
+
+    if (! in.openedOk())
+        return false;
+
+    if (in.readInt() != peakMagic || in.readInt() != peakVersion
+         || in.readString() != audioFile.getFullPathName()
+         || in.readInt64() != audioFile.getSize()
+         || in.readInt64() != audioFile.getLastModificationTime().toMilliseconds())
+        return false;
+
+    WaveformPeaks peaks;
+
+    if (! peaks.readFrom(in) || in.readInt() != endMarker)
+        return false;
+
+    result = std::move(peaks);
+    return true;
+}
+
+bool PeakCache::store(const juce::File& audioFile, const WaveformPeaks& peaks) const
+{
+    if (! directory.createDirectory())
+        return false;
+
+    auto peakFile = getPeakFile(audioFile);
+
+    // As with the metadata cache, a crash mid-write mustn't leave half a file.
+    juce::TemporaryFile temp(peakFile);
+
+    {
+        juce::FileOutputStream out(temp.getFile());
+
+        if (! out.openedOk())
+            return false;
+
+        out.writeInt(peakMagic);
+        out.writeInt(peakVersion);
+        out.writeString(audioFile.getFullPathName());
+        out.writeInt64(audioFile.getSize());
+        out.writeInt64(audioFile.getLastModificationTime().toMilliseconds());
+        peaks.writeTo(out);
+        out.writeInt(endMarker);
+        out.flush();
+
+        if (out.getStatus().failed())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
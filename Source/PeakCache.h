@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    PeakCache.h
+
+    Keeps the waveform peaks of files that have been looked at, one small
+    file each in a directory next to the metadata cache, so a waveform only
+    has to be built from the audio the first time a file is opened. An entry
+    is only used while the file's size and modification time still match.
+    Only depends on juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WaveformPeaks.h"
+
+//==============================================================================
+class PeakCache
+{
+public:
+    //==============================================================================
+    explicit PeakCache(const juce::File& directory = getDefaultDirectory());
+
+    /* The "Peaks" directory beside the metadata cache. */
+    static juce::File getDefaultDirectory();
+
+    //==============================================================================
+    /* Fills in the peaks and returns true if there are up-to-date ones for this
+       file. Safe to call from any thread. */
+    bool lookup(const juce::File& audioFile, WaveformPeaks& result) const;
+
+    /* Saves the peaks for a file, replacing any that were there. Safe to call
+       from any thread, although two threads storing the same file will race. */
+    bool store(const juce::File& audioFile, const WaveformPeaks& peaks) const;
+
+private:
+    //==============================================================================
+    juce::File getPeakFile(const juce::File& audioFile) const;
+
+    juce::File directory;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PeakCache)
+};
@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+    RemoteScanner.cpp
+
+  ==============================================================================
+*/
+
+#include "RemoteScanner.h"
+#include "WavMetadataReader.h"
+
+//==============================================================================
+RemoteScanner::RemoteScanner(const Options& optionsToUse)
+    : options(optionsToUse)
+{
+}
+
+int RemoteScanner::run(const ResultCallback& onResult)
+{
+    auto numJobs = juce::jmax(1, options.numJobs);
+
+    // Every worker overlaps a request or more of its own while it opens its
+    // URL, so the shared pool would make most of them wait. Made before the
+    // workers' pool, so it outlives their sources.
+    juce::ThreadPool requestPool(numJobs * 2);
+    auto sourceOptions = options.source;
+
+    if (sourceOptions.requestPool == nullptr)
+        sourceOptions.requestPool = &requestPool;
+
+    juce::ThreadPool pool(numJobs);
+
+    // As in BatchScanner, only keep a few URLs queued per worker.
+    auto maxQueuedJobs = numJobs * 4;
+    int numUrls = 0;
+
+    auto updateQueueDepth = [&]
+        {
+            if (auto* metrics = options.metrics)
+                metrics->setQueueDepth(pool.getNumJobs());
+        };
+
+    for (const auto& url : options.urls)
+    {
+        while (pool.getNumJobs() >= maxQueuedJobs && ! isStopping())
+        {
+            jobFinished.wait(100);
+            updateQueueDepth();
+        }
+
+        if (isStopping())
+            break;
+
+        pool.addJob([this, url, &onResult, &sourceOptions]
+            {
+                juce::uint64 bytesRead = 0;
+                auto metadata = read(url, sourceOptions, [this] { return isStopping(); }, bytesRead);
+
+                if (! metadata.cancelled)
+                {
+                    if (auto* metrics = options.metrics)
+                        metrics->addFile(metadata, bytesRead, false, url.getScheme() + "://" + url.getDomain());
+
+                    const juce::ScopedLock sl(callbackLock);
+                    onResult(url, metadata);
+                }
+
+                jobFinished.signal();
+            });
+
+        updateQueueDepth();
+        ++numUrls;
+    }
+
+    if (isStopping())
+        pool.removeAllJobs(true, 0);
+
+    // Let the queue drain before the pool (and the callback reference) go away.
+    while (pool.getNumJobs() > 0)
+    {
+        jobFinished.wait(100);
+        updateQueueDepth();
+    }
+
+    updateQueueDepth();
+    return numUrls;
+}
+
+WavMetadata RemoteScanner::read(const juce::URL& url, const HttpRangeSource::Options& sourceOptions,
+                                const std::function<bool()>& shouldCancel)
+{
+    juce::uint64 bytesRead = 0;
+    return read(url, sourceOptions, shouldCancel, bytesRead);
+}
+
+WavMetadata RemoteScanner::read(const juce::URL& url, const HttpRangeSource::Options& sourceOptions,
+                                const std::function<bool()>& shouldCancel, juce::uint64& bytesRead)
+{
+    // As for a file, opening is most of the I/O and has to be timed from out here.
+    ParseTimings openTimings;
+    std::unique_ptr<HttpRangeSource> source;
+
+    {
+        const ParseTimings::ScopedTimer timer(&openTimings, ParseTimings::io);
+        source = std::make_unique<HttpRangeSource>(url, sourceOptions);
+    }
+
+    if (! source->openedOk())
+    {
+        bytesRead = source->getNumBytesRead();
+        WavMetadata metadata;
+
+        if (source->getStatusCode() == 0)
+            metadata.status = juce::Result::fail("No response from the server.");
+        else
+            metadata.status = juce::Result::fail("The server answered with HTTP status " + juce::String(source->getStatusCode()) + ".");
+
+        return metadata;
+    }
+
+    auto metadata = WavMetadataReader::readFromSource(*source, shouldCancel);
+    metadata.timings.add(openTimings);
+    bytesRead = source->getNumBytesRead();
+    return metadata;
+}
+
+bool RemoteScanner::isStopping() const
+{
+    return options.shouldStop != nullptr && options.shouldStop();
+}
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    RemoteScanner.h
+
+    Parses a list of WAV files held on web servers or in object storage,
+    many at once, through HttpRangeSource. Used by the command-line
+    "--scan-urls" mode. Only depends on juce_core.
+
+    Each file takes a round-trip or two and very little CPU, so throughput
+    comes from how many are in flight rather than from the number of cores:
+    the default runs far more jobs than BatchScanner would.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WavMetadata.h"
+#include "HttpRangeSource.h"
+#include "ScanMetrics.h"
+
+//==============================================================================
+class RemoteScanner
+{
+public:
+    //==============================================================================
+    struct Options
+    {
+        juce::Array<juce::URL> urls;
+
+        int numJobs = 32;
+
+        HttpRangeSource::Options source;
+
+        // If set, every URL reported is counted here, and the queue depth kept up to date.
+        ScanMetrics* metrics = nullptr;
+
+        // If set, polled between files; returning true abandons the rest of the scan.
+        std::function<bool()> shouldStop;
+    };
+
+    /* Called once per URL as soon as it has been parsed. Calls are serialised,
+       but they come from the worker threads and in no particular order. */
+    using ResultCallback = std::function<void(const juce::URL&, const WavMetadata&)>;
+
+    //==============================================================================
+    explicit RemoteScanner(const Options& options);
+
+    /* Reads every URL, blocking until each has been reported or the scan is
+       stopped. Returns the number of URLs that were parsed. */
+    int run(const ResultCallback& onResult);
+
+    /* Reads and parses a single URL on the calling thread. */
+    static WavMetadata read(const juce::URL& url, const HttpRangeSource::Options& sourceOptions = {},
+                            const std::function<bool()>& shouldCancel = nullptr);
+
+    /* As above, also saying how many bytes had to be fetched. */
+    static WavMetadata read(const juce::URL& url, const HttpRangeSource::Options& sourceOptions,
+                            const std::function<bool()>& shouldCancel, juce::uint64& bytesRead);
+
+private:
+    //==============================================================================
+    bool isStopping() const;
+
+    Options options;
+    juce::CriticalSection callbackLock;
+    juce::WaitableEvent jobFinished;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RemoteScanner)
+};
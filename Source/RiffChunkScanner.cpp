@@ -0,0 +1,264 @@
+/*
+  ==============================================================================
+
+    RiffChunkScanner.cpp
+
+  ==============================================================================
+*/
+
+#include "RiffChunkScanner.h"
+
+namespace
+{
+    // In RF64 files, a 32-bit size of all ones means "look it up in ds64".
+    constexpr juce::uint32 sizeInDs64 = 0xffffffff;
+}
+
+//==============================================================================
+RiffChunkScanner::RiffChunkScanner(ByteSource& sourceToUse)
+    : source(sourceToUse)
+{
+    if (! source.openedOk())
+    {
+        status = Status::cannotOpen;
+        return;
+    }
+
+    length = source.getTotalLength();
+
+    // "RIFF" <overall size> "WAVE", or "RF64"/"BW64" with the size in ds64.
+    auto* header = source.getBytes(0, 12);
+
+    if (header == nullptr)
+    {
+        status = length < 12 ? Status::notRiff : Status::readError;
+        return;
+    }
+
+    auto containerTag = FourCC::read(header);
+    rf64 = containerTag == FourCC::rf64 || containerTag == FourCC::bw64;
+
+    if (! rf64 && containerTag != FourCC::riff)
+    {
+        status = Status::notRiff;
+        return;
+    }
+
+    if (FourCC::read(header + 8) != FourCC::wave)
+    {
+        status = Status::notWave;
+        return;
+    }
+
+    position = 12;
+}
+
+const char* RiffChunkScanner::getPayload(const Chunk& chunk)
+{
+    return source.getBytes((juce::uint64) chunk.offset + 8, (size_t) chunk.available);
+}
+
+//==============================================================================
+bool RiffChunkScanner::findChunk(juce::uint32 tag, Chunk& result)
+{
+    for (const auto& chunk : chunks)
+    {
+        if (chunk.hasId(tag))
+        {
+            result = chunk;
+            return true;
+        }
+    }
+
+    while (indexNextChunk())
+    {
+        const auto& chunk = chunks.getReference(chunks.size() - 1);
+
+        if (chunk.hasId(tag))
+        {
+            result = chunk;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const juce::Array<RiffChunkScanner::Chunk>& RiffChunkScanner::getAllChunks()
+{
+    while (indexNextChunk())
+    {
+    }
+
+    return chunks;
+}
+
+void RiffChunkScanner::resumeFrom(const juce::Array<Chunk>& knownChunks)
+{
+    if (status != Status::ok || knownChunks.isEmpty() || ! chunks.isEmpty())
+        return;
+
+    for (auto chunk : knownChunks)
+    {
+        chunk.available = juce::jmin(chunk.size, length - juce::jmin(length, (juce::uint64) chunk.offset + 8));
+        chunks.add(chunk);
+    }
+
+    const auto& first = chunks.getReference(0);
+
+    if (rf64 && first.hasId(FourCC::ds64))
+        decodeDs64(first);
+
+    const auto& last = chunks.getReference(chunks.size() - 1);
+    auto end = (juce::uint64) last.offset + 8 + last.size + (last.size & 1);
+
+    if (end >= length)
+        reachedEnd = true;
+    else
+        position = end;
+}
+
+bool RiffChunkScanner::readChunkHeader(juce::uint64 offset, Chunk& result)
+{
+    if (status != Status::ok || offset > length || length - offset < 8)
+        return false;
+
+    auto* header = source.getBytes(offset, 8);
+
+    if (header == nullptr)
+        return false;
+
+    std::memcpy(result.id, header, 4);
+    result.offset = (juce::int64) offset;
+
+    if (! resolveSize(result.getTag(), juce::ByteOrder::littleEndianInt(header + 4), result.size))
+        return false;
+
+    result.available = juce::jmin(result.size, length - offset - 8);
+    return true;
+}
+
+//==============================================================================
+bool RiffChunkScanner::indexNextChunk()
+{
+    if (reachedEnd || status != Status::ok)
+        return false;
+
+    // Not enough room left for another 8-byte chunk header.
+    if (length - position < 8)
+    {
+        reachedEnd = true;
+        return false;
+    }
+
+    if (chunks.size() >= maxChunks)
+    {
+        status = Status::tooManyChunks;
+        return false;
+    }
+
+    auto* header = source.getBytes(position, 8);
+
+    if (header == nullptr)
+    {
+        status = Status::readError;
+        return false;
+    }
+
+    auto headerSize = juce::ByteOrder::littleEndianInt(header + 4);
+
+    Chunk chunk;
+    std::memcpy(chunk.id, header, 4);
+    chunk.offset = (juce::int64) position;
+
+    if (! resolveSize(chunk.getTag(), headerSize, chunk.size))
+    {
+        status = Status::invalidChunkSize;
+        return false;
+    }
+
+    // A truncated final chunk (e.g. a recording that was never closed) only
+    // exposes the bytes that actually exist in the file.
+    auto remaining = length - position - 8;
+    chunk.available = juce::jmin(chunk.size, remaining);
+
+    // ds64 has to come first in an RF64 file, and every size after it may
+    // depend on it, so decode it as soon as it's seen.
+    if (rf64 && chunks.isEmpty() && chunk.hasId(FourCC::ds64))
+        decodeDs64(chunk);
+
+    chunks.add(chunk);
+
+    // RIFF chunks are padded to be an even number of bytes.
+    auto paddedSize = chunk.size + (chunk.size & 1);
+
+    if (paddedSize >= remaining)
+        reachedEnd = true;
+    else
+        position += 8 + paddedSize;
+
+    return true;
+}
+
+void RiffChunkScanner::decodeDs64(const Chunk& chunk)
+{
+    // Room for far more table entries than any file has. Only this much is
+    // read, however big a corrupt header says the chunk is.
+    constexpr juce::uint64 maxDs64Size = 28 + 12 * 1024;
+
+    auto size = (size_t) juce::jmin(chunk.available, maxDs64Size);
+
+    if (auto* payload = source.getBytes((juce::uint64) chunk.offset + 8, size))
+        readDs64(payload, (juce::uint32) size);
+}
+
+void RiffChunkScanner::readDs64(const char* payload, juce::uint32 payloadSize)
+{
+    // riffSize (8), dataSize (8), sampleCount (8), tableLength (4), then the table.
+    if (payloadSize < 28)
+        return;
+
+    hasDs64 = true;
+    ds64DataSize = juce::ByteOrder::littleEndianInt64(payload + 8);
+
+    auto tableLength = juce::ByteOrder::littleEndianInt(payload + 24);
+    auto maxEntries = (payloadSize - 28) / 12;
+
+    for (juce::uint32 i = 0; i < juce::jmin(tableLength, maxEntries); ++i)
+    {
+        const char* entry = payload + 28 + i * 12;
+
+        Ds64Entry tableEntry;
+        tableEntry.tag = FourCC::read(entry);
+        tableEntry.size = juce::ByteOrder::littleEndianInt64(entry + 4);
+        ds64Table.add(tableEntry);
+    }
+}
+
+bool RiffChunkScanner::resolveSize(juce::uint32 tag, juce::uint32 headerSize, juce::uint64& result) const
+{
+    result = headerSize;
+
+    if (! rf64 || headerSize != sizeInDs64)
+        return true;
+
+    if (! hasDs64)
+        return false;
+
+    if (tag == FourCC::data)
+    {
+        result = ds64DataSize;
+        return true;
+    }
+
+    for (const auto& entry : ds64Table)
+    {
+        if (entry.tag == tag)
+        {
+            result = entry.size;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    RiffChunkScanner.h
+
+    Indexes the chunk table of a RIFF/WAVE or RF64/BW64 file. Bytes come from
+    a ByteSource, so with a memory-mapped file the payloads are handed out as
+    pointers into the mapping, and skipped chunks are never read at all.
+
+    The table can be built lazily: findChunk() only walks as far as the
+    chunk it is looking for, and every header it passes is remembered, so
+    each header is read at most once however many lookups are made, which
+    suits callers after one or two chunks. WavMetadataReader indexes the
+    whole table with getAllChunks() instead, as a LIST chunk can be
+    anywhere, and then prefetches the payloads it is going to read.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ByteSource.h"
+#include "FourCC.h"
+
+//==============================================================================
+class RiffChunkScanner
+{
+public:
+    //==============================================================================
+    /* One entry of the chunk table. */
+    struct Chunk
+    {
+        char id[4] = {};
+        juce::uint64 size = 0;          // Payload size, with RF64 sizes resolved through ds64.
+        juce::uint64 available = 0;     // How much of the payload is actually in the file.
+        juce::int64 offset = 0;         // File offset of the chunk header.
+
+        juce::uint32 getTag() const noexcept            { return FourCC::read(id); }
+        bool hasId(juce::uint32 tag) const noexcept     { return getTag() == tag; }
+    };
+
+    enum class Status
+    {
+        ok,
+        cannotOpen,
+        readError,
+        notRiff,
+        notWave,
+        invalidChunkSize,
+        tooManyChunks       // More than maxChunks; the ones before are still indexed.
+    };
+
+    /* Real files have a handful of chunks. A corrupt or hostile one made of
+       nothing but empty chunk headers would otherwise be walked for as long
+       as the file is, and its table kept in memory. */
+    static constexpr int maxChunks = 65536;
+
+    //==============================================================================
+    /* The source must outlive the scanner. */
+    explicit RiffChunkScanner(ByteSource& source);
+
+    /* Returns ok if the source opened and carries a RIFF/WAVE header, or an
+       error if that failed or a bad chunk header has been hit since. */
+    Status getStatus() const noexcept                   { return status; }
+
+    /* True for RF64 and BW64 files, whose large sizes live in the ds64 chunk. */
+    bool isRf64() const noexcept                        { return rf64; }
+
+    //==============================================================================
+    /* Finds the first chunk with the given tag (see FourCC.h), indexing only
+       as much of the file as it needs to. Returns false if there is no such chunk. */
+    bool findChunk(juce::uint32 tag, Chunk& result);
+
+    /* Indexes the remainder of the file and returns the complete chunk table. */
+    const juce::Array<Chunk>& getAllChunks();
+
+    /* Carries on from a chunk table saved by an earlier scan of the same file,
+       e.g. one that is still being recorded. The given chunks are taken as
+       they are, and indexing continues after the last of them, so only the
+       headers of chunks appended since are read. An RF64 ds64 chunk is
+       decoded again, as recorders update it as the file grows. */
+    void resumeFrom(const juce::Array<Chunk>& knownChunks);
+
+    /* Reads the chunk header at the given offset, without adding it to the
+       table, e.g. to check that a remembered chunk is still there. */
+    bool readChunkHeader(juce::uint64 offset, Chunk& result);
+
+    /* The chunks indexed so far, in file order. */
+    const juce::Array<Chunk>& getIndexedChunks() const noexcept  { return chunks; }
+
+    /* Returns a view of the available part of a chunk's payload, or nullptr if
+       it couldn't be read. Valid for as long as the source is. */
+    const char* getPayload(const Chunk& chunk);
+
+private:
+    //==============================================================================
+    struct Ds64Entry
+    {
+        juce::uint32 tag = 0;
+        juce::uint64 size = 0;
+    };
+
+    bool indexNextChunk();
+    void decodeDs64(const Chunk& chunk);
+    void readDs64(const char* payload, juce::uint32 payloadSize);
+    bool resolveSize(juce::uint32 tag, juce::uint32 headerSize, juce::uint64& result) const;
+
+    //==============================================================================
+    ByteSource& source;
+    juce::uint64 length = 0;
+    juce::uint64 position = 0;
+    Status status = Status::ok;
+
+    bool rf64 = false;
+    bool hasDs64 = false;
+    juce::uint64 ds64DataSize = 0;
+    juce::Array<Ds64Entry> ds64Table;
+
+    juce::Array<Chunk> chunks;
+    bool reachedEnd = false;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RiffChunkScanner)
+};
@@ -0,0 +1,304 @@
+/*
+  ==============================================================================
+
+    ScanMetrics.cpp
+
+  ==============================================================================
+*/
+
+#include "ScanMetrics.h"
+
+namespace
+{
+    /* Formats a bucket bound or a sum the way Prometheus expects. */
+    juce::String formatNumber(double value)
+    {
+        if (value == std::floor(value) && std::abs(value) < 1.0e15)
+            return juce::String((juce::int64) value);
+
+        return juce::String(value, 6).trimCharactersAtEnd("0");
+    }
+
+    /* A Prometheus label value, with the backslashes of Windows paths escaped. */
+    juce::String escapeLabel(const juce::String& value)
+    {
+        return value.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+    }
+
+    /* A JSON string, quotes included. */
+    juce::String quoteJson(const juce::String& value)
+    {
+        juce::String quoted("\"");
+
+        for (auto p = value.getCharPointer(); ! p.isEmpty();)
+        {
+            auto c = p.getAndAdvance();
+
+            if (c == '"' || c == '\\')
+                quoted << '\\' << juce::String::charToString(c);
+            else if (c < 0x20)
+                quoted << "\\u" << juce::String::toHexString((int) c).paddedLeft('0', 4);
+            else
+                quoted << juce::String::charToString(c);
+        }
+
+        return quoted + "\"";
+    }
+
+    /* A quantile in milliseconds for JSON, which has no infinity, so one past
+       the last bucket is null. */
+    juce::String quantileMs(const ScanMetrics::Histogram& histogram, double quantile)
+    {
+        auto seconds = histogram.getQuantile(quantile);
+        return std::isinf(seconds) ? juce::String("null") : juce::String(seconds * 1000.0, 1);
+    }
+}
+
+//==============================================================================
+ScanMetrics::Histogram::Histogram(std::initializer_list<double> upperBounds) noexcept
+{
+    for (auto bound : upperBounds)
+    {
+        jassert(numBounds < maxBuckets);
+        jassert(numBounds == 0 || bound > bounds[numBounds - 1]);
+
+        if (numBounds < maxBuckets)
+            bounds[numBounds++] = bound;
+    }
+}
+
+void ScanMetrics::Histogram::add(double value) noexcept
+{
+    auto bucket = (int) (std::lower_bound(bounds, bounds + numBounds, value) - bounds);
+
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+
+    // There's no fetch_add for doubles before C++20.
+    auto previous = sum.load(std::memory_order_relaxed);
+
+    while (! sum.compare_exchange_weak(previous, previous + value, std::memory_order_relaxed))
+    {
+    }
+}
+
+double ScanMetrics::Histogram::getQuantile(double quantile) const noexcept
+{
+    auto total = getCount();
+
+    if (total == 0)
+        return 0.0;
+
+    auto target = (juce::uint64) std::ceil(juce::jlimit(0.0, 1.0, quantile) * (double) total);
+    juce::uint64 seen = 0;
+
+    for (int i = 0; i < numBounds; ++i)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+
+        if (seen >= target)
+            return bounds[i];
+    }
+
+    // In the overflow bucket, which has no upper bound.
+    return std::numeric_limits<double>::infinity();
+}
+
+void ScanMetrics::Histogram::writePrometheus(juce::String& out, const juce::String& name, const juce::String& help) const
+{
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " histogram\n";
+
+    writePrometheusSamples(out, name, {});
+}
+
+void ScanMetrics::Histogram::writePrometheusSamples(juce::String& out, const juce::String& name, const juce::String& labels) const
+{
+    auto bucketLabels = labels.isEmpty() ? juce::String() : labels + ",";
+    auto ownLabels = labels.isEmpty() ? juce::String() : "{" + labels + "}";
+
+    // Prometheus buckets are cumulative.
+    juce::uint64 cumulative = 0;
+
+    for (int i = 0; i < numBounds; ++i)
+    {
+        cumulative += buckets[i].load(std::memory_order_relaxed);
+        out << name << "_bucket{" << bucketLabels << "le=\"" << formatNumber(bounds[i]) << "\"} " << juce::String(cumulative) << "\n";
+    }
+
+    cumulative += buckets[numBounds].load(std::memory_order_relaxed);
+
+    out << name << "_bucket{" << bucketLabels << "le=\"+Inf\"} " << juce::String(cumulative) << "\n"
+        << name << "_sum" << ownLabels << " " << formatNumber(getSum()) << "\n"
+        << name << "_count" << ownLabels << " " << juce::String(cumulative) << "\n";
+}
+
+//==============================================================================
+ScanMetrics::Volume::Volume(const juce::String& volumeKey)
+    : key(volumeKey),
+      fileSeconds(createFileSecondsHistogram())
+{
+}
+
+ScanMetrics::Histogram ScanMetrics::createFileSecondsHistogram() noexcept
+{
+    return Histogram({ 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0 });
+}
+
+//==============================================================================
+ScanMetrics::ScanMetrics()
+    : fileSeconds(createFileSecondsHistogram()),
+      fileBytes({ 4096, 16384, 65536, 131072, 262144, 1048576, 4194304, 16777216, 67108864 }),
+      startTicks(juce::Time::getHighResolutionTicks())
+{
+}
+
+void ScanMetrics::addFile(const WavMetadata& metadata, juce::uint64 numBytesRead, bool fromCache, const juce::String& volumeKey)
+{
+    auto& volume = getVolume(volumeKey);
+
+    files.fetch_add(1, std::memory_order_relaxed);
+    volume.files.fetch_add(1, std::memory_order_relaxed);
+    bytesRead.fetch_add(numBytesRead, std::memory_order_relaxed);
+
+    if (fromCache)
+        cacheHits.fetch_add(1, std::memory_order_relaxed);
+
+    if (metadata.status.failed())
+    {
+        errors.fetch_add(1, std::memory_order_relaxed);
+        volume.errors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (! fromCache)
+    {
+        fileSeconds.add(metadata.timings.getTotalSeconds());
+        volume.fileSeconds.add(metadata.timings.getTotalSeconds());
+        fileBytes.add((double) numBytesRead);
+    }
+}
+
+ScanMetrics::Volume& ScanMetrics::getVolume(const juce::String& key)
+{
+    auto findIn = [this, &key](int count) -> Volume*
+        {
+            for (int i = 0; i < count; ++i)
+                if (volumes[i]->key == key)
+                    return volumes[i].get();
+
+            return nullptr;
+        };
+
+    // Nearly always there already, so look without the lock first.
+    if (auto* found = findIn(numVolumes.load(std::memory_order_acquire)))
+        return *found;
+
+    const juce::ScopedLock sl(volumeLock);
+    auto count = numVolumes.load(std::memory_order_relaxed);
+
+    if (auto* found = findIn(count))
+        return *found;
+
+    // The last slot is kept for everything past the limit.
+    auto isOverflow = count == maxVolumes - 1;
+
+    if (count == maxVolumes)
+        return *volumes[maxVolumes - 1];
+
+    volumes[count] = std::make_unique<Volume>(isOverflow ? juce::String("other") : key);
+    numVolumes.store(count + 1, std::memory_order_release);
+    return *volumes[count];
+}
+
+double ScanMetrics::getUptime() const noexcept
+{
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+}
+
+//==============================================================================
+juce::String ScanMetrics::toPrometheusText() const
+{
+    juce::String out;
+
+    auto writeValue = [&out](const char* name, const char* type, const char* help, const juce::String& value)
+        {
+            out << "# HELP " << name << " " << help << "\n"
+                << "# TYPE " << name << " " << type << "\n"
+                << name << " " << value << "\n";
+        };
+
+    writeValue("ixmlviewer_files_total", "counter", "Files parsed or answered from the cache.", juce::String(getNumFiles()));
+    writeValue("ixmlviewer_cache_hits_total", "counter", "Files answered from the cache.", juce::String(getNumCacheHits()));
+    writeValue("ixmlviewer_bytes_read_total", "counter", "Bytes read from files and objects.", juce::String(getNumBytesRead()));
+    writeValue("ixmlviewer_queue_depth", "gauge", "Files waiting to be, or being, parsed.", juce::String(getQueueDepth()));
+    writeValue("ixmlviewer_uptime_seconds", "gauge", "Seconds since the run started.", formatNumber(getUptime()));
+
+    fileBytes.writePrometheus(out, "ixmlviewer_file_bytes_read", "Bytes read for each parsed file.");
+
+    // By volume, to show which one is slow or failing; sum() over the label gives the totals.
+    auto numVolumesSeen = numVolumes.load(std::memory_order_acquire);
+
+    out << "# HELP ixmlviewer_parse_errors_total Files whose metadata couldn't be read.\n"
+        << "# TYPE ixmlviewer_parse_errors_total counter\n";
+
+    for (int i = 0; i < numVolumesSeen; ++i)
+        out << "ixmlviewer_parse_errors_total{volume=\"" << escapeLabel(volumes[i]->key) << "\"} "
+            << juce::String(volumes[i]->errors.load(std::memory_order_relaxed)) << "\n";
+
+    out << "# HELP ixmlviewer_file_seconds Time spent on each parsed file, across every stage.\n"
+        << "# TYPE ixmlviewer_file_seconds histogram\n";
+
+    for (int i = 0; i < numVolumesSeen; ++i)
+        volumes[i]->fileSeconds.writePrometheusSamples(out, "ixmlviewer_file_seconds",
+                                                       "volume=\"" + escapeLabel(volumes[i]->key) + "\"");
+
+    return out;
+}
+
+juce::String ScanMetrics::toJsonLine(juce::uint64 previousFiles, juce::uint64 previousBytes, double secondsSincePrevious) const
+{
+    auto numFiles = getNumFiles();
+    auto numBytes = getNumBytesRead();
+    auto perSecond = [secondsSincePrevious](juce::uint64 delta)
+        {
+            return secondsSincePrevious > 0.0 ? (double) delta / secondsSincePrevious : 0.0;
+        };
+
+    auto parsed = numFiles - getNumCacheHits();
+
+    // Only the volume names need escaping; the rest are numbers.
+    juce::String volumeList;
+    auto numVolumesSeen = numVolumes.load(std::memory_order_acquire);
+
+    for (int i = 0; i < numVolumesSeen; ++i)
+    {
+        const auto& volume = *volumes[i];
+
+        volumeList << (i > 0 ? "," : "")
+                   << "{\"volume\":" << quoteJson(volume.key)
+                   << ",\"files\":" << juce::String(volume.files.load(std::memory_order_relaxed))
+                   << ",\"errors\":" << juce::String(volume.errors.load(std::memory_order_relaxed))
+                   << ",\"file_ms_p50\":" << quantileMs(volume.fileSeconds, 0.5)
+                   << ",\"file_ms_p95\":" << quantileMs(volume.fileSeconds, 0.95)
+                   << "}";
+    }
+
+    juce::String line;
+    line << "{\"time\":\"" << juce::Time::getCurrentTime().toISO8601(true) << "\""
+         << ",\"uptime_s\":" << juce::String(getUptime(), 1)
+         << ",\"files\":" << juce::String(numFiles)
+         << ",\"files_per_s\":" << juce::String(perSecond(numFiles - previousFiles), 1)
+         << ",\"bytes_read\":" << juce::String(numBytes)
+         << ",\"bytes_read_per_s\":" << juce::String((juce::int64) perSecond(numBytes - previousBytes))
+         << ",\"bytes_per_parsed_file\":" << juce::String(parsed > 0 ? numBytes / parsed : (juce::uint64) 0)
+         << ",\"cache_hits\":" << juce::String(getNumCacheHits())
+         << ",\"cache_hit_ratio\":" << juce::String(numFiles > 0 ? (double) getNumCacheHits() / (double) numFiles : 0.0, 3)
+         << ",\"errors\":" << juce::String(getNumErrors())
+         << ",\"queue_depth\":" << juce::String(getQueueDepth())
+         << ",\"file_ms_p50\":" << quantileMs(fileSeconds, 0.5)
+         << ",\"file_ms_p95\":" << quantileMs(fileSeconds, 0.95)
+         << ",\"volumes\":[" << volumeList << "]"
+         << "}";
+
+    return line;
+}
@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    ScanMetrics.h
+
+    Counters and histograms describing a batch, remote or watch run: how many
+    files have been parsed, how many came from the cache or failed, how much
+    was read for each and how long each took, and how many are queued. Only
+    depends on juce_core.
+
+    The time per file and the errors are also kept for each volume (a
+    drive, share or mount, or a server for URLs), so a slow or failing one
+    stands out rather than disappearing into the overall figures.
+
+    Everything is updated with atomics, so the workers record their files
+    without taking a lock or waiting on whoever is reading the figures. The
+    only lock is taken the first time a volume is seen. A reader may see one
+    file's counters a moment before its histograms, which doesn't matter for
+    monitoring.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WavMetadata.h"
+
+//==============================================================================
+class ScanMetrics
+{
+public:
+    //==============================================================================
+    /* Counts values into fixed buckets, as Prometheus histograms do. */
+    class Histogram
+    {
+    public:
+        static constexpr int maxBuckets = 16;
+
+        /* The upper bound of each bucket, in increasing order. Values above
+           the last one go in an overflow bucket. */
+        explicit Histogram(std::initializer_list<double> upperBounds) noexcept;
+
+        void add(double value) noexcept;
+
+        juce::uint64 getCount() const noexcept      { return count.load(std::memory_order_relaxed); }
+        double getSum() const noexcept              { return sum.load(std::memory_order_relaxed); }
+
+        /* An estimate of the given quantile (e.g. 0.95): the upper bound of
+           the bucket it falls in. Zero if nothing has been added. */
+        double getQuantile(double quantile) const noexcept;
+
+        /* Appends the histogram in the Prometheus text format. */
+        void writePrometheus(juce::String& out, const juce::String& name, const juce::String& help) const;
+
+        /* Appends just the samples, without the HELP and TYPE lines, each
+           with the given labels (e.g. volume="/mnt/nas") ahead of its own. */
+        void writePrometheusSamples(juce::String& out, const juce::String& name, const juce::String& labels) const;
+
+    private:
+        double bounds[maxBuckets] = {};
+        int numBounds = 0;
+
+        // One more than there are bounds, for the overflow bucket.
+        std::atomic<juce::uint64> buckets[maxBuckets + 1] = {};
+        std::atomic<juce::uint64> count { 0 };
+        std::atomic<double> sum { 0.0 };
+    };
+
+    //==============================================================================
+    ScanMetrics();
+
+    /* Records a file as it's reported, against the volume it's on (see
+       BatchEditor::getVolumeKey()). Cancelled reads aren't counted. Only
+       files that were actually parsed go into the histograms, as a cache hit
+       costs next to nothing and would drag the quantiles towards zero. */
+    void addFile(const WavMetadata& metadata, juce::uint64 bytesRead, bool fromCache, const juce::String& volume);
+
+    /* How many files are waiting to be, or being, parsed. */
+    void setQueueDepth(int depth) noexcept  { queueDepth.store(depth, std::memory_order_relaxed); }
+
+    //==============================================================================
+    juce::uint64 getNumFiles() const noexcept       { return files.load(std::memory_order_relaxed); }
+    juce::uint64 getNumCacheHits() const noexcept   { return cacheHits.load(std::memory_order_relaxed); }
+    juce::uint64 getNumErrors() const noexcept      { return errors.load(std::memory_order_relaxed); }
+    juce::uint64 getNumBytesRead() const noexcept   { return bytesRead.load(std::memory_order_relaxed); }
+    int getQueueDepth() const noexcept              { return queueDepth.load(std::memory_order_relaxed); }
+
+    /* Seconds since the metrics were created. */
+    double getUptime() const noexcept;
+
+    //==============================================================================
+    /* Every metric in the Prometheus text exposition format. */
+    juce::String toPrometheusText() const;
+
+    /* One line of JSON with the totals so far and, given the totals from the
+       previous line, the rates since then. */
+    juce::String toJsonLine(juce::uint64 previousFiles, juce::uint64 previousBytes, double secondsSincePrevious) const;
+
+private:
+    //==============================================================================
+    struct Volume
+    {
+        explicit Volume(const juce::String& key);
+
+        juce::String key;
+        std::atomic<juce::uint64> files { 0 }, errors { 0 };
+        Histogram fileSeconds;
+    };
+
+    // Past this many, the rest share one entry, so a run over something
+    // unexpected can't grow the output without limit.
+    static constexpr int maxVolumes = 32;
+
+    Volume& getVolume(const juce::String& key);
+
+    static Histogram createFileSecondsHistogram() noexcept;
+
+    //==============================================================================
+    std::atomic<juce::uint64> files { 0 }, cacheHits { 0 }, errors { 0 }, bytesRead { 0 };
+    std::atomic<int> queueDepth { 0 };
+
+    // Time per parsed file across every stage, in seconds, and bytes read per parsed file.
+    Histogram fileSeconds, fileBytes;
+
+    // Added to but never removed from, and only published once complete, so
+    // they can be read without the lock.
+    std::unique_ptr<Volume> volumes[maxVolumes];
+    std::atomic<int> numVolumes { 0 };
+    juce::CriticalSection volumeLock;
+
+    juce::int64 startTicks;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScanMetrics)
+};
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    TimingsBar.cpp
+
+  ==============================================================================
+*/
+
+#include "TimingsBar.h"
+
+//==============================================================================
+void TimingsBar::setTimings(const ParseTimings& newTimings)
+{
+    timings = newTimings;
+    hasTimings = true;
+    repaint();
+}
+
+void TimingsBar::clearTimings()
+{
+    hasTimings = false;
+    repaint();
+}
+
+int TimingsBar::getPreferredHeight() const noexcept
+{
+    return expanded ? lineHeight * (1 + ParseTimings::numStages) : lineHeight;
+}
+
+//==============================================================================
+void TimingsBar::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::darkgrey.darker().darker());
+
+    auto area = getLocalBounds().reduced(4, 0);
+    auto firstLine = area.removeFromTop(lineHeight);
+
+    // A triangle pointing right when collapsed and down when expanded.
+    auto arrowArea = firstLine.removeFromLeft(lineHeight).toFloat().reduced(6.0f);
+    juce::Path arrow;
+
+    if (expanded)
+        arrow.addTriangle(arrowArea.getTopLeft(), arrowArea.getTopRight(), { arrowArea.getCentreX(), arrowArea.getBottom() });
+    else
+        arrow.addTriangle(arrowArea.getTopLeft(), arrowArea.getBottomLeft(), { arrowArea.getRight(), arrowArea.getCentreY() });
+
+    g.setColour(juce::Colours::lightgoldenrodyellow.withAlpha(0.6f));
+    g.fillPath(arrow);
+
+    g.setColour(juce::Colours::lightgoldenrodyellow);
+    g.setFont(juce::Font(juce::FontOptions(13.0f)));
+
+    if (! hasTimings)
+    {
+        g.drawText("No timings yet", firstLine, juce::Justification::centredLeft, true);
+        return;
+    }
+
+    auto total = timings.getTotalSeconds();
+    juce::String summary = "Opened in " + juce::String(total * 1000.0, 2) + " ms";
+
+    if (! expanded)
+        summary << " (" << timings.toString() << ")";
+
+    g.drawText(summary, firstLine, juce::Justification::centredLeft, true);
+
+    if (! expanded)
+        return;
+
+    for (int i = 0; i < ParseTimings::numStages; ++i)
+    {
+        auto stage = (ParseTimings::Stage) i;
+        auto seconds = timings.getSeconds(stage);
+        auto line = area.removeFromTop(lineHeight).withTrimmedLeft(lineHeight);
+
+        auto nameArea = line.removeFromLeft(120);
+        auto valueArea = line.removeFromRight(80);
+        auto barArea = line.reduced(4, 5).toFloat();
+
+        g.setColour(juce::Colours::lightgoldenrodyellow);
+        g.drawText(ParseTimings::getStageName(stage), nameArea, juce::Justification::centredLeft, true);
+        g.drawText(juce::String(seconds * 1000.0, 2) + " ms", valueArea, juce::Justification::centredRight, true);
+
+        g.setColour(juce::Colours::lightgoldenrodyellow.withAlpha(0.15f));
+        g.fillRect(barArea);
+
+        if (total > 0.0)
+        {
+            g.setColour(juce::Colours::lightgoldenrodyellow.withAlpha(0.6f));
+            g.fillRect(barArea.withWidth(barArea.getWidth() * (float) (seconds / total)));
+        }
+    }
+}
+
+void TimingsBar::mouseUp(const juce::MouseEvent&)
+{
+    expanded = ! expanded;
+    repaint();
+
+    if (onExpandedChanged != nullptr)
+        onExpandedChanged();
+}
@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    TimingsBar.h
+
+    A status bar showing how long the shown file took to open. Collapsed it's
+    a single line with the total; clicking it expands a per-stage breakdown,
+    so slow storage can be told apart from slow parsing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParseTimings.h"
+
+//==============================================================================
+class TimingsBar : public juce::Component
+{
+public:
+    //==============================================================================
+    TimingsBar() = default;
+
+    void setTimings(const ParseTimings& newTimings);
+    void clearTimings();
+
+    /* The height the bar wants, which depends on whether it's expanded. */
+    int getPreferredHeight() const noexcept;
+
+    /* Called when a click expands or collapses the bar, so the parent can lay out again. */
+    std::function<void()> onExpandedChanged;
+
+    //==============================================================================
+    void paint(juce::Graphics& g) override;
+    void mouseUp(const juce::MouseEvent& event) override;
+
+private:
+    //==============================================================================
+    static constexpr int lineHeight = 20;
+
+    ParseTimings timings;
+    bool hasTimings = false;
+    bool expanded = false;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TimingsBar)
+};
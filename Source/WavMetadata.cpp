@@ -0,0 +1,263 @@
+/*
+  ==============================================================================
+
+    WavMetadata.cpp
+
+  ==============================================================================
+*/
+
+#include "WavMetadata.h"
+
+//==============================================================================
+namespace
+{
+    constexpr int endMarker = 0x584d4c45;
+}
+
+//==============================================================================
+juce::String WavMetadata::Broadcast::getUmidAsHex() const
+{
+    return juce::String::toHexString(umid, umidSize, 0).toUpperCase();
+}
+
+juce::String WavMetadata::Info::getFieldName(const juce::String& id)
+{
+    static const std::pair<const char*, const char*> names[] =
+    {
+        { "IARL", "Archival Location" },
+        { "IART", "Artist" },
+        { "ICMS", "Commissioned" },
+        { "ICMT", "Comment" },
+        { "ICOP", "Copyright" },
+        { "ICRD", "Creation Date" },
+        { "IENG", "Engineer" },
+        { "IGNR", "Genre" },
+        { "IKEY", "Keywords" },
+        { "IMED", "Medium" },
+        { "INAM", "Title" },
+        { "IPRD", "Product" },
+        { "ISBJ", "Subject" },
+        { "ISFT", "Software" },
+        { "ISRC", "Source" },
+        { "ISRF", "Source Form" },
+        { "ITCH", "Technician" },
+        { "ITRK", "Track Number" }
+    };
+
+    for (const auto& [fieldId, name] : names)
+        if (id == fieldId)
+            return name;
+
+    return {};
+}
+
+//==============================================================================
+void WavMetadata::writeTo(juce::OutputStream& out) const
+{
+    out.writeBool(status.wasOk());
+    out.writeString(status.getErrorMessage());
+
+    out.writeBool(format.found);
+    out.writeInt(format.audioFormat);
+    out.writeInt(format.numChannels);
+    out.writeInt(format.sampleRate);
+    out.writeInt(format.bitsPerSample);
+    out.writeInt(format.subFormat);
+
+    out.writeBool(bext.found);
+    out.writeString(bext.description);
+    out.writeString(bext.originator);
+    out.writeString(bext.originatorReference);
+    out.writeString(bext.originationDate);
+    out.writeString(bext.originationTime);
+    out.writeInt64(bext.timeReference);
+    out.writeInt(bext.version);
+    out.writeInt(bext.umidSize);
+    out.write(bext.umid, (size_t) bext.umidSize);
+    out.writeFloat(bext.loudnessValue);
+    out.writeFloat(bext.loudnessRange);
+    out.writeFloat(bext.maxTruePeakLevel);
+    out.writeFloat(bext.maxMomentaryLoudness);
+    out.writeFloat(bext.maxShortTermLoudness);
+
+    out.writeBool(ixml.found);
+    out.writeString(ixml.text);
+    out.writeString(ixml.project);
+    out.writeString(ixml.scene);
+    out.writeString(ixml.take);
+    out.writeString(ixml.tape);
+    out.writeInt(ixml.tracks.size());
+
+    for (const auto& track : ixml.tracks)
+    {
+        out.writeString(track.channelIndex);
+        out.writeString(track.interleaveIndex);
+        out.writeString(track.name);
+        out.writeString(track.function);
+    }
+
+    out.writeBool(adm.found);
+    out.writeString(adm.text);
+
+    out.writeBool(chna.found);
+    out.writeInt(chna.numTracks);
+    out.writeInt(chna.tracks.size());
+
+    for (const auto& track : chna.tracks)
+    {
+        out.writeInt(track.trackIndex);
+        out.writeString(track.uid);
+        out.writeString(track.trackReference);
+        out.writeString(track.packReference);
+    }
+
+    out.writeBool(xmp.found);
+    out.writeString(xmp.text);
+
+    out.writeBool(info.found);
+    out.writeInt(info.fields.size());
+
+    for (const auto& field : info.fields)
+    {
+        out.writeString(field.id);
+        out.writeString(field.value);
+    }
+
+    out.writeInt(chunks.size());
+
+    for (const auto& chunk : chunks)
+    {
+        out.writeString(chunk.id);
+        out.writeInt64(chunk.offset);
+        out.writeInt64((juce::int64) chunk.size);
+    }
+
+    out.writeInt(endMarker);
+}
+
+bool WavMetadata::readFrom(juce::InputStream& in)
+{
+    // Guards against allocating huge arrays from a corrupt count.
+    constexpr int maxListSize = 1 << 20;
+
+    auto wasOk = in.readBool();
+    auto errorMessage = in.readString();
+    status = wasOk ? juce::Result::ok() : juce::Result::fail(errorMessage);
+    cancelled = false;
+
+    format.found = in.readBool();
+    format.audioFormat = in.readInt();
+    format.numChannels = in.readInt();
+    format.sampleRate = in.readInt();
+    format.bitsPerSample = in.readInt();
+    format.subFormat = in.readInt();
+
+    bext.found = in.readBool();
+    bext.description = in.readString();
+    bext.originator = in.readString();
+    bext.originatorReference = in.readString();
+    bext.originationDate = in.readString();
+    bext.originationTime = in.readString();
+    bext.timeReference = in.readInt64();
+    bext.version = in.readInt();
+    bext.umidSize = in.readInt();
+
+    if (bext.umidSize < 0 || bext.umidSize > (int) sizeof(bext.umid)
+         || in.read(bext.umid, (size_t) bext.umidSize) != bext.umidSize)
+        return false;
+
+    bext.loudnessValue = in.readFloat();
+    bext.loudnessRange = in.readFloat();
+    bext.maxTruePeakLevel = in.readFloat();
+    bext.maxMomentaryLoudness = in.readFloat();
+    bext.maxShortTermLoudness = in.readFloat();
+
+    ixml.found = in.readBool();
+    ixml.text = in.readString();
+    ixml.project = in.readString();
+    ixml.scene = in.readString();
+    ixml.take = in.readString();
+    ixml.tape = in.readString();
+
+    auto numTracks = in.readInt();
+
+    if (numTracks < 0 || numTracks > maxListSize)
+        return false;
+
+    ixml.tracks.clearQuick();
+    ixml.tracks.ensureStorageAllocated(numTracks);
+
+    for (int i = 0; i < numTracks; ++i)
+    {
+        IxmlTrack track;
+        track.channelIndex = in.readString();
+        track.interleaveIndex = in.readString();
+        track.name = in.readString();
+        track.function = in.readString();
+        ixml.tracks.add(track);
+    }
+
+    adm.found = in.readBool();
+    adm.text = in.readString();
+
+    chna.found = in.readBool();
+    chna.numTracks = in.readInt();
+    auto numChnaTracks = in.readInt();
+
+    if (numChnaTracks < 0 || numChnaTracks > maxListSize)
+        return false;
+
+    chna.tracks.clearQuick();
+    chna.tracks.ensureStorageAllocated(numChnaTracks);
+
+    for (int i = 0; i < numChnaTracks; ++i)
+    {
+        ChnaTrack track;
+        track.trackIndex = in.readInt();
+        track.uid = in.readString();
+        track.trackReference = in.readString();
+        track.packReference = in.readString();
+        chna.tracks.add(track);
+    }
+
+    xmp.found = in.readBool();
+    xmp.text = in.readString();
+
+    info.found = in.readBool();
+    auto numInfoFields = in.readInt();
+
+    if (numInfoFields < 0 || numInfoFields > maxListSize)
+        return false;
+
+    info.fields.clearQuick();
+    info.fields.ensureStorageAllocated(numInfoFields);
+
+    for (int i = 0; i < numInfoFields; ++i)
+    {
+        InfoField field;
+        field.id = in.readString();
+        field.value = in.readString();
+        info.fields.add(field);
+    }
+
+    auto numChunks = in.readInt();
+
+    if (numChunks < 0 || numChunks > maxListSize)
+        return false;
+
+    chunks.clearQuick();
+    chunks.ensureStorageAllocated(numChunks);
+
+    for (int i = 0; i < numChunks; ++i)
+    {
+        ChunkInfo chunk;
+        chunk.id = in.readString();
+        chunk.offset = in.readInt64();
+        chunk.size = (juce::uint64) in.readInt64();
+        chunks.add(chunk);
+    }
+
+    // Streams return zeros once they run out, so a missing marker means the
+    // object was cut short.
+    return in.readInt() == endMarker;
+}
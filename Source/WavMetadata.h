@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    WavMetadata.h
+
+    Plain structured result of reading the metadata chunks of a WAV file.
+    It has no GUI dependencies so it can be produced and consumed anywhere.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParseTimings.h"
+
+//==============================================================================
+struct WavMetadata
+{
+    //==============================================================================
+    /* The fields we decode from the "fmt " chunk. */
+    struct Format
+    {
+        static constexpr int pcm = 1, ieeeFloat = 3, extensible = 0xfffe;
+
+        bool found = false;
+        int audioFormat = 0;
+        int numChannels = 0;
+        int sampleRate = 0;
+        int bitsPerSample = 0;
+
+        // For an extensible format, the format code its SubFormat GUID
+        // carries, e.g. pcm or ieeeFloat. Zero otherwise, or if the GUID
+        // isn't one of the standard ones.
+        int subFormat = 0;
+
+        /* What the samples are actually stored as. */
+        int getSampleFormat() const noexcept    { return audioFormat == extensible ? subFormat : audioFormat; }
+    };
+
+    /* The fixed BWF fields from the "bext" chunk. */
+    struct Broadcast
+    {
+        bool found = false;
+        juce::String description;
+        juce::String originator;
+        juce::String originatorReference;
+        juce::String originationDate;
+        juce::String originationTime;
+        juce::int64 timeReference = 0;     // Samples since midnight.
+
+        int version = 0;
+
+        // Version 1 and later. umidSize is 64 (extended), 32 (basic) or 0 (none).
+        juce::uint8 umid[64] = {};
+        int umidSize = 0;
+
+        // Version 2 and later, in LUFS, LU or dBTP. NaN when not measured.
+        float loudnessValue = std::numeric_limits<float>::quiet_NaN();
+        float loudnessRange = std::numeric_limits<float>::quiet_NaN();
+        float maxTruePeakLevel = std::numeric_limits<float>::quiet_NaN();
+        float maxMomentaryLoudness = std::numeric_limits<float>::quiet_NaN();
+        float maxShortTermLoudness = std::numeric_limits<float>::quiet_NaN();
+
+        /* The UMID as a hex string, or an empty string if there isn't one. */
+        juce::String getUmidAsHex() const;
+    };
+
+    /* One entry of the iXML TRACK_LIST. */
+    struct IxmlTrack
+    {
+        juce::String channelIndex;
+        juce::String interleaveIndex;
+        juce::String name;
+        juce::String function;
+    };
+
+    /* The "iXML" chunk, pretty-printed if it parsed as XML, plus the
+       production fields most tools look for. */
+    struct Ixml
+    {
+        bool found = false;
+        juce::String text;
+
+        juce::String project;
+        juce::String scene;
+        juce::String take;
+        juce::String tape;
+        juce::Array<IxmlTrack> tracks;
+    };
+
+    /* An XML chunk other than iXML: "axml" (ADM, for object-based audio) or
+       "_PMX" (XMP). Pretty-printed if it parsed as XML. */
+    struct XmlChunk
+    {
+        bool found = false;
+        juce::String text;
+    };
+
+    /* One entry of the "chna" chunk: which ADM track a track of the file carries. */
+    struct ChnaTrack
+    {
+        int trackIndex = 0;                // 1-based.
+        juce::String uid;                  // ATU_xxxxxxxx
+        juce::String trackReference;       // AT_xxxxxxxx_xx, or a channel format ID
+        juce::String packReference;        // AP_xxxxxxxx
+    };
+
+    /* The "chna" chunk, which ties the file's tracks to the ADM in "axml". */
+    struct Chna
+    {
+        bool found = false;
+        int numTracks = 0;
+        juce::Array<ChnaTrack> tracks;
+    };
+
+    /* One text field of a "LIST" chunk of type "INFO", e.g. INAM (title). */
+    struct InfoField
+    {
+        juce::String id;
+        juce::String value;
+    };
+
+    /* The RIFF INFO list. */
+    struct Info
+    {
+        bool found = false;
+        juce::Array<InfoField> fields;
+
+        /* The standard name of a field, e.g. "Title" for INAM, or an empty string. */
+        static juce::String getFieldName(const juce::String& id);
+    };
+
+    /* One entry of the file's chunk table. */
+    struct ChunkInfo
+    {
+        juce::String id;
+        juce::int64 offset = 0;            // File offset of the chunk header.
+        juce::uint64 size = 0;             // Payload size, with RF64 sizes taken from ds64.
+    };
+
+    //==============================================================================
+    /* Writes everything in this object to a stream, in a compact binary form
+       that readFrom() understands. */
+    void writeTo(juce::OutputStream& out) const;
+
+    /* Restores an object written by writeTo(). Returns false if the data
+       is truncated or doesn't look like something writeTo() produced. */
+    bool readFrom(juce::InputStream& in);
+
+    //==============================================================================
+    /* Whether the file could be read as a RIFF/WAVE file at all. If not, the
+       error message says why and the remaining fields are whatever was found
+       before the problem was hit. */
+    juce::Result status = juce::Result::ok();
+
+    /* Set when the caller's cancel callback stopped the read early. */
+    bool cancelled = false;
+
+    Format format;
+    Broadcast bext;
+    Ixml ixml;
+    XmlChunk adm;
+    Chna chna;
+    XmlChunk xmp;
+    Info info;
+
+    /* The chunk table, up to the last chunk that had to be looked at. */
+    juce::Array<ChunkInfo> chunks;
+
+    /* How long each stage of producing this result took. Describes this
+       particular read, so it isn't written by writeTo(). */
+    ParseTimings timings;
+};
@@ -0,0 +1,478 @@
+/*
+  ==============================================================================
+
+    WavMetadataReader.cpp
+
+  ==============================================================================
+*/
+
+#include "WavMetadataReader.h"
+#include "RiffChunkScanner.h"
+#include "IxmlStreamParser.h"
+#include "XmlTextScanner.h"
+#include "BextChunk.h"
+
+namespace
+{
+    //==============================================================================
+    void readFormat(const char* data, juce::uint64 size, WavMetadata::Format& format)
+    {
+        if (data == nullptr || size < 16)
+            return;
+
+        // All WAV fields are little-endian.
+        // Byte Rate (4 bytes) and Block Align (2 bytes) are not needed.
+        format.found = true;
+        format.audioFormat = (short) juce::ByteOrder::littleEndianShort(data);
+        format.numChannels = (short) juce::ByteOrder::littleEndianShort(data + 2);
+        format.sampleRate = (int) juce::ByteOrder::littleEndianInt(data + 4);
+        format.bitsPerSample = (short) juce::ByteOrder::littleEndianShort(data + 14);
+        format.subFormat = 0;
+
+        // WAVE_FORMAT_EXTENSIBLE puts the real format in a SubFormat GUID at
+        // offset 24. The standard ones are the format code followed by the
+        // same twelve bytes.
+        static constexpr juce::uint8 standardGuidTail[] = { 0x00, 0x00, 0x10, 0x00, 0x80, 0x00,
+                                                            0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 };
+
+        if (format.audioFormat == WavMetadata::Format::extensible && size >= 40
+             && juce::ByteOrder::littleEndianShort(data + 16) >= 22
+             && std::memcmp(data + 28, standardGuidTail, sizeof(standardGuidTail)) == 0)
+        {
+            auto code = juce::ByteOrder::littleEndianInt(data + 24);
+
+            if (code <= 0xffff)
+                format.subFormat = (int) code;
+        }
+    }
+
+    /* Fills in a String only when the field has any text, so empty fields cost nothing. */
+    void assignText(juce::String& target, std::string_view text)
+    {
+        if (text.empty())
+            target.clear();
+        else
+            target = juce::String::fromUTF8(text.data(), (int) text.size());
+    }
+
+    void readBroadcast(const char* data, juce::uint64 size, WavMetadata::Broadcast& bext)
+    {
+        // One copy of the fixed 602 bytes; every field below is decoded in place.
+        BextChunk chunk(data, size);
+
+        if (! chunk.isValidChunk())
+            return;
+
+        bext.found = true;
+        assignText(bext.description, chunk.getDescription());
+        assignText(bext.originator, chunk.getOriginator());
+        assignText(bext.originatorReference, chunk.getOriginatorReference());
+        assignText(bext.originationDate, chunk.getOriginationDate());
+        assignText(bext.originationTime, chunk.getOriginationTime());
+        bext.timeReference = chunk.getTimeReference();
+        bext.version = chunk.getVersion();
+
+        bext.umidSize = chunk.getUmidSize();
+        std::memcpy(bext.umid, chunk.getUmid(), sizeof(bext.umid));
+
+        bext.loudnessValue = chunk.getLoudnessValue();
+        bext.loudnessRange = chunk.getLoudnessRange();
+        bext.maxTruePeakLevel = chunk.getMaxTruePeakLevel();
+        bext.maxMomentaryLoudness = chunk.getMaxMomentaryLoudness();
+        bext.maxShortTermLoudness = chunk.getMaxShortTermLoudness();
+    }
+
+    /* Some older recorders write iXML in an 8-bit code page rather than
+       UTF-8. Taking the bytes as Latin-1 keeps their text readable. */
+    juce::String fromLatin1(const char* data, size_t size)
+    {
+        juce::HeapBlock<juce::juce_wchar> characters(size + 1);
+
+        for (size_t i = 0; i < size; ++i)
+            characters[i] = (juce::juce_wchar) (unsigned char) data[i];
+
+        characters[size] = 0;
+        return juce::String(juce::CharPointer_UTF32(characters.get()));
+    }
+
+    /* Text that should be UTF-8 but may not be. */
+    juce::String toText(const char* data, size_t size)
+    {
+        if (XmlTextScanner::isValidUtf8(data, size))
+            return juce::String::fromUTF8(data, (int) size);
+
+        return fromLatin1(data, size);
+    }
+
+    /* A fixed-size or null-terminated text field, without its trailing nulls and spaces. */
+    juce::String fieldText(const char* data, size_t maxSize)
+    {
+        auto* firstNull = static_cast<const char*>(std::memchr(data, 0, maxSize));
+        auto size = firstNull != nullptr ? (size_t) (firstNull - data) : maxSize;
+
+        while (size > 0 && data[size - 1] == ' ')
+            --size;
+
+        return toText(data, size);
+    }
+
+    size_t getTextSize(juce::uint64 size) noexcept
+    {
+        return (size_t) juce::jmin(size, (juce::uint64) std::numeric_limits<int>::max());
+    }
+
+    void readIxml(const char* data, juce::uint64 size, WavMetadata::Ixml& ixml, ParseArena* scratch = nullptr)
+    {
+        ixml.found = true;
+
+        if (data == nullptr)
+            return;
+
+        auto textSize = getTextSize(size);
+
+        // The iXML spec says the payload is UTF-8 XML. Tokenize it straight
+        // out of the source's buffer to pretty-print it and pick out the key
+        // fields, and if it isn't well-formed just keep the raw text.
+        if (! IxmlStreamParser::parse(data, textSize, ixml, scratch))
+            ixml.text = toText(data, textSize);
+    }
+
+    void readXmlChunk(const char* data, juce::uint64 size, WavMetadata::XmlChunk& xml, ParseArena* scratch)
+    {
+        xml.found = true;
+
+        if (data == nullptr)
+            return;
+
+        auto textSize = getTextSize(size);
+
+        if (! IxmlStreamParser::prettyPrint(data, textSize, xml.text, scratch))
+            xml.text = toText(data, textSize);
+    }
+
+    void readChna(const char* data, juce::uint64 size, WavMetadata::Chna& chna)
+    {
+        // numTracks (2), numUIDs (2), then that many 40-byte entries.
+        if (data == nullptr || size < 4)
+            return;
+
+        constexpr juce::uint64 entrySize = 40;
+
+        chna.found = true;
+        chna.numTracks = (int) juce::ByteOrder::littleEndianShort(data);
+
+        auto numEntries = juce::jmin((juce::uint64) juce::ByteOrder::littleEndianShort(data + 2), (size - 4) / entrySize);
+
+        for (juce::uint64 i = 0; i < numEntries; ++i)
+        {
+            // trackIndex (2), UID (12), trackRef (14), packRef (11), padding (1).
+            auto* entry = data + 4 + i * entrySize;
+            auto trackIndex = (int) juce::ByteOrder::littleEndianShort(entry);
+
+            // Writers reserve room for more entries than they fill, leaving
+            // the rest with a track index of 0.
+            if (trackIndex == 0)
+                continue;
+
+            chna.tracks.add({ trackIndex, fieldText(entry + 2, 12), fieldText(entry + 14, 14), fieldText(entry + 28, 11) });
+        }
+    }
+
+    void readInfoList(const char* data, juce::uint64 size, WavMetadata::Info& info)
+    {
+        // Other lists, e.g. the cue labels of "adtl", are left to other tools.
+        if (data == nullptr || size < 4 || FourCC::read(data) != FourCC::info)
+            return;
+
+        info = {};
+        info.found = true;
+
+        // After the list type come sub-chunks of id (4), size (4) and text.
+        for (juce::uint64 position = 4; size - position >= 8;)
+        {
+            auto* field = data + position;
+            auto fieldSize = (juce::uint64) juce::ByteOrder::littleEndianInt(field + 4);
+            auto value = fieldText(field + 8, getTextSize(juce::jmin(fieldSize, size - position - 8)));
+
+            if (value.isNotEmpty())
+                info.fields.add({ FourCC::idToString(field), value.replaceCharacters("\r\n", "  ") });
+
+            position += 8 + fieldSize + (fieldSize & 1);
+
+            if (position > size)
+                break;
+        }
+    }
+
+    //==============================================================================
+    /* Decodes a chunk's payload into its part of the result, replacing what
+       was there. The payload may be null if it couldn't be read. */
+    using ChunkDecoder = void (*)(const char* data, juce::uint64 size, WavMetadata& metadata, ParseArena* scratch);
+
+    /* One chunk type we read. The registry is a constexpr table keyed on the
+       chunk's tag, so dispatch is an integer compare per entry with nothing
+       allocated; adding a type adds an entry and nothing else. */
+    struct ChunkHandler
+    {
+        juce::uint32 tag;
+        ParseTimings::Stage stage;
+
+        // Decode every chunk with this tag rather than just the first, for
+        // ids like LIST that are shared by different kinds of chunk.
+        bool everyChunk;
+
+        ChunkDecoder decode;
+    };
+
+    // In the order they're decoded. Each one is looked up in the chunk
+    // table, which is indexed in full before any of them runs.
+    constexpr ChunkHandler chunkHandlers[] =
+    {
+        { FourCC::fmt,  ParseTimings::decode,    false,
+          [](const char* data, juce::uint64 size, WavMetadata& metadata, ParseArena*)
+              {
+                  metadata.format = {};
+                  readFormat(data, size, metadata.format);
+              } },
+
+        { FourCC::bext, ParseTimings::decode,    false,
+          [](const char* data, juce::uint64 size, WavMetadata& metadata, ParseArena*)
+              {
+                  metadata.bext = {};
+                  readBroadcast(data, size, metadata.bext);
+              } },
+
+        { FourCC::iXML, ParseTimings::ixmlParse, false,
+          [](const char* data, juce::uint64 size, WavMetadata& metadata, ParseArena* scratch)
+              {
+                  metadata.ixml = {};
+                  readIxml(data, size, metadata.ixml, scratch);
+              } },
+
+        { FourCC::axml, ParseTimings::decode,    false,
+          [](const char* data, juce::uint64 size, WavMetadata& metadata, ParseArena* scratch)
+              {
+                  metadata.adm = {};
+                  readXmlChunk(data, size, metadata.adm, scratch);
+              } },
+
+        { FourCC::chna, ParseTimings::decode,    false,
+          [](const char* data, juce::uint64 size, WavMetadata& metadata, ParseArena*)
+              {
+                  metadata.chna = {};
+                  readChna(data, size, metadata.chna);
+              } },
+
+        { FourCC::xmp,  ParseTimings::decode,    false,
+          [](const char* data, juce::uint64 size, WavMetadata& metadata, ParseArena* scratch)
+              {
+                  metadata.xmp = {};
+                  readXmlChunk(data, size, metadata.xmp, scratch);
+              } },
+
+        // Replaces the INFO fields only if the list is an INFO list.
+        { FourCC::list, ParseTimings::decode,    true,
+          [](const char* data, juce::uint64 size, WavMetadata& metadata, ParseArena*)
+              {
+                  readInfoList(data, size, metadata.info);
+              } },
+    };
+
+    constexpr const ChunkHandler* findHandler(juce::uint32 tag) noexcept
+    {
+        for (const auto& handler : chunkHandlers)
+            if (handler.tag == tag)
+                return &handler;
+
+        return nullptr;
+    }
+
+    /* Points a source's timings at a result for as long as it's being read. */
+    struct TimingsAttachment
+    {
+        TimingsAttachment(ByteSource& sourceToAttach, ParseTimings* timings) noexcept
+            : source(sourceToAttach)
+        {
+            source.setTimings(timings);
+        }
+
+        ~TimingsAttachment()
+        {
+            source.setTimings(nullptr);
+        }
+
+        ByteSource& source;
+    };
+}
+
+//==============================================================================
+WavMetadata WavMetadataReader::read(const juce::File& file, const std::function<bool()>& shouldCancel)
+{
+    return read(file, Strategy::tailFirst, shouldCancel);
+}
+
+WavMetadata WavMetadataReader::read(const juce::File& file, Strategy strategy, const std::function<bool()>& shouldCancel)
+{
+    // Opening the source is where most of the I/O happens, and it's done
+    // before the source can report to anyone, so it's timed from out here.
+    ParseTimings openTimings;
+    std::unique_ptr<ByteSource> source;
+
+    {
+        const ParseTimings::ScopedTimer timer(&openTimings, ParseTimings::io);
+
+        if (strategy == Strategy::mapped)
+        {
+            // Page faults on the mapping show up in the later stages instead.
+            source = std::make_unique<MappedFileSource>(file);
+        }
+        else
+        {
+            // Read the first and last few KB and walk the chunk table from there.
+            // Recorders put fmt/bext up front and either put iXML there too or append
+            // it after the data chunk, whose size takes the walk straight into the
+            // tail window, so the audio in between is never on the critical path.
+            // Only files laid out differently need more reads.
+            source = std::make_unique<WindowedFileSource>(file);
+        }
+    }
+
+    auto metadata = readFromSource(*source, shouldCancel);
+    metadata.timings.add(openTimings);
+    return metadata;
+}
+
+bool WavMetadataReader::isDecodable(juce::uint32 tag, juce::uint64 size) noexcept
+{
+    return size <= maxMetadataChunkSize && findHandler(tag) != nullptr;
+}
+
+bool WavMetadataReader::decodeChunk(juce::uint32 tag, const char* data, juce::uint64 size, WavMetadata& metadata)
+{
+    if (size > maxMetadataChunkSize)
+        return false;
+
+    if (auto* handler = findHandler(tag))
+    {
+        handler->decode(data, size, metadata, nullptr);
+        return true;
+    }
+
+    return false;
+}
+
+WavMetadata WavMetadataReader::readFromSource(ByteSource& source, const std::function<bool()>& shouldCancel,
+                                              ParseArena* scratch)
+{
+    WavMetadata metadata;
+    auto* timings = &metadata.timings;
+
+    // Reads the source makes from here on are counted as I/O in the result.
+    const TimingsAttachment attachment(source, timings);
+
+    // A WAV file is a type of RIFF container. We need to manually parse it
+    // to find the iXML chunk, as JUCE's audio format readers are focused on audio data.
+    RiffChunkScanner scanner(source);
+
+    switch (scanner.getStatus())
+    {
+        case RiffChunkScanner::Status::cannotOpen:
+            metadata.status = juce::Result::fail("Could not open file for reading.");
+            return metadata;
+
+        case RiffChunkScanner::Status::readError:
+            metadata.status = juce::Result::fail("Could not read from the file.");
+            return metadata;
+
+        case RiffChunkScanner::Status::notRiff:
+            metadata.status = juce::Result::fail("This does not appear to be a valid RIFF (WAV) file.");
+            return metadata;
+
+        case RiffChunkScanner::Status::notWave:
+            metadata.status = juce::Result::fail("This is not a WAVE file.");
+            return metadata;
+
+        case RiffChunkScanner::Status::invalidChunkSize:
+        case RiffChunkScanner::Status::tooManyChunks:
+        case RiffChunkScanner::Status::ok:
+            break;
+    }
+
+    RiffChunkScanner::Chunk chunk;
+
+    auto isCancelled = [&]
+        {
+            metadata.cancelled = shouldCancel != nullptr && shouldCancel();
+            return metadata.cancelled;
+        };
+
+    // The first chunk that was too big to read, if any.
+    juce::String oversizedChunk;
+
+    auto decode = [&](const ChunkHandler& handler)
+        {
+            if (chunk.available > maxMetadataChunkSize)
+            {
+                if (oversizedChunk.isEmpty())
+                    oversizedChunk = FourCC::idToString(chunk.id) + " chunk (" + juce::File::descriptionOfSizeInBytes((juce::int64) chunk.size) + ")";
+
+                return;
+            }
+
+            const ParseTimings::ScopedTimer timer(timings, handler.stage);
+            handler.decode(scanner.getPayload(chunk), chunk.available, metadata, scratch);
+        };
+
+    // LIST chunks can be anywhere, so the walk has to reach the end of the
+    // table whatever else is there. Do the whole walk first, in one pass,
+    // then tell the source which payloads we're going to read: one behind a
+    // network connection can then fetch them in a couple of requests rather
+    // than one per chunk. Every lookup after that is in the finished table.
+    const juce::Array<RiffChunkScanner::Chunk>* table;
+
+    {
+        const ParseTimings::ScopedTimer timer(timings, ParseTimings::chunkWalk);
+        table = &scanner.getAllChunks();
+    }
+
+    juce::Array<juce::Range<juce::uint64>> payloads;
+
+    for (const auto& each : *table)
+        if (each.available > 0 && isDecodable(each.getTag(), each.available))
+            payloads.add(juce::Range<juce::uint64>::withStartAndLength((juce::uint64) each.offset + 8, each.available));
+
+    source.prefetch(payloads);
+
+    for (const auto& handler : chunkHandlers)
+    {
+        if (&handler != chunkHandlers && isCancelled())
+            return metadata;
+
+        // The first chunk with the tag, or every one for shared ids like LIST.
+        for (const auto& each : *table)
+        {
+            if (each.hasId(handler.tag))
+            {
+                chunk = each;
+                decode(handler);
+
+                if (! handler.everyChunk)
+                    break;
+            }
+        }
+    }
+
+    for (const auto& indexed : scanner.getIndexedChunks())
+        metadata.chunks.add({ FourCC::idToString(indexed.id), indexed.offset, indexed.size });
+
+    if (scanner.getStatus() == RiffChunkScanner::Status::invalidChunkSize)
+        metadata.status = juce::Result::fail("Encountered an invalid chunk size.");
+    else if (scanner.getStatus() == RiffChunkScanner::Status::readError)
+        metadata.status = juce::Result::fail("Could not read from the file.");
+    else if (scanner.getStatus() == RiffChunkScanner::Status::tooManyChunks)
+        metadata.status = juce::Result::fail("The file has too many chunks to index.");
+    else if (oversizedChunk.isNotEmpty())
+        metadata.status = juce::Result::fail("The " + oversizedChunk + " is too large to read.");
+
+    return metadata;
+}
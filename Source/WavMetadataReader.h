@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    WavMetadataReader.h
+
+    Reads the metadata chunks of a WAV file into a WavMetadata: fmt, bext,
+    iXML, axml, chna, XMP and LIST/INFO, all in one walk of the chunk table.
+    Only depends on juce_core, so it can be used from the GUI, the command
+    line and tools alike.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WavMetadata.h"
+#include "ByteSource.h"
+
+//==============================================================================
+class WavMetadataReader
+{
+public:
+    //==============================================================================
+    /* How the reader gets at the file's bytes. */
+    enum class Strategy
+    {
+        tailFirst,      // Read the first and last few KB, and only what else the chunk walk needs.
+        mapped          // Memory-map the whole file and read the chunks in place.
+    };
+
+    //==============================================================================
+    /* Parses the given file. The optional callback is polled between chunks;
+       if it returns true the read stops and the result is marked cancelled.
+       This is safe to call from any thread. */
+    static WavMetadata read(const juce::File& file, const std::function<bool()>& shouldCancel = nullptr);
+
+    /* As above, with an explicit lookup strategy. */
+    static WavMetadata read(const juce::File& file, Strategy strategy, const std::function<bool()>& shouldCancel = nullptr);
+
+    /* Parses whatever the source holds. The source must stay alive until this
+       returns. Scratch memory comes from the arena if one is given; nothing in
+       the result refers to it. */
+    static WavMetadata readFromSource(ByteSource& source, const std::function<bool()>& shouldCancel = nullptr,
+                                      ParseArena* scratch = nullptr);
+
+    /* Decodes one chunk into the part of the result it belongs to, replacing
+       whatever was there, if it's a chunk we read (see the header). The
+       tag is the chunk's id as a FourCC (see FourCC.h). Returns false for
+       any other chunk, or one bigger than maxMetadataChunkSize. */
+    static bool decodeChunk(juce::uint32 tag, const char* data, juce::uint64 size, WavMetadata& metadata);
+
+    /* True if decodeChunk() would read a chunk with this tag and payload size,
+       so callers can check before fetching the payload. */
+    static bool isDecodable(juce::uint32 tag, juce::uint64 size) noexcept;
+
+    /* Metadata chunks bigger than this are skipped rather than read, and the
+       result marked as failed. A corrupt size could otherwise have a reader
+       allocate and parse gigabytes for one file. Real metadata chunks come to
+       a few KB, or a few MB for a large ADM document. */
+    static constexpr juce::uint64 maxMetadataChunkSize = 64 * 1024 * 1024;
+
+private:
+    //==============================================================================
+    WavMetadataReader() = delete;
+};
@@ -0,0 +1,572 @@
+/*
+  ==============================================================================
+
+    WavMetadataWriter.cpp
+
+  ==============================================================================
+*/
+
+#include "WavMetadataWriter.h"
+#include "WavMetadataReader.h"
+#include "RiffChunkScanner.h"
+#include "BextChunk.h"
+#include "IxmlStreamParser.h"
+#include "XmlTextScanner.h"
+
+namespace
+{
+    //==============================================================================
+    // Padding left after a chunk that had to move, so the next edit of it fits.
+    constexpr juce::uint64 slackSize = 1024;
+
+    constexpr juce::uint64 maxRiffSize = 0xffffffff;
+
+    juce::uint64 padded(juce::uint64 size) noexcept
+    {
+        return size + (size & 1);
+    }
+
+    bool isPadding(const RiffChunkScanner::Chunk& chunk) noexcept
+    {
+        return chunk.hasId(FourCC::junk) || chunk.hasId(FourCC::fllr) || chunk.hasId(FourCC::pad);
+    }
+
+    //==============================================================================
+    /* What we need to know about a file before changing it. It's all read up
+       front, so the file is closed again before anything is written. */
+    struct FileLayout
+    {
+        juce::Result status = juce::Result::ok();
+        bool rf64 = false;
+        juce::uint64 length = 0;
+        juce::Array<RiffChunkScanner::Chunk> chunks;
+
+        bool hasBext = false, hasIxml = false;
+        juce::MemoryBlock bextPayload, ixmlPayload;
+
+        int indexOf(juce::uint32 tag) const noexcept
+        {
+            for (int i = 0; i < chunks.size(); ++i)
+                if (chunks.getReference(i).hasId(tag))
+                    return i;
+
+            return -1;
+        }
+    };
+
+    FileLayout readLayout(const juce::File& file)
+    {
+        FileLayout layout;
+        WindowedFileSource source(file);
+        RiffChunkScanner scanner(source);
+
+        if (scanner.getStatus() != RiffChunkScanner::Status::ok)
+        {
+            layout.status = juce::Result::fail("This isn't a WAV file that can be edited.");
+            return layout;
+        }
+
+        layout.chunks = scanner.getAllChunks();
+
+        if (scanner.getStatus() != RiffChunkScanner::Status::ok)
+        {
+            layout.status = juce::Result::fail("The file's chunk table is damaged, so it can't be edited safely.");
+            return layout;
+        }
+
+        // Edits can move the end of the file, so it has to be all there.
+        for (const auto& chunk : layout.chunks)
+        {
+            if (chunk.available < chunk.size)
+            {
+                layout.status = juce::Result::fail("The file is incomplete; it may still be being recorded.");
+                return layout;
+            }
+        }
+
+        layout.rf64 = scanner.isRf64();
+        layout.length = source.getTotalLength();
+
+        auto copyPayload = [&scanner](const RiffChunkScanner::Chunk& chunk, juce::MemoryBlock& destination)
+            {
+                auto* payload = scanner.getPayload(chunk);
+
+                if (payload == nullptr)
+                    return false;
+
+                destination.replaceAll(payload, (size_t) chunk.available);
+                return true;
+            };
+
+        RiffChunkScanner::Chunk chunk;
+
+        if (scanner.findChunk(FourCC::bext, chunk))
+            layout.hasBext = copyPayload(chunk, layout.bextPayload);
+
+        if (scanner.findChunk(FourCC::iXML, chunk))
+            layout.hasIxml = copyPayload(chunk, layout.ixmlPayload);
+
+        return layout;
+    }
+
+    //==============================================================================
+    /* Works out the writes that replace one chunk, adding them to a plan and
+       keeping the layout in step, so another chunk can be planned on top. */
+    class Planner
+    {
+    public:
+        Planner(FileLayout& layoutToUpdate, WavMetadataWriter::Plan& planToFill)
+            : layout(layoutToUpdate), plan(planToFill)
+        {
+        }
+
+        juce::Result replaceChunk(juce::uint32 tag, const juce::MemoryBlock& payload)
+        {
+            if (payload.getSize() > maxRiffSize)
+                return juce::Result::fail("The new chunk is too big.");
+
+            auto newSize = padded(payload.getSize());
+            auto index = layout.indexOf(tag);
+            auto& chunks = layout.chunks;
+
+            if (index >= 0)
+            {
+                auto offset = (juce::uint64) chunks.getReference(index).offset;
+
+                // The chunk's own space, plus any padding straight after it.
+                auto room = padded(chunks.getReference(index).size);
+                auto next = index + 1;
+
+                for (; next < chunks.size() && isPadding(chunks.getReference(next)); ++next)
+                    room += 8 + padded(chunks.getReference(next).size);
+
+                if (newSize == room || newSize + 8 <= room)
+                {
+                    writeChunk(index, offset, tag, payload);
+                    chunks.removeRange(index + 1, next - index - 1);
+
+                    if (room > newSize)
+                        writePadding(index + 1, offset + 8 + newSize, room - newSize, false);
+
+                    return juce::Result::ok();
+                }
+
+                // Nothing but padding after it, so it can grow into the end of the file.
+                if (next == chunks.size())
+                {
+                    auto newLength = offset + 8 + newSize + 8 + slackSize;
+
+                    if (! canHaveLength(newLength))
+                        return juce::Result::fail("The file would be too big for a RIFF file.");
+
+                    writeChunk(index, offset, tag, payload);
+                    chunks.removeRange(index + 1, next - index - 1);
+                    writePadding(index + 1, offset + 8 + newSize, 8 + slackSize, true);
+                    setLength(newLength);
+                    return juce::Result::ok();
+                }
+            }
+
+            // Append the new chunk. Until the old one's id is changed at the
+            // end, a reader still finds the old one first, so stopping
+            // part-way through leaves the file as it was.
+            auto appendAt = padded(layout.length);
+            auto newLength = appendAt + 8 + newSize + 8 + slackSize;
+
+            if (! canHaveLength(newLength))
+                return juce::Result::fail("The file would be too big for a RIFF file.");
+
+            if (appendAt != layout.length)
+            {
+                juce::MemoryOutputStream padByte;
+                padByte.writeByte(0);
+                addBytes(layout.length, padByte);
+            }
+
+            chunks.add({});
+            writeChunk(chunks.size() - 1, appendAt, tag, payload);
+            writePadding(chunks.size(), appendAt + 8 + newSize, 8 + slackSize, true);
+            setLength(newLength);
+
+            if (index >= 0)
+            {
+                auto& old = chunks.getReference(index);
+
+                juce::MemoryOutputStream junkId;
+                junkId.writeInt((int) FourCC::junk);
+                addBytes((juce::uint64) old.offset, junkId);
+                FourCC::write(FourCC::junk, old.id);
+            }
+
+            return juce::Result::ok();
+        }
+
+    private:
+        /* Writes a chunk at the offset, and makes the given table entry describe it. */
+        void writeChunk(int tableIndex, juce::uint64 offset, juce::uint32 tag, const juce::MemoryBlock& payload)
+        {
+            juce::MemoryOutputStream bytes(8 + padded(payload.getSize()));
+            bytes.writeInt((int) tag);
+            bytes.writeInt((int) payload.getSize());
+            bytes << payload;
+
+            if ((payload.getSize() & 1) != 0)
+                bytes.writeByte(0);
+
+            addBytes(offset, bytes);
+
+            auto& chunk = layout.chunks.getReference(tableIndex);
+            FourCC::write(tag, chunk.id);
+            chunk.offset = (juce::int64) offset;
+            chunk.size = chunk.available = payload.getSize();
+        }
+
+        /* Turns numBytes (header included) at the offset into a JUNK chunk, and
+           enters it in the table at the given index. The payload is only zeroed
+           if asked, e.g. when it extends the file. */
+        void writePadding(int tableIndex, juce::uint64 offset, juce::uint64 numBytes, bool zeroPayload)
+        {
+            jassert(numBytes >= 8);
+
+            juce::MemoryOutputStream bytes;
+            bytes.writeInt((int) FourCC::junk);
+            bytes.writeInt((int) (numBytes - 8));
+
+            if (zeroPayload)
+                bytes.writeRepeatedByte(0, (size_t) (numBytes - 8));
+
+            addBytes(offset, bytes);
+
+            RiffChunkScanner::Chunk junk;
+            FourCC::write(FourCC::junk, junk.id);
+            junk.offset = (juce::int64) offset;
+            junk.size = junk.available = numBytes - 8;
+            layout.chunks.insert(tableIndex, junk);
+        }
+
+        bool canHaveLength(juce::uint64 newLength) const noexcept
+        {
+            return layout.rf64 || newLength - 8 <= maxRiffSize;
+        }
+
+        /* The RIFF size covers everything after the first 8 bytes. RF64 files
+           keep it in the ds64 chunk, which always comes first. */
+        void setLength(juce::uint64 newLength)
+        {
+            layout.length = newLength;
+            plan.newLength = newLength;
+
+            juce::MemoryOutputStream bytes;
+
+            if (layout.rf64)
+            {
+                if (layout.chunks.isEmpty() || ! layout.chunks.getReference(0).hasId(FourCC::ds64))
+                    return;
+
+                bytes.writeInt64((juce::int64) (newLength - 8));
+                addBytes((juce::uint64) layout.chunks.getReference(0).offset + 8, bytes);
+                return;
+            }
+
+            bytes.writeInt((int) (juce::uint32) (newLength - 8));
+            addBytes(4, bytes);
+        }
+
+        void addBytes(juce::uint64 offset, const juce::MemoryOutputStream& bytes)
+        {
+            WavMetadataWriter::Plan::Write write;
+            write.offset = offset;
+            write.data = bytes.getMemoryBlock();
+            plan.writes.add(std::move(write));
+        }
+
+        FileLayout& layout;
+        WavMetadataWriter::Plan& plan;
+    };
+
+    //==============================================================================
+    /* Copies text into a fixed-size bext field, null-padded, without
+       splitting a UTF-8 sequence at the end. */
+    template <size_t size>
+    void setText(char (&field)[size], const juce::String& text)
+    {
+        auto* utf8 = text.toRawUTF8();
+        auto length = juce::jmin(size, text.getNumBytesAsUTF8());
+
+        if (length < text.getNumBytesAsUTF8())
+            while (length > 0 && (utf8[length] & 0xc0) == 0x80)
+                --length;
+
+        std::memset(field, 0, size);
+        std::memcpy(field, utf8, length);
+    }
+
+    /* Escapes text for an element's content and encodes it as the document
+       is encoded. Fails if it has a character Latin-1 can't hold. */
+    bool encodeIxmlText(const juce::String& text, bool asUtf8, juce::MemoryBlock& result)
+    {
+        auto escaped = text.replace("&", "&amp;").replace("<", "&lt;").replace(">", "&gt;");
+
+        if (asUtf8)
+        {
+            result.replaceAll(escaped.toRawUTF8(), escaped.getNumBytesAsUTF8());
+            return true;
+        }
+
+        result.reset();
+
+        for (auto p = escaped.getCharPointer(); ! p.isEmpty();)
+        {
+            auto c = p.getAndAdvance();
+
+            if (c > 0xff)
+                return false;
+
+            auto byte = (juce::uint8) c;
+            result.append(&byte, 1);
+        }
+
+        return true;
+    }
+
+    const char* const emptyIxml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                                  "<BWFXML>\n"
+                                  "  <IXML_VERSION>1.61</IXML_VERSION>\n"
+                                  "</BWFXML>\n";
+}
+
+//==============================================================================
+juce::Result WavMetadataWriter::write(const juce::File& file, const WavMetadata& edited)
+{
+    Plan changes;
+    auto result = plan(file, edited, changes);
+
+    if (result.failed() || changes.isEmpty())
+        return result;
+
+    return apply(file, changes);
+}
+
+juce::Result WavMetadataWriter::plan(const juce::File& file, const WavMetadata& edited, Plan& result)
+{
+    result = {};
+
+    auto layout = readLayout(file);
+
+    if (layout.status.failed())
+        return layout.status;
+
+    result.originalLength = result.newLength = layout.length;
+    Planner planner(layout, result);
+
+    WavMetadata current;
+
+    if (layout.hasBext)
+        WavMetadataReader::decodeChunk(FourCC::bext, static_cast<const char*>(layout.bextPayload.getData()),
+                                       layout.bextPayload.getSize(), current);
+
+    if (layout.hasIxml)
+        WavMetadataReader::decodeChunk(FourCC::iXML, static_cast<const char*>(layout.ixmlPayload.getData()),
+                                       layout.ixmlPayload.getSize(), current);
+
+    // iXML first: it's usually the chunk at the end, so if bext has to move
+    // too it goes after it rather than the other way round.
+    const auto& oldIxml = current.ixml;
+    const auto& newIxml = edited.ixml;
+
+    if (oldIxml.project != newIxml.project || oldIxml.scene != newIxml.scene
+         || oldIxml.take != newIxml.take || oldIxml.tape != newIxml.tape)
+    {
+        auto* text = emptyIxml;
+        auto length = std::strlen(emptyIxml);
+
+        if (layout.hasIxml)
+        {
+            text = static_cast<const char*>(layout.ixmlPayload.getData());
+            auto* firstNull = static_cast<const char*>(std::memchr(text, 0, layout.ixmlPayload.getSize()));
+            length = firstNull != nullptr ? (size_t) (firstNull - text) : layout.ixmlPayload.getSize();
+        }
+
+        // Only the fields that changed are written, so the others keep
+        // however they were written (entities, CDATA and so on).
+        juce::StringPairArray fields;
+
+        if (oldIxml.project != newIxml.project)   fields.set("PROJECT", newIxml.project);
+        if (oldIxml.scene != newIxml.scene)       fields.set("SCENE", newIxml.scene);
+        if (oldIxml.take != newIxml.take)         fields.set("TAKE", newIxml.take);
+        if (oldIxml.tape != newIxml.tape)         fields.set("TAPE", newIxml.tape);
+
+        juce::MemoryBlock payload;
+        auto spliced = setIxmlFields(text, length, fields, payload);
+
+        if (spliced.failed())
+            return spliced;
+
+        auto planned = planner.replaceChunk(FourCC::iXML, payload);
+
+        if (planned.failed())
+            return planned;
+    }
+
+    const auto& oldBext = current.bext;
+    const auto& newBext = edited.bext;
+
+    if (oldBext.description != newBext.description || oldBext.originator != newBext.originator
+         || oldBext.originatorReference != newBext.originatorReference
+         || oldBext.originationDate != newBext.originationDate || oldBext.originationTime != newBext.originationTime
+         || oldBext.timeReference != newBext.timeReference)
+    {
+        auto payload = createBextPayload(newBext, layout.hasBext ? layout.bextPayload.getData() : nullptr,
+                                         layout.hasBext ? layout.bextPayload.getSize() : 0);
+
+        return planner.replaceChunk(FourCC::bext, payload);
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result WavMetadataWriter::replaceChunk(const juce::File& file, juce::uint32 tag, const juce::MemoryBlock& payload)
+{
+    auto layout = readLayout(file);
+
+    if (layout.status.failed())
+        return layout.status;
+
+    Plan changes;
+    changes.originalLength = changes.newLength = layout.length;
+
+    auto result = Planner(layout, changes).replaceChunk(tag, payload);
+
+    if (result.failed())
+        return result;
+
+    return apply(file, changes);
+}
+
+juce::Result WavMetadataWriter::apply(const juce::File& file, const Plan& changes)
+{
+    juce::FileOutputStream out(file);
+
+    if (! out.openedOk())
+        return juce::Result::fail("Could not open the file for writing.");
+
+    for (const auto& write : changes.writes)
+    {
+        if (! out.setPosition((juce::int64) write.offset) || ! out.write(write.data.getData(), write.data.getSize()))
+            return juce::Result::fail("Could not write to the file: " + out.getStatus().getErrorMessage());
+    }
+
+    out.flush();
+
+    if ((juce::uint64) file.getSize() > changes.newLength)
+    {
+        if (! out.setPosition((juce::int64) changes.newLength) || out.truncate().failed())
+            return juce::Result::fail("Could not change the length of the file.");
+    }
+
+    out.flush();
+
+    if (out.getStatus().failed())
+        return juce::Result::fail("Could not write to the file: " + out.getStatus().getErrorMessage());
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+juce::Result WavMetadataWriter::setIxmlFields(const char* xml, size_t numBytes, const juce::StringPairArray& fields,
+                                              juce::MemoryBlock& result)
+{
+    result.reset();
+
+    auto names = fields.getAllKeys();
+    auto values = fields.getAllValues();
+
+    IxmlStreamParser::RootChildren located;
+
+    if (! IxmlStreamParser::locateRootChildren(xml, numBytes, names, located))
+        return juce::Result::fail("The iXML chunk isn't well-formed XML, so it can't be edited safely.");
+
+    if (located.rootName != "BWFXML")
+        return juce::Result::fail("The iXML chunk has no BWFXML element to put the fields in.");
+
+    auto isUtf8 = XmlTextScanner::isValidUtf8(xml, numBytes);
+
+    // What replaces each range of the original, in the order they come in.
+    struct Splice
+    {
+        size_t start, end;
+        juce::MemoryBlock bytes;
+    };
+
+    juce::Array<Splice> splices;
+    juce::MemoryOutputStream added;
+
+    for (int i = 0; i < names.size(); ++i)
+    {
+        juce::MemoryBlock value;
+
+        if (! encodeIxmlText(values[i], isUtf8, value))
+            return juce::Result::fail("The iXML chunk isn't UTF-8, and the new " + names[i] + " has characters it can't hold.");
+
+        const auto& element = located.elements.getReference(i);
+        auto openTag = "<" + names[i] + ">";
+        auto closeTag = "</" + names[i] + ">";
+
+        if (element.found && ! element.selfClosing)
+        {
+            splices.add({ element.contentStart, element.contentEnd, value });
+        }
+        else if (element.found)
+        {
+            juce::MemoryOutputStream replacement;
+            replacement << openTag << value << closeTag;
+            splices.add({ element.start, element.end, replacement.getMemoryBlock() });
+        }
+        else if (value.getSize() > 0)
+        {
+            // On a line of its own just before </BWFXML>.
+            added << "  " << openTag << value << closeTag << "\n";
+        }
+    }
+
+    if (added.getDataSize() > 0)
+        splices.add({ located.rootEndTag, located.rootEndTag, added.getMemoryBlock() });
+
+    std::sort(splices.begin(), splices.end(), [](const Splice& a, const Splice& b) { return a.start < b.start; });
+
+    juce::MemoryOutputStream out(numBytes + 256);
+    size_t copied = 0;
+
+    for (const auto& splice : splices)
+    {
+        out.write(xml + copied, splice.start - copied);
+        out << splice.bytes;
+        copied = splice.end;
+    }
+
+    out.write(xml + copied, numBytes - copied);
+    result = out.getMemoryBlock();
+    return juce::Result::ok();
+}
+
+juce::MemoryBlock WavMetadataWriter::createBextPayload(const WavMetadata::Broadcast& bext, const void* existingPayload,
+                                                       size_t existingSize)
+{
+    juce::MemoryBlock payload(juce::jmax(sizeof(BextChunk::Layout), existingSize), true);
+
+    if (existingPayload != nullptr)
+        payload.copyFrom(existingPayload, 0, existingSize);
+
+    auto& layout = *static_cast<BextChunk::Layout*>(payload.getData());
+
+    setText(layout.description, bext.description);
+    setText(layout.originator, bext.originator);
+    setText(layout.originatorReference, bext.originatorReference);
+    setText(layout.originationDate, bext.originationDate);
+    setText(layout.originationTime, bext.originationTime);
+
+    auto timeReference = juce::ByteOrder::swapIfBigEndian((juce::uint64) bext.timeReference);
+    std::memcpy(layout.timeReference, &timeReference, sizeof(layout.timeReference));
+
+    return payload;
+}
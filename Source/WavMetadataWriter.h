@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    WavMetadataWriter.h
+
+    Writes edited bext and iXML fields back into a WAV file without copying
+    the audio. A chunk whose new payload fits in its old space, together
+    with any JUNK/FLLR/PAD padding straight after it, is rewritten where it
+    is and the rest of the space becomes padding. One that doesn't fit is
+    rewritten in place if it's the last chunk in the file, and otherwise the
+    old copy is turned into padding and the new one is appended. Either way
+    only the metadata chunks and a couple of headers are written, so saving
+    an edit costs kilobytes of I/O however big the file is. Only depends on
+    juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WavMetadata.h"
+
+//==============================================================================
+class WavMetadataWriter
+{
+public:
+    //==============================================================================
+    /* Writes the editable fields of the given metadata into the file: the bext
+       text fields and time reference, and the iXML PROJECT, SCENE, TAKE and
+       TAPE. Everything else in those chunks is kept as it was, and a chunk
+       whose fields haven't changed isn't touched. A chunk that's missing is
+       added if any of its fields has been set. */
+    static juce::Result write(const juce::File& file, const WavMetadata& edited);
+
+    /* Replaces the first chunk with the given tag (see FourCC.h), or appends
+       one if there's none, following the rules above. */
+    static juce::Result replaceChunk(const juce::File& file, juce::uint32 tag, const juce::MemoryBlock& payload);
+
+    //==============================================================================
+    /* The writes an edit comes down to, worked out before anything is written,
+       so that they can be journalled first. Writes are made in order, and the
+       file is then cut to its new length if it's got shorter. */
+    struct Plan
+    {
+        struct Write
+        {
+            juce::uint64 offset = 0;
+            juce::MemoryBlock data;
+        };
+
+        juce::Array<Write> writes;
+        juce::uint64 originalLength = 0;
+        juce::uint64 newLength = 0;
+
+        bool isEmpty() const noexcept       { return writes.isEmpty(); }
+    };
+
+    /* Works out what write() would do, without changing the file. An edit
+       that changes nothing gives an empty plan. */
+    static juce::Result plan(const juce::File& file, const WavMetadata& edited, Plan& result);
+
+    /* Makes a plan's writes. The file mustn't have changed since it was planned. */
+    static juce::Result apply(const juce::File& file, const Plan& changes);
+
+    //==============================================================================
+    /* Sets the text of top-level BWFXML elements (keys such as "SCENE") in an
+       iXML payload, adding any that aren't there. Every other byte is left
+       exactly as it was. The values go in in the document's own encoding:
+       UTF-8, or Latin-1 if it isn't valid UTF-8, as the reader takes it to
+       be. Fails if the payload isn't well-formed, has no BWFXML root, or a
+       value can't be written in its encoding. */
+    static juce::Result setIxmlFields(const char* xml, size_t numBytes, const juce::StringPairArray& fields,
+                                      juce::MemoryBlock& result);
+
+    /* A bext payload carrying the given fields, keeping everything else (the
+       UMID, loudness and coding history) from the existing payload if any. */
+    static juce::MemoryBlock createBextPayload(const WavMetadata::Broadcast& bext, const void* existingPayload = nullptr,
+                                               size_t existingSize = 0);
+
+private:
+    //==============================================================================
+    WavMetadataWriter() = delete;
+};
@@ -0,0 +1,409 @@
+/*
+  ==============================================================================
+
+    WaveformPeaks.cpp
+
+  ==============================================================================
+*/
+
+#include "WaveformPeaks.h"
+#include "ByteSource.h"
+#include "RiffChunkScanner.h"
+#include <numeric>
+
+// As in XmlTextScanner.cpp. The NEON path needs AArch64 for vminnmq/vmaxnmq,
+// which ignore NaNs the way the SSE and scalar code do.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define PEAKS_USE_SSE2 1
+ #include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+ #define PEAKS_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+namespace
+{
+    //==============================================================================
+    enum class SampleType
+    {
+        unsigned8,
+        signed16,
+        signed24,
+        signed32,
+        float32
+    };
+
+    bool getSampleType(const WavMetadata::Format& format, SampleType& type)
+    {
+        // Extensible files say what they hold in their sub-format.
+        auto sampleFormat = format.getSampleFormat();
+
+        if (sampleFormat == WavMetadata::Format::ieeeFloat)
+        {
+            type = SampleType::float32;
+            return format.bitsPerSample == 32;
+        }
+
+        if (sampleFormat != WavMetadata::Format::pcm)
+            return false;
+
+        switch (format.bitsPerSample)
+        {
+            case 8:     type = SampleType::unsigned8; return true;
+            case 16:    type = SampleType::signed16; return true;
+            case 24:    type = SampleType::signed24; return true;
+            case 32:    type = SampleType::signed32; return true;
+            default:    return false;
+        }
+    }
+
+    /* Converts little-endian samples to floats in -1..1. Each case is a plain
+       loop over contiguous memory, which the compiler vectorises. */
+    void convertToFloat(const char* source, float* dest, size_t numSamples, SampleType type) noexcept
+    {
+        auto* bytes = reinterpret_cast<const juce::uint8*>(source);
+
+        switch (type)
+        {
+            case SampleType::unsigned8:
+                for (size_t i = 0; i < numSamples; ++i)
+                    dest[i] = ((int) bytes[i] - 128) * (1.0f / 128.0f);
+                break;
+
+            case SampleType::signed16:
+                for (size_t i = 0; i < numSamples; ++i)
+                    dest[i] = (juce::int16) (bytes[i * 2] | (bytes[i * 2 + 1] << 8)) * (1.0f / 32768.0f);
+                break;
+
+            case SampleType::signed24:
+                for (size_t i = 0; i < numSamples; ++i)
+                    dest[i] = (juce::int32) (((juce::uint32) bytes[i * 3] << 8) | ((juce::uint32) bytes[i * 3 + 1] << 16)
+                                              | ((juce::uint32) bytes[i * 3 + 2] << 24)) * (1.0f / 2147483648.0f);
+                break;
+
+            case SampleType::signed32:
+                for (size_t i = 0; i < numSamples; ++i)
+                    dest[i] = (juce::int32) juce::ByteOrder::littleEndianInt(source + i * 4) * (1.0f / 2147483648.0f);
+                break;
+
+            case SampleType::float32:
+                for (size_t i = 0; i < numSamples; ++i)
+                {
+                    auto bits = juce::ByteOrder::littleEndianInt(source + i * 4);
+                    std::memcpy(dest + i, &bits, sizeof(float));
+                }
+                break;
+        }
+    }
+
+    //==============================================================================
+    // Floats per vector register, in every path.
+    constexpr int vectorWidth = 4;
+
+    /* Updates four lanes' running min and max with four samples. A NaN
+       sample leaves them as they were. */
+    inline void minMax4(const float* samples, float* lows, float* highs) noexcept
+    {
+       #if PEAKS_USE_SSE2
+        auto x = _mm_loadu_ps(samples);
+        // With a NaN, minps/maxps return their second operand.
+        _mm_storeu_ps(lows, _mm_min_ps(x, _mm_loadu_ps(lows)));
+        _mm_storeu_ps(highs, _mm_max_ps(x, _mm_loadu_ps(highs)));
+       #elif PEAKS_USE_NEON
+        auto x = vld1q_f32(samples);
+        vst1q_f32(lows, vminnmq_f32(x, vld1q_f32(lows)));
+        vst1q_f32(highs, vmaxnmq_f32(x, vld1q_f32(highs)));
+       #else
+        for (int j = 0; j < vectorWidth; ++j)
+        {
+            lows[j] = samples[j] < lows[j] ? samples[j] : lows[j];
+            highs[j] = samples[j] > highs[j] ? samples[j] : highs[j];
+        }
+       #endif
+    }
+
+    /*
+        Finds the min and max of each channel of interleaved samples. Rather
+        than striding through one channel at a time, the samples are taken as
+        rows of lanes, a whole number of frames and of vectors wide (at least
+        16), so each row is a straight run of vector min/max instructions
+        over contiguous memory. The lanes are folded back into channels at
+        the end of each bin.
+    */
+    class PeakAccumulator
+    {
+    public:
+        explicit PeakAccumulator(int channels)
+            : numChannels(channels),
+              numLanes(getNumLanes(channels)),
+              lows((size_t) numLanes),
+              highs((size_t) numLanes)
+        {
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            std::fill(lows.begin(), lows.end(), std::numeric_limits<float>::max());
+            std::fill(highs.begin(), highs.end(), std::numeric_limits<float>::lowest());
+            nextLane = 0;
+        }
+
+        void add(const float* samples, size_t numSamples) noexcept
+        {
+            auto* lo = lows.data();
+            auto* hi = highs.data();
+            auto lanes = (size_t) numLanes;
+
+            // Finish a row left part-filled by the last call.
+            while (nextLane != 0 && numSamples > 0)
+            {
+                addOne(*samples++, nextLane);
+                nextLane = (nextLane + 1) % numLanes;
+                --numSamples;
+            }
+
+            // Ran out before the row was.
+            if (nextLane != 0)
+                return;
+
+            for (; numSamples >= lanes; numSamples -= lanes, samples += lanes)
+                for (size_t j = 0; j < lanes; j += vectorWidth)
+                    minMax4(samples + j, lo + j, hi + j);
+
+            for (size_t i = 0; i < numSamples; ++i)
+                addOne(samples[i], (int) i);
+
+            nextLane = (int) numSamples;
+        }
+
+        /* Writes each channel's range as [min, max] pairs of bytes, then resets. */
+        void finishBin(juce::int8* dest) noexcept
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto low = 1.0f, high = -1.0f;
+
+                for (int lane = channel; lane < numLanes; lane += numChannels)
+                {
+                    low = juce::jmin(low, lows[(size_t) lane]);
+                    high = juce::jmax(high, highs[(size_t) lane]);
+                }
+
+                if (low > high)
+                    low = high = 0.0f;
+
+                dest[channel * 2] = toByte(low);
+                dest[channel * 2 + 1] = toByte(high);
+            }
+
+            reset();
+        }
+
+    private:
+        static int getNumLanes(int channels) noexcept
+        {
+            auto row = std::lcm(channels, vectorWidth);
+            return row * juce::jmax(1, (16 + row - 1) / row);
+        }
+
+        void addOne(float sample, int lane) noexcept
+        {
+            lows[(size_t) lane] = juce::jmin(lows[(size_t) lane], sample);
+            highs[(size_t) lane] = juce::jmax(highs[(size_t) lane], sample);
+        }
+
+        static juce::int8 toByte(float value) noexcept
+        {
+            return (juce::int8) juce::roundToInt(juce::jlimit(-1.0f, 1.0f, value) * 127.0f);
+        }
+
+        int numChannels, numLanes;
+        std::vector<float> lows, highs;
+        int nextLane = 0;
+    };
+
+    //==============================================================================
+    /* A run of consecutive bins, reduced by one thread. */
+    struct BinRun
+    {
+        int firstBin = 0;
+        int numBins = 0;
+    };
+
+    // Each read covers up to this many bytes of sample data.
+    constexpr size_t readSize = 1024 * 1024;
+}
+
+//==============================================================================
+juce::Result WaveformPeaks::build(const juce::File& file, const WavMetadata::Format& format, WaveformPeaks& result,
+                                  const std::function<bool()>& shouldCancel, int numBinsWanted)
+{
+    result = {};
+
+    SampleType type;
+
+    if (! format.found || format.numChannels <= 0 || ! getSampleType(format, type))
+        return juce::Result::fail("The sample format isn't one that can be drawn.");
+
+    // Find the data chunk; its header is usually in the head window already.
+    RiffChunkScanner::Chunk dataChunk;
+
+    {
+        WindowedFileSource source(file);
+        RiffChunkScanner scanner(source);
+
+        if (! scanner.findChunk(FourCC::data, dataChunk))
+            return juce::Result::fail("There's no audio data in this file.");
+    }
+
+    auto bytesPerSample = (size_t) format.bitsPerSample / 8;
+    auto bytesPerFrame = bytesPerSample * (size_t) format.numChannels;
+    auto numFrames = (juce::int64) (dataChunk.available / bytesPerFrame);
+    auto dataStart = (juce::int64) dataChunk.offset + 8;
+
+    auto numBins = (int) juce::jmin((juce::int64) juce::jmax(1, numBinsWanted), numFrames);
+
+    if (numBins == 0)
+        return juce::Result::ok();
+
+    result.numChannels = format.numChannels;
+    result.numBins = numBins;
+    result.peaks.insertMultiple(0, 0, numBins * format.numChannels * 2);
+
+    auto getBinStart = [numFrames, numBins](int bin) { return numFrames * bin / numBins; };
+
+    // At least a few bins per thread, else the threads cost more than they save.
+    auto numThreads = juce::jlimit(1, juce::SystemStats::getNumCpus(), numBins / 64);
+    auto binsPerThread = (numBins + numThreads - 1) / numThreads;
+
+    std::atomic<bool> failed { false }, cancelled { false };
+    std::atomic<int> runsLeft;
+    juce::WaitableEvent allFinished;
+
+    auto* peakData = result.peaks.getRawDataPointer();
+
+    auto reduceRun = [&](BinRun run)
+        {
+            juce::FileInputStream in(file);
+            PeakAccumulator accumulator(format.numChannels);
+
+            auto framesPerRead = juce::jmax((size_t) 1, readSize / bytesPerFrame);
+            juce::HeapBlock<char> raw(framesPerRead * bytesPerFrame);
+            juce::HeapBlock<float> samples(framesPerRead * (size_t) format.numChannels);
+
+            auto bin = run.firstBin;
+            auto endBin = run.firstBin + run.numBins;
+            auto frame = getBinStart(bin);
+            auto endFrame = getBinStart(endBin);
+
+            if (! in.openedOk() || ! in.setPosition(dataStart + frame * (juce::int64) bytesPerFrame))
+            {
+                failed = true;
+                return;
+            }
+
+            while (frame < endFrame)
+            {
+                if (failed || cancelled || (shouldCancel != nullptr && shouldCancel()))
+                {
+                    cancelled = true;
+                    return;
+                }
+
+                auto framesToRead = (size_t) juce::jmin((juce::int64) framesPerRead, endFrame - frame);
+                auto bytesToRead = framesToRead * bytesPerFrame;
+
+                if (in.read(raw, (int) bytesToRead) != (int) bytesToRead)
+                {
+                    failed = true;
+                    return;
+                }
+
+                convertToFloat(raw, samples, framesToRead * (size_t) format.numChannels, type);
+
+                // Hand the frames to the bins they belong to.
+                size_t used = 0;
+
+                while (used < framesToRead)
+                {
+                    auto binEnd = getBinStart(bin + 1);
+                    auto count = (size_t) juce::jmin((juce::int64) (framesToRead - used), binEnd - frame);
+
+                    accumulator.add(samples + used * (size_t) format.numChannels, count * (size_t) format.numChannels);
+                    used += count;
+                    frame += (juce::int64) count;
+
+                    if (frame == binEnd)
+                        accumulator.finishBin(peakData + (size_t) bin++ * (size_t) format.numChannels * 2);
+                }
+            }
+        };
+
+    juce::ThreadPool pool(numThreads);
+
+    // Counted up front, so an early finisher can't see zero before the rest are queued.
+    runsLeft = (numBins + binsPerThread - 1) / binsPerThread;
+
+    for (int first = 0; first < numBins; first += binsPerThread)
+    {
+        BinRun run { first, juce::jmin(binsPerThread, numBins - first) };
+
+        pool.addJob([&, run]
+            {
+                reduceRun(run);
+
+                if (--runsLeft == 0)
+                    allFinished.signal();
+            });
+    }
+
+    allFinished.wait();
+
+    if (cancelled || failed)
+    {
+        result = {};
+        return juce::Result::fail(failed ? "Could not read the audio data." : "Cancelled.");
+    }
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+juce::Range<float> WaveformPeaks::getRange(int channel, int bin) const noexcept
+{
+    if (! juce::isPositiveAndBelow(channel, numChannels) || ! juce::isPositiveAndBelow(bin, numBins))
+        return {};
+
+    auto index = (bin * numChannels + channel) * 2;
+    return { peaks[index] / 127.0f, peaks[index + 1] / 127.0f };
+}
+
+void WaveformPeaks::writeTo(juce::OutputStream& out) const
+{
+    out.writeInt(numChannels);
+    out.writeInt(numBins);
+    out.write(peaks.getRawDataPointer(), (size_t) peaks.size());
+}
+
+bool WaveformPeaks::readFrom(juce::InputStream& in)
+{
+    auto channels = in.readInt();
+    auto bins = in.readInt();
+
+    // Anything outside these limits didn't come from writeTo().
+    if (channels < 0 || channels > 1024 || bins < 0 || bins > 65536)
+        return false;
+
+    auto numBytes = channels * bins * 2;
+    juce::Array<juce::int8> loaded;
+    loaded.insertMultiple(0, 0, numBytes);
+
+    if (in.read(loaded.getRawDataPointer(), numBytes) != numBytes)
+        return false;
+
+    numChannels = channels;
+    numBins = bins;
+    peaks.swapWith(loaded);
+    return true;
+}
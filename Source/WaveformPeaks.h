@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    WaveformPeaks.h
+
+    A waveform overview of a WAV file: the lowest and highest sample of each
+    channel over a fixed number of bins spread evenly across the data chunk.
+    Enough to draw a thumbnail at any width. Built straight from the raw
+    samples using the fmt fields we've already parsed, so no audio decoder is
+    involved. Only depends on juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "WavMetadata.h"
+
+//==============================================================================
+class WaveformPeaks
+{
+public:
+    //==============================================================================
+    static constexpr int defaultNumBins = 2048;
+
+    WaveformPeaks() = default;
+
+    /* Reads the data chunk of a file with the given format and reduces it to
+       min/max pairs. The data is split into runs of bins that are read and
+       reduced on separate threads; the cancel callback is polled from those
+       threads between reads. Integer PCM of 8 to 32 bits and 32-bit float
+       are understood. */
+    static juce::Result build(const juce::File& file, const WavMetadata::Format& format, WaveformPeaks& result,
+                              const std::function<bool()>& shouldCancel = nullptr, int numBins = defaultNumBins);
+
+    //==============================================================================
+    bool isEmpty() const noexcept               { return numBins == 0; }
+    int getNumChannels() const noexcept         { return numChannels; }
+    int getNumBins() const noexcept             { return numBins; }
+
+    /* The range of one bin of a channel, scaled to -1..1. */
+    juce::Range<float> getRange(int channel, int bin) const noexcept;
+
+    //==============================================================================
+    /* Writes the peaks in a compact binary form that readFrom() understands. */
+    void writeTo(juce::OutputStream& out) const;
+
+    /* Restores peaks written by writeTo(), returning false if the data is bad. */
+    bool readFrom(juce::InputStream& in);
+
+private:
+    //==============================================================================
+    int numChannels = 0;
+    int numBins = 0;
+
+    // One byte per value is plenty for a thumbnail: [bin][channel][min, max].
+    juce::Array<juce::int8> peaks;
+};
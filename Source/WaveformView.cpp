@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    WaveformView.cpp
+
+  ==============================================================================
+*/
+
+#include "WaveformView.h"
+
+//==============================================================================
+/* Looks a file's peaks up in the cache, or builds and caches them. */
+class WaveformView::LoadJob : public juce::ThreadPoolJob
+{
+public:
+    LoadJob(WaveformView& viewToNotify, int requestNumber, const juce::File& fileToLoad, const WavMetadata::Format& fileFormat)
+        : juce::ThreadPoolJob("Waveform peaks"),
+          view(&viewToNotify),
+          peakCache(viewToNotify.peakCache),
+          request(requestNumber),
+          file(fileToLoad),
+          format(fileFormat)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        WaveformPeaks peaks;
+        juce::String error;
+
+        if (! peakCache.lookup(file, peaks))
+        {
+            auto result = WaveformPeaks::build(file, format, peaks, [this] { return shouldExit(); });
+
+            if (shouldExit())
+                return jobHasFinished;
+
+            if (result.wasOk())
+                peakCache.store(file, peaks);
+            else
+                error = result.getErrorMessage();
+        }
+
+        juce::MessageManager::callAsync([safeView = view, request = request, peaks, error]
+            {
+                if (safeView != nullptr)
+                    safeView->handleLoaded(request, peaks, error);
+            });
+
+        return jobHasFinished;
+    }
+
+    const juce::File& getFile() const noexcept      { return file; }
+
+private:
+    juce::Component::SafePointer<WaveformView> view;
+    const PeakCache& peakCache;     // The view's pool stops us before the cache is destroyed.
+    int request;
+    juce::File file;
+    WavMetadata::Format format;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoadJob)
+};
+
+//==============================================================================
+WaveformView::~WaveformView()
+{
+    pool.removeAllJobs(true, 10000);
+}
+
+void WaveformView::showFile(const juce::File& file, const WavMetadata::Format& format)
+{
+    if (file == currentFile)
+        return;
+
+    clear();
+    currentFile = file;
+    message = "Reading waveform...";
+
+    pool.addJob(new LoadJob(*this, currentRequest, file, format), true);
+}
+
+void WaveformView::clear()
+{
+    // Any job for the previous file stops at its next read.
+    pool.removeAllJobs(true, 0);
+    ++currentRequest;
+
+    currentFile = juce::File();
+    peaks = {};
+    message.clear();
+    repaint();
+}
+
+void WaveformView::stopReading(const juce::File& file)
+{
+    if (file == currentFile)
+        clear();
+
+    // A job that clear() abandoned earlier may still be finishing a read of it.
+    struct IsReadingFile : public juce::ThreadPool::JobSelector
+    {
+        explicit IsReadingFile(const juce::File& f) : file(f) {}
+
+        bool isJobSuitable(juce::ThreadPoolJob* job) override
+        {
+            return static_cast<LoadJob*>(job)->getFile() == file;
+        }
+
+        juce::File file;
+    };
+
+    IsReadingFile isReadingFile(file);
+    pool.removeAllJobs(true, 10000, &isReadingFile);
+}
+
+void WaveformView::handleLoaded(int request, const WaveformPeaks& newPeaks, const juce::String& error)
+{
+    if (request != currentRequest)
+        return;
+
+    peaks = newPeaks;
+    message = error;
+    repaint();
+}
+
+//==============================================================================
+void WaveformView::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::darkgrey.darker().darker());
+
+    if (peaks.isEmpty())
+    {
+        g.setColour(juce::Colours::grey);
+        g.setFont(juce::Font(juce::FontOptions(13.0f)));
+        g.drawText(message, getLocalBounds().reduced(6, 0), juce::Justification::centredLeft, true);
+        return;
+    }
+
+    // Each channel gets a lane of its own, with each pixel column covering
+    // the bins under it.
+    auto numChannels = peaks.getNumChannels();
+    auto numBins = peaks.getNumBins();
+    auto width = getWidth();
+    auto laneHeight = (float) getHeight() / (float) numChannels;
+
+    g.setColour(juce::Colours::lightgoldenrodyellow.withAlpha(0.8f));
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto centre = laneHeight * ((float) channel + 0.5f);
+        auto halfHeight = laneHeight * 0.45f;
+
+        for (int x = 0; x < width; ++x)
+        {
+            auto firstBin = (int) ((juce::int64) x * numBins / width);
+            auto endBin = juce::jmax(firstBin + 1, (int) ((juce::int64) (x + 1) * numBins / width));
+
+            auto range = peaks.getRange(channel, firstBin);
+
+            for (int bin = firstBin + 1; bin < endBin; ++bin)
+                range = range.getUnionWith(peaks.getRange(channel, bin));
+
+            g.drawVerticalLine(x, centre - range.getEnd() * halfHeight, centre - range.getStart() * halfHeight + 1.0f);
+        }
+    }
+}
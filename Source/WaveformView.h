@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    WaveformView.h
+
+    A waveform thumbnail of the selected file, drawn from its peaks. The
+    peaks come from the peak cache when they're there, and are otherwise
+    built from the audio in the background and cached for next time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "WaveformPeaks.h"
+#include "PeakCache.h"
+
+//==============================================================================
+class WaveformView : public juce::Component
+{
+public:
+    //==============================================================================
+    WaveformView() = default;
+    ~WaveformView() override;
+
+    /* Shows the waveform of a file with the given format, abandoning any
+       other file's waveform that's still being built. */
+    void showFile(const juce::File& file, const WavMetadata::Format& format);
+
+    /* Shows nothing. */
+    void clear();
+
+    /* Stops showing a file, if it's the one shown, and waits for any job
+       still reading its audio to stop, e.g. before the file is rewritten. */
+    void stopReading(const juce::File& file);
+
+    //==============================================================================
+    void paint(juce::Graphics& g) override;
+
+private:
+    //==============================================================================
+    class LoadJob;
+
+    void handleLoaded(int request, const WaveformPeaks& newPeaks, const juce::String& error);
+
+    PeakCache peakCache;
+    juce::File currentFile;
+    WaveformPeaks peaks;
+    juce::String message;
+    int currentRequest = 0;     // Bumped per file, so stale results are dropped.
+
+    // Declared last so its jobs are stopped before the cache goes away.
+    juce::ThreadPool pool { 1 };
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformView)
+};
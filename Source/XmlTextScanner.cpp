@@ -0,0 +1,261 @@
+/*
+  ==============================================================================
+
+    XmlTextScanner.cpp
+
+  ==============================================================================
+*/
+
+#include "XmlTextScanner.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define XML_SCAN_USE_SSE2 1
+ #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+ #define XML_SCAN_USE_NEON 1
+ #include <arm_neon.h>
+#endif
+
+#if JUCE_MSVC
+ #include <intrin.h>
+#endif
+
+namespace
+{
+    //==============================================================================
+    constexpr size_t blockSize = 16;
+
+    /* Which bytes of a block are markup, null, or not ASCII. A byte's flag is
+       the bit at its index times bitsPerByte. */
+    struct BlockMasks
+    {
+        juce::uint64 markup, nulls, nonAscii;
+    };
+
+   #if XML_SCAN_USE_SSE2
+    constexpr int bitsPerByte = 1;
+
+    BlockMasks classify(const char* block) noexcept
+    {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+
+        auto markup = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('<')),
+                                   _mm_cmpeq_epi8(bytes, _mm_set1_epi8('>')));
+        auto nulls = _mm_cmpeq_epi8(bytes, _mm_setzero_si128());
+
+        // movemask picks up the top bit of each byte, which is the non-ASCII flag as it is.
+        return { (juce::uint64) _mm_movemask_epi8(markup),
+                 (juce::uint64) _mm_movemask_epi8(nulls),
+                 (juce::uint64) _mm_movemask_epi8(bytes) };
+    }
+   #elif XML_SCAN_USE_NEON
+    // NEON has no movemask; narrowing each 16-bit lane by 4 leaves a nibble
+    // per byte, of which only the top bit is kept.
+    constexpr int bitsPerByte = 4;
+
+    juce::uint64 toMask(uint8x16_t flags) noexcept
+    {
+        auto nibbles = vshrn_n_u16(vreinterpretq_u16_u8(flags), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ull;
+    }
+
+    BlockMasks classify(const char* block) noexcept
+    {
+        auto bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(block));
+
+        auto markup = vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('<')), vceqq_u8(bytes, vdupq_n_u8('>')));
+        auto nulls = vceqq_u8(bytes, vdupq_n_u8(0));
+        auto nonAscii = vcgeq_u8(bytes, vdupq_n_u8(0x80));
+
+        return { toMask(markup), toMask(nulls), toMask(nonAscii) };
+    }
+   #else
+    constexpr int bitsPerByte = 1;
+
+    BlockMasks classify(const char* block) noexcept
+    {
+        BlockMasks masks { 0, 0, 0 };
+
+        for (size_t i = 0; i < blockSize; ++i)
+        {
+            auto c = (unsigned char) block[i];
+            auto bit = (juce::uint64) 1 << i;
+
+            if (c == '<' || c == '>')   masks.markup |= bit;
+            if (c == 0)                 masks.nulls |= bit;
+            if (c >= 0x80)              masks.nonAscii |= bit;
+        }
+
+        return masks;
+    }
+   #endif
+
+    int lowestSetBit(juce::uint64 mask) noexcept
+    {
+        jassert(mask != 0);
+
+       #if JUCE_MSVC
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return (int) index;
+       #else
+        return __builtin_ctzll(mask);
+       #endif
+    }
+
+    /* The flags of the first numBytes bytes of a block. */
+    juce::uint64 bytesBelow(size_t numBytes) noexcept
+    {
+        auto numBits = numBytes * bitsPerByte;
+        return numBits >= 64 ? ~(juce::uint64) 0 : ((juce::uint64) 1 << numBits) - 1;
+    }
+
+    //==============================================================================
+    /* Checks UTF-8 a byte at a time, following table 3-7 of the Unicode
+       standard, so overlong forms, surrogates and code points past U+10FFFF
+       are all rejected. The state carries across blocks. */
+    struct Utf8Validator
+    {
+        bool isValid = true;
+
+        void process(const char* bytes, size_t numBytes) noexcept
+        {
+            for (size_t i = 0; i < numBytes && isValid; ++i)
+                processByte((unsigned char) bytes[i]);
+        }
+
+        bool isMidCharacter() const noexcept    { return continuationBytes > 0; }
+
+        /* Call at the end, to catch a character that's been cut off. */
+        bool finish() noexcept
+        {
+            isValid = isValid && ! isMidCharacter();
+            return isValid;
+        }
+
+    private:
+        void processByte(unsigned char c) noexcept
+        {
+            if (continuationBytes > 0)
+            {
+                if (c < lowest || c > highest)
+                {
+                    isValid = false;
+                    return;
+                }
+
+                lowest = 0x80;
+                highest = 0xbf;
+                --continuationBytes;
+                return;
+            }
+
+            if (c < 0x80)
+                return;
+
+            lowest = 0x80;
+            highest = 0xbf;
+
+            if (c >= 0xc2 && c <= 0xdf)         continuationBytes = 1;
+            else if (c == 0xe0)                 { continuationBytes = 2; lowest = 0xa0; }
+            else if (c == 0xed)                 { continuationBytes = 2; highest = 0x9f; }
+            else if (c >= 0xe1 && c <= 0xef)    continuationBytes = 2;
+            else if (c == 0xf0)                 { continuationBytes = 3; lowest = 0x90; }
+            else if (c >= 0xf1 && c <= 0xf3)    continuationBytes = 3;
+            else if (c == 0xf4)                 { continuationBytes = 3; highest = 0x8f; }
+            else                                isValid = false;
+        }
+
+        int continuationBytes = 0;
+        unsigned char lowest = 0x80, highest = 0xbf;
+    };
+
+    //==============================================================================
+    /* The single pass. Without an index this only validates, and carries on
+       through nulls rather than stopping at the first. */
+    XmlTextScanner::Result scanText(const char* data, size_t numBytes, ParseArena::Buffer* index)
+    {
+        XmlTextScanner::Result result;
+        Utf8Validator validator;
+        size_t offset = 0;
+
+        while (offset < numBytes)
+        {
+            auto numInBlock = juce::jmin(blockSize, numBytes - offset);
+            const char* block = data + offset;
+
+            // The last few bytes are copied out so the loads don't go past the
+            // end; spaces are none of the things being looked for.
+            char lastBlock[blockSize];
+
+            if (numInBlock < blockSize)
+            {
+                std::memset(lastBlock, ' ', blockSize);
+                std::memcpy(lastBlock, block, numInBlock);
+                block = lastBlock;
+            }
+
+            auto masks = classify(block);
+            auto numToUse = numInBlock;
+
+            if (index != nullptr && masks.nulls != 0)
+                numToUse = juce::jmin(numToUse, (size_t) (lowestSetBit(masks.nulls) / bitsPerByte));
+
+            auto used = bytesBelow(numToUse);
+
+            // All-ASCII blocks are valid whatever's in them, unless a character
+            // from the one before is still waiting for its continuation bytes.
+            if ((masks.nonAscii & used) != 0 || validator.isMidCharacter())
+                validator.process(block, numToUse);
+
+            if (index != nullptr)
+            {
+                for (auto markup = masks.markup & used; markup != 0; markup &= markup - 1)
+                {
+                    auto position = (juce::uint32) (offset + (size_t) (lowestSetBit(markup) / bitsPerByte));
+                    index->write(&position, sizeof(position));
+                }
+            }
+
+            offset += numToUse;
+
+            if (numToUse < numInBlock)
+                break;
+        }
+
+        result.documentLength = offset;
+        result.isValidUtf8 = validator.finish();
+
+        if (index != nullptr)
+        {
+            result.markup = reinterpret_cast<const juce::uint32*>(index->getData());
+            result.numMarkup = index->getSize() / sizeof(juce::uint32);
+        }
+
+        return result;
+    }
+}
+
+//==============================================================================
+XmlTextScanner::Result XmlTextScanner::scan(const char* data, size_t numBytes, ParseArena& arena)
+{
+    jassert(numBytes <= std::numeric_limits<juce::uint32>::max());
+
+    // Tags rarely come closer together than every 16 bytes or so.
+    ParseArena::Buffer index(arena, juce::jmax((size_t) 64, numBytes / 4), alignof(juce::uint32));
+    return scanText(data, numBytes, &index);
+}
+
+bool XmlTextScanner::isValidUtf8(const char* data, size_t numBytes) noexcept
+{
+    return scanText(data, numBytes, nullptr).isValidUtf8;
+}
+
+bool XmlTextScanner::isVectorised() noexcept
+{
+   #if XML_SCAN_USE_SSE2 || XML_SCAN_USE_NEON
+    return true;
+   #else
+    return false;
+   #endif
+}
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    XmlTextScanner.h
+
+    One pass over a raw iXML payload before it's tokenized. The pass finds
+    where the document ends, checks that the text is valid UTF-8, and indexes
+    every '<' and '>'. The tokenizer then jumps between tags using the index
+    rather than searching the text again.
+
+    Sixteen bytes are looked at at a time, with SSE2 or NEON where the target
+    has them and plain C++ otherwise. A block that's all ASCII costs a few
+    compares, whatever's in it. Only blocks holding multi-byte characters
+    are validated byte by byte. Only depends on juce_core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "ParseArena.h"
+
+//==============================================================================
+class XmlTextScanner
+{
+public:
+    //==============================================================================
+    struct Result
+    {
+        // Up to the first null, as chunks are often padded with them.
+        size_t documentLength = 0;
+
+        // Whether the bytes up to documentLength are well-formed UTF-8.
+        bool isValidUtf8 = true;
+
+        // The offsets of every '<' and '>' before documentLength, in order.
+        const juce::uint32* markup = nullptr;
+        size_t numMarkup = 0;
+    };
+
+    /* Scans a payload of up to 4 GB. The index is allocated in the arena. */
+    static Result scan(const char* data, size_t numBytes, ParseArena& arena);
+
+    /* Just the UTF-8 check, over every byte given, nulls included. */
+    static bool isValidUtf8(const char* data, size_t numBytes) noexcept;
+
+    /* True if this build uses SSE2 or NEON, rather than the plain C++ version. */
+    static bool isVectorised() noexcept;
+
+private:
+    //==============================================================================
+    XmlTextScanner() = delete;
+};